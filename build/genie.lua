@@ -834,6 +834,37 @@ if (WITH_TOOLS == 1) then
 		targetname "sanity"
 end
 
+-- 8< -- 8< -- 8< -- 8< -- 8< -- 8< -- 8< -- 8< -- 8< -- 8< --
+if (WITH_TOOLS == 1) then
+
+	project "soloud_bench"
+		kind "ConsoleApp"
+		language "C++"
+		includedirs {
+		  "../include"
+		}
+		files {
+		  "../src/tools/bench/**.cpp"
+		}
+		if (WITH_ALSA == 1) then
+			links {"asound"}
+		end
+		if (WITH_JACK == 1) then
+			links { "jack" }
+		end
+		if (WITH_COREAUDIO == 1) then
+			links {"AudioToolbox.framework"}
+		end
+
+		links {"SoloudStatic"}
+		if (not os.is("windows")) then
+		  links { "pthread" }
+		  links { "dl" }
+		end
+
+		targetname "soloud_bench"
+end
+
 -- 8< -- 8< -- 8< -- 8< -- 8< -- 8< -- 8< -- 8< -- 8< -- 8< --
 if (WITH_TOOLS == 1) then
 
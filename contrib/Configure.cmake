@@ -14,9 +14,15 @@ print_option_status (SOLOUD_C_API "Build C API")
 option (SOLOUD_BUILD_DEMOS "Set to ON for building demos" OFF)
 print_option_status (SOLOUD_BUILD_DEMOS "Build demos")
 
+option (SOLOUD_BUILD_BENCH "Set to ON for building the soloud_bench benchmark" OFF)
+print_option_status (SOLOUD_BUILD_BENCH "Build benchmark")
+
 option (SOLOUD_BACKEND_NULL "Set to ON for building NULL backend" ON)
 print_option_status (SOLOUD_BACKEND_NULL "NULL backend")
 
+option (SOLOUD_BACKEND_NOSOUND "Set to ON for building nosound backend" OFF)
+print_option_status (SOLOUD_BACKEND_NOSOUND "nosound backend")
+
 option (SOLOUD_BACKEND_SDL2 "Set to ON for building SDL2 backend" ON)
 print_option_status (SOLOUD_BACKEND_SDL2 "SDL2 backend")
 
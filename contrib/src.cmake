@@ -8,13 +8,16 @@ set (LINK_LIBRARIES)
 # Headers
 set (TARGET_HEADERS
 	${HEADER_PATH}/soloud.h
+	${HEADER_PATH}/soloud_audioinput.h
 	${HEADER_PATH}/soloud_audiosource.h
 	${HEADER_PATH}/soloud_ay.h
 	${HEADER_PATH}/soloud_bassboostfilter.h
 	${HEADER_PATH}/soloud_biquadresonantfilter.h
 	${HEADER_PATH}/soloud_bus.h
 	${HEADER_PATH}/soloud_dcremovalfilter.h
+	${HEADER_PATH}/soloud_duckfilter.h
 	${HEADER_PATH}/soloud_echofilter.h
+	${HEADER_PATH}/soloud_eqfilter.h
 	${HEADER_PATH}/soloud_error.h
 	${HEADER_PATH}/soloud_fader.h
 	${HEADER_PATH}/soloud_fft.h
@@ -26,11 +29,15 @@ set (TARGET_HEADERS
 	${HEADER_PATH}/soloud_flangerfilter.h
 	${HEADER_PATH}/soloud_freeverbfilter.h
 	${HEADER_PATH}/soloud_internal.h
+	${HEADER_PATH}/soloud_limiterfilter.h
 	${HEADER_PATH}/soloud_lofifilter.h
 	${HEADER_PATH}/soloud_misc.h
 	${HEADER_PATH}/soloud_monotone.h
+	${HEADER_PATH}/soloud_multibandcompressorfilter.h
 	${HEADER_PATH}/soloud_noise.h
+	${HEADER_PATH}/soloud_offline.h
 	${HEADER_PATH}/soloud_openmpt.h
+	${HEADER_PATH}/soloud_pcmstream.h
 	${HEADER_PATH}/soloud_queue.h
 	${HEADER_PATH}/soloud_robotizefilter.h
 	${HEADER_PATH}/soloud_sfxr.h
@@ -49,8 +56,10 @@ set (TARGET_HEADERS
 set (CORE_PATH ${SOURCE_PATH}/core)
 set (CORE_SOURCES
 	${CORE_PATH}/soloud.cpp
+	${CORE_PATH}/soloud_audioinput.cpp
 	${CORE_PATH}/soloud_audiosource.cpp
 	${CORE_PATH}/soloud_bus.cpp
+	${CORE_PATH}/soloud_clip.cpp
 	${CORE_PATH}/soloud_core_3d.cpp
 	${CORE_PATH}/soloud_core_basicops.cpp
 	${CORE_PATH}/soloud_core_faderops.cpp
@@ -65,6 +74,8 @@ set (CORE_SOURCES
 	${CORE_PATH}/soloud_file.cpp
 	${CORE_PATH}/soloud_filter.cpp
 	${CORE_PATH}/soloud_misc.cpp
+	${CORE_PATH}/soloud_offline.cpp
+	${CORE_PATH}/soloud_profile.cpp
 	${CORE_PATH}/soloud_queue.cpp
 	${CORE_PATH}/soloud_thread.cpp
 )
@@ -95,6 +106,9 @@ set (AUDIOSOURCES_SOURCES
 	${AUDIOSOURCES_PATH}/openmpt/soloud_openmpt.cpp
 	${AUDIOSOURCES_PATH}/openmpt/soloud_openmpt_dll.c
 
+	# pcmstream
+	${AUDIOSOURCES_PATH}/pcmstream/soloud_pcmstream.cpp
+
 	# sfxr
 	${AUDIOSOURCES_PATH}/sfxr/soloud_sfxr.cpp
 
@@ -148,6 +162,14 @@ if (SOLOUD_BACKEND_NULL)
 	add_definitions(-DWITH_NULL)
 endif()
 
+if (SOLOUD_BACKEND_NOSOUND)
+	set (BACKENDS_SOURCES
+		${BACKENDS_SOURCES}
+		${BACKENDS_PATH}/nosound/soloud_nosound.cpp
+	)
+	add_definitions(-DWITH_NOSOUND)
+endif()
+
 if (SOLOUD_BACKEND_SDL2)
 	find_package (SDL2 REQUIRED)
 	include_directories (${SDL2_INCLUDE_DIR})
@@ -250,11 +272,15 @@ set (FILTERS_SOURCES
 	${FILTERS_PATH}/soloud_bassboostfilter.cpp
 	${FILTERS_PATH}/soloud_biquadresonantfilter.cpp
 	${FILTERS_PATH}/soloud_dcremovalfilter.cpp
+	${FILTERS_PATH}/soloud_duckfilter.cpp
 	${FILTERS_PATH}/soloud_echofilter.cpp
+	${FILTERS_PATH}/soloud_eqfilter.cpp
 	${FILTERS_PATH}/soloud_fftfilter.cpp
 	${FILTERS_PATH}/soloud_flangerfilter.cpp
 	${FILTERS_PATH}/soloud_freeverbfilter.cpp
+	${FILTERS_PATH}/soloud_limiterfilter.cpp
 	${FILTERS_PATH}/soloud_lofifilter.cpp
+	${FILTERS_PATH}/soloud_multibandcompressorfilter.cpp
 	${FILTERS_PATH}/soloud_robotizefilter.cpp
 	${FILTERS_PATH}/soloud_waveshaperfilter.cpp
 )
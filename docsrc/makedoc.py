@@ -60,9 +60,13 @@ src = [
     "bassboostfilter.mmd",
     "waveshaperfilter.mmd",
     "robotizefilter.mmd",
+    "limiterfilter.mmd",
+    "multibandcompressorfilter.mmd",
     "freeverbfilter.mmd",
     "mixbus.mmd",
     "queue.mmd",
+    "pcmstream.mmd",
+    "audioinput.mmd",
     "collider.mmd",
     "attenuator.mmd",
     "file.mmd",
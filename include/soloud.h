@@ -70,6 +70,12 @@ freely, subject to the following restrictions:
 #if !defined(DISABLE_SIMD)
 #if defined(__x86_64__) || defined( _M_X64 ) || defined( __i386 ) || defined( _M_IX86 )
 #define SOLOUD_SSE_INTRINSICS
+#if !defined(DISABLE_AVX2) && (defined(__GNUC__) || (defined(_MSC_VER) && _MSC_VER >= 1700))
+#define SOLOUD_AVX2_INTRINSICS
+#endif
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define SOLOUD_NEON_INTRINSICS
 #endif
 #endif
 
@@ -82,15 +88,33 @@ freely, subject to the following restrictions:
 // Maximum number of filters per stream
 #define FILTERS_PER_STREAM 8
 
+// Maximum number of aux sends per voice
+#define SENDS_PER_VOICE 4
+
 // Number of samples to process on one go
 #define SAMPLE_GRANULARITY 512
 
+// Number of samples between filter parameter updates while a parameter is being smoothed
+#define FILTER_SMOOTHING_STEP 16
+
+// Maximum number of pending clocked parameter changes per filter instance
+#define FILTER_EVENT_COUNT 16
+
 // Maximum number of concurrent voices (hard limit is 4095)
 #define VOICE_COUNT 1024
 
 // 1)mono, 2)stereo 4)quad 6)5.1 8)7.1
 #define MAX_CHANNELS 8
 
+// Number of voice categories for setCategoryLimit; category 0 is never limited
+#define VOICE_CATEGORY_COUNT 32
+
+// Number of mix calls kept in the profiler ring (see Soloud::getProfileFrames)
+#define PROFILE_FRAMES 128
+
+// Number of audio sources the profiler can keep separate cost totals for
+#define SOURCE_COST_SLOTS 256
+
 // Default resampler for both main and bus mixers
 #define SOLOUD_DEFAULT_RESAMPLER SoLoud::Soloud::RESAMPLER_LINEAR
 
@@ -152,6 +176,129 @@ namespace SoLoud
 
 namespace SoLoud
 {
+	class OfflineSink;
+	struct InitConfig;
+
+	// Scheduling hints for threads created by SoLoud. Anything the
+	// platform or the user's privileges don't allow is silently skipped.
+	struct ThreadAttributes
+	{
+		enum PRIORITY
+		{
+			// Leave scheduling as the platform creates threads
+			PRIORITY_DEFAULT = 0,
+			// Regular time-sharing scheduling
+			PRIORITY_NORMAL,
+			// Realtime, first-in first-out
+			PRIORITY_FIFO,
+			// Realtime, round-robin
+			PRIORITY_RR
+		};
+
+		// One of PRIORITY
+		unsigned int mPriority;
+		// Realtime priority level for FIFO/RR; 0 picks a sensible default
+		int mRealtimePriority;
+		// Bit n allows running on CPU n; 0 leaves affinity alone
+		unsigned long long mAffinityMask;
+		// Stack size in bytes; 0 uses the platform default
+		unsigned int mStackSize;
+		// Thread name shown in debuggers and profilers; may be truncated
+		const char *mName;
+
+		ThreadAttributes();
+	};
+
+	// Profiler record for one mix call. Stage times are exclusive: time spent
+	// mixing a bus is not counted again in the getAudio stage of the bus voice.
+	struct ProfileFrame
+	{
+		enum STAGE
+		{
+			// Faders and schedulers
+			FADERS = 0,
+			// calcActiveVoices_internal
+			ACTIVE_VOICES,
+			// Audio source getAudio calls
+			GETAUDIO,
+			// Resampling
+			RESAMPLE,
+			// Per-voice filters
+			VOICE_FILTERS,
+			// Panning and channel expansion
+			PAN,
+			// Filters on bus voices
+			BUS_FILTERS,
+			// Global filters
+			GLOBAL_FILTERS,
+			// Clipping and output conversion
+			CLIP,
+			// Everything else, including waiting for the audio mutex
+			OTHER,
+			STAGE_COUNT
+		};
+
+		// Nanoseconds spent per stage
+		long long mStageNanos[STAGE_COUNT];
+		// Nanoseconds for the whole mix call
+		long long mTotalNanos;
+		// Sample frames mixed
+		unsigned int mSamples;
+		// Voices that were actually mixed
+		unsigned int mVoicesMixed;
+		// Playing voices that weren't mixed (inaudible, or over the active voice limit)
+		unsigned int mVoicesVirtual;
+		// Backend xruns reported since the previous frame
+		unsigned int mUnderruns;
+		// Mix time divided by the play time of the mixed samples
+		float mDutyCycle;
+	};
+
+	// Aggregates over the frames in the profiler ring
+	struct ProfileStats
+	{
+		// Number of frames aggregated
+		unsigned int mFrames;
+		// Frames recorded since profiling was enabled
+		unsigned int mTotalFrames;
+		double mAverageNanos[ProfileFrame::STAGE_COUNT];
+		long long mMaxNanos[ProfileFrame::STAGE_COUNT];
+		double mAverageTotalNanos;
+		long long mMaxTotalNanos;
+		float mAverageVoicesMixed;
+		unsigned int mMaxVoicesMixed;
+		float mAverageVoicesVirtual;
+		unsigned int mMaxVoicesVirtual;
+		// Xruns within the aggregated frames
+		unsigned int mUnderruns;
+		float mAverageDutyCycle;
+		float mMaxDutyCycle;
+	};
+
+	// CPU time charged to one audio source; see Soloud::getSourceCosts
+	struct SourceCost
+	{
+		// AudioSource::mAudioSourceID of the source
+		unsigned int mAudioSourceID;
+		// Nanoseconds in getAudio and filters. For buses, voices playing on the bus are not included.
+		long long mNanos;
+		// Number of times a voice of this source was mixed
+		unsigned int mMixes;
+	};
+
+	// Levels of a metered voice; see Soloud::getVoiceMeter
+	struct VoiceMeter
+	{
+		// Peak envelope per voice channel, after the voice volume and before panning
+		float mPeak[MAX_CHANNELS];
+		// RMS envelope per voice channel, over about 300ms
+		float mRMS[MAX_CHANNELS];
+		// Number of channels the voice has
+		unsigned int mChannels;
+	};
+
+	struct CostTraceEvent;
+	struct VoiceMeterSlot;
 
 	// Soloud core class.
 	class Soloud
@@ -203,7 +350,15 @@ namespace SoLoud
 			CLIP_ROUNDOFF = 1,
 			ENABLE_VISUALIZATION = 2,
 			LEFT_HANDED_3D = 4,
-			NO_FPU_REGISTER_CHANGE = 8
+			NO_FPU_REGISTER_CHANGE = 8,
+			// Add TPDF dither when converting to 16-bit output
+			TPDF_DITHER = 16,
+			// Don't mix in real time; the application advances time with stepVirtualClock(). Nosound and null driver only.
+			VIRTUAL_CLOCK = 32,
+			// Time the mixer stages; see getProfileStats()
+			ENABLE_PROFILING = 64,
+			// Open the input device too, for AudioInput. Miniaudio and null driver only.
+			ENABLE_CAPTURE = 128
 		};
 
 		enum WAVEFORM
@@ -228,6 +383,8 @@ namespace SoLoud
 
 		// Initialize SoLoud. Must be called before SoLoud can be used.
 		result init(unsigned int aFlags = Soloud::CLIP_ROUNDOFF, unsigned int aBackend = Soloud::AUTO, unsigned int aSamplerate = Soloud::AUTO, unsigned int aBufferSize = Soloud::AUTO, unsigned int aChannels = 2);
+		// Initialize SoLoud with a configuration struct, which also carries the mixer thread attributes.
+		result init(const InitConfig &aConfig);
 
 		result pause();
 		result resume();
@@ -251,6 +408,28 @@ namespace SoLoud
 		unsigned int getBackendSamplerate();
 		// Returns current backend buffer size
 		unsigned int getBackendBufferSize();
+		// Returns number of channels captured for AudioInput, 0 if there's no capture path
+		unsigned int getCaptureChannels();
+		// Returns number of buffer under/overruns the backend has reported since init. Not all backends report these.
+		unsigned int getBackendXrunCount();
+		// Returns average lateness of backend wakeups, in seconds. Only reported by backends that pace themselves (nosound).
+		time getBackendJitterAverage();
+		// Returns worst lateness of backend wakeups, in seconds. Only reported by backends that pace themselves (nosound).
+		time getBackendJitterMax();
+		// Copy up to aMaxFrames of the newest profiler frames, oldest first. Returns the number copied. Safe to call from any thread.
+		unsigned int getProfileFrames(ProfileFrame *aFrames, unsigned int aMaxFrames);
+		// Aggregate the frames in the profiler ring. Safe to call from any thread.
+		void getProfileStats(ProfileStats &aStats);
+		// Copy up to aMaxCount of the most expensive audio sources, most expensive first. Costs are gathered while profiling is enabled. Returns the number copied.
+		unsigned int getSourceCosts(SourceCost *aCosts, unsigned int aMaxCount);
+		// Returns the CPU time in seconds charged to an audio source while profiling.
+		time getSourceCost(AudioSource &aSound);
+		// Clear the per-source cost totals.
+		void resetSourceCosts();
+		// Start recording mix calls and per-voice costs for a Chrome trace, up to aMaxEvents. Needs profiling enabled.
+		result startCostTrace(unsigned int aMaxEvents);
+		// Stop recording and write the events as Chrome trace JSON (chrome://tracing, Perfetto).
+		result saveCostTrace(const char *aFilename);
 
 		// Set speaker position in 3d space
 		result setSpeakerPosition(unsigned int aChannel, float aX, float aY, float aZ);
@@ -278,6 +457,8 @@ namespace SoLoud
 		void stopAudioSource(AudioSource &aSound);
 		// Count voices that play this audio source
 		int countAudioSource(AudioSource &aSound);
+		// Count voices in a voice category
+		int countCategory(unsigned int aCategory);
 
 		// Set a live filter parameter. Use 0 for the global filters.
 		void setFilterParameter(handle aVoiceHandle, unsigned int aFilterId, unsigned int aAttributeId, float aValue);
@@ -287,6 +468,10 @@ namespace SoLoud
 		void fadeFilterParameter(handle aVoiceHandle, unsigned int aFilterId, unsigned int aAttributeId, float aTo, time aTime);
 		// Oscillate a live filter parameter. Use 0 for the global filters.
 		void oscillateFilterParameter(handle aVoiceHandle, unsigned int aFilterId, unsigned int aAttributeId, float aFrom, float aTo, time aTime);
+		// Set a live filter parameter at a sample accurate time, in relation to other calls to this function and the playClocked functions. Use 0 for the global filters.
+		void setFilterParameterClocked(time aSoundTime, handle aVoiceHandle, unsigned int aFilterId, unsigned int aAttributeId, float aValue);
+		// Set smoothing (Filter::PARAMSMOOTHING) of a live filter parameter. Use 0 for the global filters.
+		void setFilterParameterSmoothing(handle aVoiceHandle, unsigned int aFilterId, unsigned int aAttributeId, unsigned int aMode, time aTime);
 
 		// Get current play time, in seconds.
 		time getStreamTime(handle aVoiceHandle);
@@ -308,6 +493,10 @@ namespace SoLoud
 		unsigned int getActiveVoiceCount();
 		// Get the current number of voices in SoLoud
 		unsigned int getVoiceCount();
+		// Get the current number of virtual voices (playing, but not mixed)
+		unsigned int getVirtualVoiceCount();
+		// Get the levels of a voice or bus with metering enabled. Doesn't lock; safe to call from any thread.
+		result getVoiceMeter(handle aVoiceHandle, VoiceMeter &aMeter);
 		// Check if the handle is still valid, or if the sound has stopped.
 		bool isValidVoiceHandle(handle aVoiceHandle);
 		// Get current relative play speed.
@@ -337,6 +526,10 @@ namespace SoLoud
 		result setMaxActiveVoiceCount(unsigned int aVoiceCount);
 		// Set behavior for inaudible sounds
 		void setInaudibleBehavior(handle aVoiceHandle, bool aMustTick, bool aKill);
+		// Enable or disable level metering of a voice or bus, see getVoiceMeter
+		void setMetering(handle aVoiceHandle, bool aEnable);
+		// Limit the number of voices in a category. 0 = no limit. When full, either steal the weakest voice or reject the new one.
+		result setCategoryLimit(unsigned int aCategory, unsigned int aMaxVoices, bool aSteal = true);
 		// Set the global volume
 		void setGlobalVolume(float aVolume);
 		// Set the post clip scaler value
@@ -391,6 +584,8 @@ namespace SoLoud
 
 		// Enable or disable visualization data gathering
 		void setVisualizationEnable(bool aEnable);
+		// Enable or disable mixer profiling
+		void setProfilingEnable(bool aEnable);
 
 		// Calculate and get 256 floats of FFT data for visualization. Visualization has to be enabled before use.
 		float *calcFFT();
@@ -453,23 +648,71 @@ namespace SoLoud
 
 		// Returns mixed float samples in buffer. Called by the back-end, or user with null driver.
 		void mix(float *aBuffer, unsigned int aSamples);
+		// Returns mixed float samples with each channel in its own buffer. Called by the back-end, or user with null driver.
+		void mixPlanar(float **aBuffers, unsigned int aSamples);
 		// Returns mixed 16-bit signed integer samples in buffer. Called by the back-end, or user with null driver.
 		void mixSigned16(short *aBuffer, unsigned int aSamples);
+		// Returns mixed 24-bit signed integer samples, packed little-endian 3 bytes each, in buffer. Called by the back-end, or user with null driver.
+		void mixSigned24(unsigned char *aBuffer, unsigned int aSamples);
+		// Returns mixed 32-bit signed integer samples in buffer. Called by the back-end, or user with null driver.
+		void mixSigned32(int *aBuffer, unsigned int aSamples);
+		// Feeds captured samples, interleaved, to AudioInput. Called by the back-end right before mix() in the same cycle, or user with null driver.
+		void capture(const float *aBuffer, unsigned int aSamples);
+		// Feed AudioInput from an audio source instead of the input device, for example a recording for headless tests. NULL to go back to the device.
+		result setCaptureStandIn(AudioSource *aSource);
+		// Mix aDuration seconds as fast as possible and pass the output to aSink. Null driver only.
+		result renderOffline(time aDuration, OfflineSink &aSink);
+		// Advance time by aSeconds, mixing whole buffers like the real-time backend would. Needs the VIRTUAL_CLOCK flag.
+		result stepVirtualClock(time aSeconds);
 	public:
 		// Mix N samples * M channels. Called by other mix_ functions.
-		void mix_internal(unsigned int aSamples, unsigned int aStride);
+		// If aInterleaved or aPlanar is given, the clipped output is written there instead of to mScratch.
+		void mix_internal(unsigned int aSamples, unsigned int aStride, float *aInterleaved = 0, float **aPlanar = 0);
+
+		// Switch the profiler to aStage, charging the time since the last switch to the previous stage. Returns the previous stage.
+		unsigned int profileStage_internal(unsigned int aStage);
+
+		// Charge aNanos to an audio source and record a trace event from aStart to aEnd. Source ID 0 records a mix call.
+		void addSourceCost_internal(unsigned int aAudioSourceID, long long aNanos, long long aStart, long long aEnd);
+
+		// Backend selection and startup, shared by both init() variants
+		result init_internal(unsigned int aFlags, unsigned int aBackend, unsigned int aSamplerate, unsigned int aBufferSize, unsigned int aChannels);
 
 		// Handle rest of initialization (called from backend)
 		void postinit_internal(unsigned int aSamplerate, unsigned int aBufferSize, unsigned int aFlags, unsigned int aChannels);
+		// Set up the capture ring for aChannels (called from backend after postinit_internal)
+		result initCapture_internal(unsigned int aChannels);
+		// Write aSamples frames from the capture stand-in to the capture ring
+		void pullCaptureStandIn_internal(unsigned int aSamples);
 
 		// Update list of active voices
 		void calcActiveVoices_internal();
+		// Virtualize the candidates that didn't make it to the active list, and restore promoted ones
+		void updateVirtualVoices_internal(unsigned int aCandidates);
 		// Map resample buffers to active voices
 		void mapResampleBuffers_internal();
-		// Perform mixing for a specific bus
-		void mixBus_internal(float *aBuffer, unsigned int aSamplesToRead, unsigned int aBufferSize, float *aScratch, unsigned int aBus, float aSamplerate, unsigned int aChannels, unsigned int aResampler);
-		// Find a free voice, stopping the oldest if no free voice is found.
-		int findFreeVoice_internal();
+		// Group the active voices by the bus they play on, so that each bus only visits its own voices
+		void buildBusVoiceLists_internal();
+		// Perform mixing for a specific bus. aBlockTime is the mix time of the block, used to place aux sends.
+		void mixBus_internal(float *aBuffer, unsigned int aSamplesToRead, unsigned int aBufferSize, float *aScratch, unsigned int aBus, float aSamplerate, unsigned int aChannels, unsigned int aResampler, time aBlockTime);
+		// Accumulate a voice's panned-out block into the buses it sends to
+		void mixSends_internal(AudioSourceInstance *aVoice, const float *aScratch, unsigned int aSamples, unsigned int aBufferSize, time aBlockTime, float aSamplerate);
+		// Fill in the sidechain level of a filter instance, and make sure its source bus gets mixed first
+		void updateSidechain_internal(FilterInstance *aFilter);
+		// Run a filter chain over a planar buffer, skipping bypassed instances and instances with no tail on silent input
+		void filterChain_internal(FilterInstance **aFilter, float *aBuffer, unsigned int aSamples, unsigned int aBufferSize, unsigned int aChannels, float aSamplerate);
+		// Find a free voice, stopping the weakest if no free voice is found. Returns -1 if all remaining voices are protected or more important.
+		int findFreeVoice_internal(int aPriority);
+		// Enforce the instance and category limits of a sound about to play. Returns false if the sound should be rejected.
+		bool applyVoiceLimits_internal(AudioSource &aSound);
+		// Find the weakest unprotected voice playing a source and/or in a category (0 = any), skipping voices flagged in aSkip. Returns -1 if none.
+		int findWeakestVoice_internal(unsigned int aAudioSourceID, unsigned int aCategory, const bool *aSkip);
+		// Is a voice less important than another: lower priority, or same priority and less audible
+		bool isVoiceWeaker_internal(const AudioSourceInstance *aVoice, const AudioSourceInstance *aOther) const;
+		// Restore the weakest-on-top heap of voice indices below aPos (see calcActiveVoices_internal)
+		void siftWeakestVoice_internal(unsigned int *aHeap, unsigned int aPos, unsigned int aCount);
+		// Get the bus running the shared filters of the audio source, starting it if needed. Returns 0 if the filters can't be shared.
+		handle getSharedFilterBus_internal(AudioSource &aSound, unsigned int aBus);
 		// Converts handle to voice, if the handle is valid. Returns -1 if not.
 		int getVoiceFromHandle_internal(handle aVoiceHandle) const;
 		// Converts voice + playindex into handle
@@ -490,8 +733,8 @@ namespace SoLoud
 		void updateVoiceRelativePlaySpeed_internal(unsigned int aVoice);
 		// Perform 3d audio calculation for array of voices
 		void update3dVoices_internal(unsigned int *aVoiceList, unsigned int aVoiceCount);
-		// Clip the samples in the buffer
-		void clip_internal(AlignedFloatBuffer &aBuffer, AlignedFloatBuffer &aDestBuffer, unsigned int aSamples, float aVolume0, float aVolume1);
+		// Clip the samples in the buffer, either to planar aDestBuffer with the same stride, or interleaved
+		void clip_internal(AlignedFloatBuffer &aBuffer, float *aDestBuffer, unsigned int aSamples, unsigned int aStride, float aVolume0, float aVolume1, bool aInterleave);
 		// Remove all non-active voices from group
 		void trimVoiceGroup_internal(handle aVoiceGroupHandle);
 		// Get pointer to the zero-terminated array of voice handles in a voice group
@@ -504,6 +747,10 @@ namespace SoLoud
 
 		// Max. number of active voices. Busses and tickable inaudibles also count against this.
 		unsigned int mMaxActiveVoices;
+		// Voice limit per category, 0 = no limit
+		unsigned int mCategoryLimit[VOICE_CATEGORY_COUNT];
+		// Steal (true) or reject (false) when a category is full
+		bool mCategoryLimitSteal[VOICE_CATEGORY_COUNT];
 		// Highest voice in use so far
 		unsigned int mHighestVoice;
 		// Scratch buffer, used for resampling.
@@ -530,6 +777,18 @@ namespace SoLoud
 		unsigned int mBackendID;
 		// Current backend string
 		const char * mBackendString;
+		// Number of xruns reported by the backend
+		volatile unsigned int mBackendXrunCount;
+		// Sum of backend wakeup lateness, for the jitter average
+		time mBackendJitterSum;
+		// Worst backend wakeup lateness
+		time mBackendJitterMax;
+		// Number of backend wakeups measured
+		unsigned int mBackendJitterCount;
+		// Samples the virtual clock has been stepped past the last mixed buffer
+		double mVirtualClockPending;
+		// Attributes for the backend mixer thread, from InitConfig
+		ThreadAttributes mMixerThreadAttributes;
 		// Maximum size of output buffer; used to calculate needed scratch.
 		unsigned int mBufferSize;
 		// Flags; see Soloud::FLAGS
@@ -538,6 +797,10 @@ namespace SoLoud
 		float mGlobalVolume;
 		// Post-clip scaler. Applied after clipping.
 		float mPostClipScaler;
+		// Random state for TPDF dither, one word per SIMD lane.
+		unsigned int mDitherState[4];
+		// Clipper implementation in use; see SIMD_PATH in soloud_internal.h
+		unsigned int mSimdPath;
 		// Current play index. Used to create audio handles.
 		unsigned int mPlayIndex;
 		// Current sound source index. Used to create sound source IDs.
@@ -589,6 +852,65 @@ namespace SoLoud
 		unsigned int mActiveVoiceCount;
 		// Active voices list needs to be recalculated
 		bool mActiveVoiceDirty;
+		// First active voice (index to mActiveVoice) of each bus; 0 is the main mix, 1 + n the bus playing on voice n
+		unsigned int mBusFirstVoice[VOICE_COUNT + 1];
+		// Next active voice on the same bus, in mActiveVoice order
+		unsigned int mBusNextVoice[VOICE_COUNT];
+
+		// Profiling the current mix call; snapshot of ENABLE_PROFILING
+		bool mProfiling;
+		// Stage the profiler is charging time to
+		unsigned int mProfileStage;
+		// Time of the last stage switch
+		long long mProfileMark;
+		// Frame being recorded
+		ProfileFrame mProfileFrame;
+		// Backend xrun count when the previous frame was recorded
+		unsigned int mProfileXrunCount;
+		// Finished frames; written by the mixing thread only
+		ProfileFrame mProfileRing[PROFILE_FRAMES];
+		// Number of frames written to the ring so far
+		volatile unsigned int mProfileWriteIndex;
+		// Per-source costs, open addressed by audio source ID; protected by the audio mutex
+		SourceCost mSourceCost[SOURCE_COST_SLOTS];
+		// Cost charged by voices mixed inside the voice currently being mixed (buses)
+		long long mSourceCostNested;
+		// Chrome trace events, if recording; protected by the audio mutex
+		CostTraceEvent *mCostTrace;
+		unsigned int mCostTraceCount;
+		unsigned int mCostTraceMax;
+		// Published levels of metered voices, one slot per voice; read without locking
+		VoiceMeterSlot *mVoiceMeter;
+		// Publish the levels of a metered voice, or clear the slot if aVoice is not metered
+		void publishMeter_internal(unsigned int aVoice);
+		// Captured input, interleaved; written before mixing and read by AudioInput instances, under the audio mutex
+		float *mCaptureRing;
+		// Size of the capture ring in frames, a power of two
+		unsigned int mCaptureRingFrames;
+		// Channels in the capture ring, 0 if there is no capture path
+		unsigned int mCaptureChannels;
+		// Frames written to the capture ring so far
+		unsigned int mCaptureWrite;
+		// Capture ring position lined up with the start of the current mix
+		unsigned int mCaptureMixPos;
+		// Instance of the source feeding the capture ring instead of the device, if any
+		AudioSourceInstance *mCaptureStandIn;
+	};
+
+	// Configuration for Soloud::init; the defaults match the plain init() call.
+	struct InitConfig
+	{
+		// See Soloud::FLAGS
+		unsigned int mFlags;
+		// See Soloud::BACKENDS
+		unsigned int mBackend;
+		unsigned int mSamplerate;
+		unsigned int mBufferSize;
+		unsigned int mChannels;
+		// Applied to the backend's mixer thread, if it has one
+		ThreadAttributes mMixerThread;
+
+		InitConfig();
 	};
 };
 
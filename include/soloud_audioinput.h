@@ -0,0 +1,59 @@
+/*
+SoLoud audio engine
+Copyright (c) 2013-2021 Jari Komppa
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+
+#ifndef SOLOUD_AUDIOINPUT_H
+#define SOLOUD_AUDIOINPUT_H
+
+#include "soloud.h"
+
+namespace SoLoud
+{
+	class AudioInput;
+
+	class AudioInputInstance : public AudioSourceInstance
+	{
+		Soloud *mSoloud;
+		// Next capture ring position to read
+		unsigned int mReadPos;
+		// Has mReadPos been lined up with the capture ring yet
+		bool mStarted;
+	public:
+		AudioInputInstance(AudioInput *aParent);
+		virtual unsigned int getAudio(float *aBuffer, unsigned int aSamplesToRead, unsigned int aBufferSize);
+		virtual bool hasEnded();
+	};
+
+	// Audio source playing the input captured by the backend in the same cycle, see Soloud::ENABLE_CAPTURE.
+	// Captured input plays SAMPLE_GRANULARITY frames after it was captured, on top of the device latency.
+	class AudioInput : public AudioSource
+	{
+	public:
+		AudioInput();
+		virtual ~AudioInput();
+		virtual AudioSourceInstance *createInstance();
+	};
+};
+
+#endif
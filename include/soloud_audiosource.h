@@ -32,6 +32,7 @@ freely, subject to the following restrictions:
 namespace SoLoud
 {
 	class AudioSource;	
+	class Bus;
 	class AudioSourceInstance;
 	class AudioSourceInstance3dData;
 
@@ -98,6 +99,27 @@ namespace SoLoud
 		handle mHandle;
 	};
 
+	// Where a voice's aux send left off, for sends that resample; see BusInstance::accumulateSend
+	class AudioSendState
+	{
+	public:
+		// ctor
+		AudioSendState();
+		// Next send ring frame to write
+		long long mNextFrame;
+		// Source position of that frame, relative to the start of the next block
+		double mPos;
+		// Expected start time of the next block
+		time mNextTime;
+		// Rates the state was computed for
+		float mSourceSamplerate;
+		float mBusSamplerate;
+		// Last sample of the previous block per ring channel, to interpolate across the block edge
+		float mLast[MAX_CHANNELS];
+		// Is the state valid
+		bool mValid;
+	};
+
 	// Base class for audio instances
 	class AudioSourceInstance
 	{
@@ -121,7 +143,17 @@ namespace SoLoud
 			// If inaudible, should still be ticked (default = pause)
 			INAUDIBLE_TICK = 128,
 			// Don't auto-stop sound
-			DISABLE_AUTOSTOP = 256
+			DISABLE_AUTOSTOP = 256,
+			// This audio instance is a bus
+			BUS = 512,
+			// A filter listens to this bus; it is mixed before its siblings
+			SIDECHAIN_SOURCE = 1024,
+			// seek() is cheap and exact, so the voice can be virtualized
+			FAST_SEEK = 2048,
+			// Virtual voice: not mixed, only the play position advances
+			VIRTUAL = 4096,
+			// Peak and RMS levels are tracked, see Soloud::getVoiceMeter
+			METERING = 8192
 		};
 		// Ctor
 		AudioSourceInstance();
@@ -187,6 +219,24 @@ namespace SoLoud
 		unsigned int mDelaySamples;
 		// When looping, start playing from this time
 		time mLoopPoint;
+		// Priority; see AudioSource::setPriority
+		int mPriority;
+		// Voice category; see AudioSource::setCategory
+		unsigned int mCategory;
+		// Smoothed RMS of the source data, for ranking voices by audibility. 1 until first mixed.
+		float mRecentRMS;
+		// Peak envelope per channel, if metering
+		float mMeterPeak[MAX_CHANNELS];
+		// Mean square envelope per channel, if metering
+		float mMeterMeanSquare[MAX_CHANNELS];
+		// Handles of the buses this voice sends to, 0 = unused; see Bus::setSend
+		handle mSendBus[SENDS_PER_VOICE];
+		// Send volumes
+		float mSendVolume[SENDS_PER_VOICE];
+		// Current send volumes, used to ramp the changes to avoid clicks
+		float mCurrentSendVolume[SENDS_PER_VOICE];
+		// Resampling state of each send
+		AudioSendState mSendState[SENDS_PER_VOICE];
 
 		// Get N samples from the stream to the buffer. Report samples written.
 		virtual unsigned int getAudio(float *aBuffer, unsigned int aSamplesToRead, unsigned int aBufferSize) = 0;
@@ -225,7 +275,11 @@ namespace SoLoud
 			// If inaudible, should still be ticked (default = pause)
 			INAUDIBLE_TICK = 128,
 			// Disable auto-stop
-			DISABLE_AUTOSTOP = 256
+			DISABLE_AUTOSTOP = 256,
+			// Instances share one set of filter instances, run on a submix of all of them
+			SHARED_FILTERS = 512,
+			// Instances track their peak and RMS levels, see Soloud::getVoiceMeter
+			METERING = 1024
 		};
 		enum ATTENUATION_MODELS
 		{
@@ -271,6 +325,22 @@ namespace SoLoud
 		int mColliderData;
 		// When looping, start playing from this time
 		time mLoopPoint;
+		// Internal bus running the shared filters, see setSharedFilters
+		Bus *mSharedFilterBus;
+		// Handle of the shared filter bus voice, 0 if not playing
+		handle mSharedFilterHandle;
+		// Priority of the instances; higher priority voices are mixed and kept first
+		int mPriority;
+		// Voice category of the instances, 0 = none
+		unsigned int mCategory;
+		// Maximum number of instances playing at once, 0 = no limit
+		unsigned int mInstanceLimit;
+		// Steal (true) or reject (false) when the instance limit is reached
+		bool mInstanceLimitSteal;
+		// Buses the instances send to, 0 = unused
+		Bus *mSendBus[SENDS_PER_VOICE];
+		// Send volumes
+		float mSendVolume[SENDS_PER_VOICE];
 
 		// CTor
 		AudioSource();
@@ -282,6 +352,18 @@ namespace SoLoud
 		void setSingleInstance(bool aSingleInstance);
 		// Set whether audio should auto-stop when it ends or not
 		void setAutoStop(bool aAutoStop);
+		// Set whether instances share one set of filters, run once on their submix instead of per instance
+		void setSharedFilters(bool aShared);
+		// Set whether instances track their peak and RMS levels, see Soloud::getVoiceMeter
+		void setMetering(bool aEnable);
+		// Set the priority of the instances. Higher priority voices win over louder ones.
+		void setPriority(int aPriority);
+		// Set the voice category of the instances, see Soloud::setCategoryLimit. 0 = none.
+		result setCategory(unsigned int aCategory);
+		// Limit the number of instances playing at once. 0 = no limit. When full, either steal the weakest instance or reject the new one.
+		void setInstanceLimit(unsigned int aMaxInstances, bool aSteal = true);
+		// Set the volume the instances send to a bus, in addition to playing on their own bus. 0 removes the send.
+		result setSend(Bus &aBus, float aVolume);
 		
 		// Set the minimum and maximum distances for 3d audio source (closer to min distance = max vol)
 		void set3dMinMaxDistance(float aMinDistance, float aMaxDistance);
@@ -42,8 +42,27 @@ namespace SoLoud
 		float mVisualizationChannelVolume[MAX_CHANNELS];
 		// Mono-mixed wave data for visualization and for visualization FFT input
 		float mVisualizationWaveData[256];
+		// Linked peak and RMS of the latest mixed block. Only updated if some filter uses this bus as a sidechain.
+		float mSidechainPeak;
+		float mSidechainRMS;
+		// Mix time of the block being mixed, set by the parent bus. Places the sends in time.
+		time mBlockTime;
+		// Ring buffer of incoming aux sends, mSendRingSize frames per channel. Empty if nothing sends here.
+		AlignedFloatBuffer mSendRing;
+		unsigned int mSendRingSize;
+		// Frames between the mix time of a send and when it is read
+		unsigned int mSendLatency;
+		// Next frame to read from the ring
+		long long mSendReadFrame;
+		// Has the read position been set
+		bool mSendSynced;
 
 		BusInstance(Bus *aParent);
+		// Allocate the send ring, if not done yet
+		void initSendRing();
+		// Add a block mixed at aTime and aSamplerate to the send ring, ramping the volume.
+		// aState carries the resampling position from block to block.
+		void accumulateSend(const float *aBuffer, unsigned int aChannels, unsigned int aSamples, unsigned int aBufferSize, time aTime, float aSamplerate, float aVolumeFrom, float aVolumeTo, AudioSendState &aState);
 		virtual unsigned int getAudio(float *aBuffer, unsigned int aSamplesToRead, unsigned int aBufferSize);
 		virtual bool hasEnded();
 		virtual ~BusInstance();
@@ -70,6 +89,8 @@ namespace SoLoud
 		void setVisualizationEnable(bool aEnable);
 		// Move a live sound to this bus
 		void annexSound(handle aVoiceHandle);
+		// Send a live sound to this bus as well as to the bus it plays on. 0 removes the send.
+		result setSend(handle aVoiceHandle, float aVolume);
 		
 		// Calculate and get 256 floats of FFT data for visualization. Visualization has to be enabled before use.
 		float *calcFFT();
@@ -91,6 +112,11 @@ namespace SoLoud
 		BusInstance *mInstance;
 		unsigned int mChannelHandle;
 		unsigned int mResampler;
+		// Stop the bus once no voices play through it and its filters have gone quiet.
+		// Used for the submix of shared filters, see AudioSource::setSharedFilters.
+		bool mStopWhenIdle;
+		// Some voice or audio source sends to this bus, so the instance needs a send ring
+		bool mSendTarget;
 		// FFT output data
 		float mFFTData[256];
 		// Snapshot of wave data for visualization
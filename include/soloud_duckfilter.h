@@ -33,11 +33,10 @@ namespace SoLoud
 
 	class DuckFilterInstance : public FilterInstance
 	{
-		handle mListenTo;
-		Soloud* mSoloud;
 		float mCurrentLevel;
 	public:
 		virtual void filter(float *aBuffer, unsigned int aSamples, unsigned int aBufferSize, unsigned int aChannels, float aSamplerate, time aTime);
+		virtual bool hasTail();
 		virtual ~DuckFilterInstance();
 		DuckFilterInstance(DuckFilter *aParent);
 	};
@@ -52,7 +51,6 @@ namespace SoLoud
 			OFFRAMP,
 			LEVEL
 		};
-		Soloud* mSoloud;
 		float mOnRamp;
 		float mOffRamp;
 		float mLevel;
@@ -37,9 +37,13 @@ namespace SoLoud
 		int mBufferLength;
 		int mBufferMaxLength;
 		int mOffset;
+		unsigned int mChannels;
 
 	public:
 		virtual void filter(float *aBuffer, unsigned int aSamples, unsigned int aBufferSize, unsigned int aChannels, float aSamplerate, time aTime);
+		virtual void prepare(unsigned int aChannels, float aSamplerate);
+		virtual bool hasTail();
+		virtual void onSilence();
 		virtual ~EchoFilterInstance();
 		EchoFilterInstance(EchoFilter *aParent);
 	};
@@ -41,10 +41,13 @@ namespace SoLoud
 		unsigned int mInputOffset[MAX_CHANNELS];
 		unsigned int mMixOffset[MAX_CHANNELS];
 		unsigned int mReadOffset[MAX_CHANNELS];
+		unsigned int mChannels;
 		FFTFilter *mParent;
 	public:
 		virtual void fftFilterChannel(float *aFFTBuffer, unsigned int aSamples, float aSamplerate, time aTime, unsigned int aChannel, unsigned int aChannels);
 		virtual void filterChannel(float *aBuffer, unsigned int aSamples, float aSamplerate, time aTime, unsigned int aChannel, unsigned int aChannels);
+		virtual void prepare(unsigned int aChannels, float aSamplerate);
+		virtual bool hasTail();
 		virtual ~FFTFilterInstance();
 		FFTFilterInstance(FFTFilter *aParent);
 		FFTFilterInstance();
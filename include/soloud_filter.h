@@ -31,6 +31,28 @@ namespace SoLoud
 {
 	class Fader;
 
+	// Smoothing state for one filter parameter
+	struct FilterParamSmoother
+	{
+		// Filter::PARAMSMOOTHING
+		unsigned int mMode;
+		// Time to reach the target (linear) or time constant (one-pole), in seconds
+		float mTime;
+		// Value mParam is moving towards
+		float mTarget;
+		// Per-sample step for linear smoothing, 0 if not calculated yet
+		float mStep;
+	};
+
+	// Parameter change scheduled at a sample offset
+	struct FilterParamEvent
+	{
+		unsigned int mAttributeId;
+		float mValue;
+		// Samples from the start of the next filtered block
+		unsigned int mDelay;
+	};
+
 	class FilterInstance
 	{
 	public:
@@ -38,10 +60,29 @@ namespace SoLoud
 		unsigned int mParamChanged;
 		float *mParam;
 		Fader *mParamFader;
-		
+		FilterParamSmoother *mParamSmoother;
+		// Bitmask of parameters currently being smoothed
+		unsigned int mSmoothingActive;
+		FilterParamEvent mEvent[FILTER_EVENT_COUNT];
+		unsigned int mEventCount;
+		// Bus to use as sidechain source, 0 if none. The mixer makes sure the bus
+		// is mixed before this instance is run, and fills in its level below.
+		handle mSidechainHandle;
+		// Linked peak and RMS of the sidechain bus for the latest mixed block
+		float mSidechainPeak;
+		float mSidechainRMS;
+		// Number of consecutive silent samples fed to this instance, kept up to
+		// date by the mixer also while the instance is being skipped.
+		unsigned int mSilentSamples;
+		// Set by the mixer once hasTail() has returned false and onSilence() has been called;
+		// cleared when the instance runs again.
+		bool mFlushed;
 
 		FilterInstance();
 		virtual result initParams(int aNumParams);
+		// Called after createInstance, outside the audio thread, with the format the instance
+		// will most likely run at. Filters with delay lines should allocate them here.
+		virtual void prepare(unsigned int aChannels, float aSamplerate);
 		virtual void updateParams(time aTime);
 		virtual void filter(float *aBuffer, unsigned int aSamples, unsigned int aBufferSize, unsigned int aChannels, float aSamplerate, time aTime);
 		virtual void filterChannel(float *aBuffer, unsigned int aSamples, float aSamplerate, time aTime, unsigned int aChannel, unsigned int aChannels);
@@ -49,6 +90,26 @@ namespace SoLoud
 		virtual void setFilterParameter(unsigned int aAttributeId, float aValue);
 		virtual void fadeFilterParameter(unsigned int aAttributeId, float aTo, time aTime, time aStartTime);
 		virtual void oscillateFilterParameter(unsigned int aAttributeId, float aFrom, float aTo, time aTime, time aStartTime);
+		// Set parameter smoothing mode (Filter::PARAMSMOOTHING) and time in seconds
+		virtual void setFilterParameterSmoothing(unsigned int aAttributeId, unsigned int aMode, time aTime);
+		// Set parameter aDelay samples into the upcoming blocks
+		void scheduleFilterParameter(unsigned int aAttributeId, float aValue, unsigned int aDelay);
+		// Called by the mixer: runs filter(), split into shorter runs at scheduled changes and while smoothing
+		void filterBlock(float *aBuffer, unsigned int aSamples, unsigned int aBufferSize, unsigned int aChannels, float aSamplerate, time aTime);
+		// Move smoothed parameters aSamples samples towards their targets
+		void advanceSmoothing(unsigned int aSamples, float aSamplerate);
+		// Return true if the instance may still output sound after mSilentSamples of
+		// silent input. When this returns false the mixer skips the instance until
+		// the input is non-silent again. Must not change the state. Defaults to true.
+		virtual bool hasTail();
+		// Called once when the mixer starts skipping the instance on silent input;
+		// clear any residue left in the state here. Defaults to doing nothing.
+		virtual void onSilence();
+		// Return true if the instance passes the sound through untouched when wet is 0, and
+		// keeps no state that would go stale if it doesn't run. Defaults to false.
+		virtual bool canBypassWhenDry();
+		// True if the instance has no effect: it can be bypassed, wet is 0 and nothing is about to change it
+		bool isBypassed();
 		virtual ~FilterInstance();
 	};
 
@@ -61,6 +122,12 @@ namespace SoLoud
 			INT_PARAM,
 			BOOL_PARAM
 		};
+		enum PARAMSMOOTHING
+		{
+			NO_SMOOTHING = 0,
+			ONEPOLE_SMOOTHING,
+			LINEAR_SMOOTHING
+		};
 		Filter();
 		virtual int getParamCount();
 		virtual const char* getParamName(unsigned int aParamIndex);
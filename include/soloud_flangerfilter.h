@@ -38,9 +38,12 @@ namespace SoLoud
 		FlangerFilter *mParent;
 		unsigned int mOffset;
 		double mIndex;
+		unsigned int mChannels;
 
 	public:
 		virtual void filter(float *aBuffer, unsigned int aSamples, unsigned int aBufferSize, unsigned int aChannels, float aSamplerate, time aTime);
+		virtual void prepare(unsigned int aChannels, float aSamplerate);
+		virtual bool hasTail();
 		virtual ~FlangerFilterInstance();
 		FlangerFilterInstance(FlangerFilter *aParent);
 	};
@@ -87,7 +87,52 @@ namespace SoLoud
 	void interlace_samples_float(const float *aSourceBuffer, float *aDestBuffer, unsigned int aSamples, unsigned int aChannels, unsigned int aStride);
 
 	// Convert to 16-bit and interlace samples in a buffer. From 11112222 to 12121212
-	void interlace_samples_s16(const float *aSourceBuffer, short *aDestBuffer, unsigned int aSamples, unsigned int aChannels, unsigned int aStride);
+	// If aDither is given, TPDF dither is added using the 4-word random state it points to.
+	void interlace_samples_s16(const float *aSourceBuffer, short *aDestBuffer, unsigned int aSamples, unsigned int aChannels, unsigned int aStride, unsigned int *aDither = 0);
+
+	// Convert to packed little-endian 24-bit and interlace samples in a buffer.
+	void interlace_samples_s24(const float *aSourceBuffer, unsigned char *aDestBuffer, unsigned int aSamples, unsigned int aChannels, unsigned int aStride);
+
+	// Convert to 32-bit and interlace samples in a buffer.
+	void interlace_samples_s32(const float *aSourceBuffer, int *aDestBuffer, unsigned int aSamples, unsigned int aChannels, unsigned int aStride);
+
+	// Implementations of the output clipper
+	enum SIMD_PATH
+	{
+		SIMD_SCALAR = 0,
+		SIMD_SSE,
+		SIMD_AVX2,
+		SIMD_NEON
+	};
+
+	// Returns true if the path was compiled in and the cpu can run it
+	bool simd_path_supported(unsigned int aPath);
+
+	// Returns the fastest supported path
+	unsigned int simd_detect_path();
+
+	// Apply global volume ramp, clip and post-clip scale. Sample i gets volume aVolume0 + aVolumeDelta * i.
+	// Output is planar with aStride, or interleaved if aInterleave is set. All paths give identical results.
+	void clip_samples(unsigned int aPath, const float *aSrc, float *aDst, unsigned int aSamples, unsigned int aChannels, unsigned int aStride, bool aInterleave, bool aRoundoff, float aVolume0, float aVolumeDelta, float aPostClipScaler);
+
+	// One recorded span for Soloud::saveCostTrace
+	struct CostTraceEvent
+	{
+		// Audio source ID, or 0 for a whole mix call
+		unsigned int mAudioSourceID;
+		// Thread::getTimeNanos() at start and end
+		long long mStart;
+		long long mEnd;
+	};
+
+	// Levels of one voice, published by the mixer and read by Soloud::getVoiceMeter
+	// without locking. mSequence is odd while the slot is being written.
+	struct VoiceMeterSlot
+	{
+		volatile unsigned int mSequence;
+		volatile handle mHandle;
+		VoiceMeter mMeter;
+	};
 };
 
 #define FOR_ALL_VOICES_PRE \
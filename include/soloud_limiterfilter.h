@@ -0,0 +1,83 @@
+/*
+SoLoud audio engine
+Copyright (c) 2013-2021 Jari Komppa
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#ifndef SOLOUD_LIMITERFILTER_H
+#define SOLOUD_LIMITERFILTER_H
+
+#include "soloud.h"
+
+namespace SoLoud
+{
+	class LimiterFilter;
+
+	class LimiterFilterInstance : public FilterInstance
+	{
+		// Lookahead delay line, one ring of mDelayLength samples per channel
+		float *mBuffer;
+		int mDelayLength;
+		int mOffset;
+		unsigned int mChannels;
+		// Linked peak envelope and the number of samples it is still held for
+		float mEnvelope;
+		int mHold;
+		// Current gain applied to the delayed signal
+		float mGain;
+		// Per-sample detector / gain scratch, SAMPLE_GRANULARITY long
+		AlignedFloatBuffer mScratch;
+		float mLookahead;
+	public:
+		virtual void filter(float *aBuffer, unsigned int aSamples, unsigned int aBufferSize, unsigned int aChannels, float aSamplerate, time aTime);
+		virtual void prepare(unsigned int aChannels, float aSamplerate);
+		virtual bool hasTail();
+		virtual void onSilence();
+		virtual ~LimiterFilterInstance();
+		LimiterFilterInstance(LimiterFilter *aParent);
+	};
+
+	class LimiterFilter : public Filter
+	{
+	public:
+		enum FILTERATTRIBUTE
+		{
+			WET = 0,
+			THRESHOLD,
+			RELEASE,
+			GAINREDUCTION
+		};
+		float mThreshold;
+		float mLookahead;
+		float mRelease;
+		virtual int getParamCount();
+		virtual const char* getParamName(unsigned int aParamIndex);
+		virtual unsigned int getParamType(unsigned int aParamIndex);
+		virtual float getParamMax(unsigned int aParamIndex);
+		virtual float getParamMin(unsigned int aParamIndex);
+		virtual FilterInstance *createInstance();
+		LimiterFilter();
+		// Threshold in dB (<= 0), lookahead and release in seconds
+		result setParams(float aThreshold, float aLookahead = 0.005f, float aRelease = 0.1f);
+	};
+}
+
+#endif
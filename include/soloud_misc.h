@@ -34,6 +34,13 @@ namespace SoLoud
 		// Generate a waveform.
 		float generateWaveform(int aWaveform, float p);
 
+		// Write the per-sample maximum absolute value over all channels of a planar
+		// buffer to aDst. Used as the linked detector signal by dynamics filters.
+		void linkedPeak(float *aDst, const float *aBuffer, unsigned int aSamples, unsigned int aBufferSize, unsigned int aChannels);
+
+		// Return true if every sample in all channels of a planar buffer is zero.
+		bool isSilent(const float *aBuffer, unsigned int aSamples, unsigned int aBufferSize, unsigned int aChannels);
+
 		// WELL512 random
 		class Prg
 		{
@@ -0,0 +1,120 @@
+/*
+SoLoud audio engine
+Copyright (c) 2013-2021 Jari Komppa
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#ifndef SOLOUD_MULTIBANDCOMPRESSORFILTER_H
+#define SOLOUD_MULTIBANDCOMPRESSORFILTER_H
+
+#include "soloud.h"
+
+namespace SoLoud
+{
+	class MultibandCompressorFilter;
+
+	struct MBCBiquadCoeffs
+	{
+		float mB0, mB1, mB2, mA1, mA2;
+	};
+
+	struct MBCBiquadState
+	{
+		float mX1, mX2, mY1, mY2;
+	};
+
+	class MultibandCompressorFilterInstance : public FilterInstance
+	{
+		enum SECTIONS
+		{
+			LOW_LP0 = 0,
+			LOW_LP1,
+			LOW_HP0,
+			LOW_HP1,
+			HIGH_LP0,
+			HIGH_LP1,
+			HIGH_HP0,
+			HIGH_HP1,
+			HIGH_AP,
+			SECTION_COUNT
+		};
+		// Linkwitz-Riley crossover sections, per channel
+		MBCBiquadState mState[MAX_CHANNELS][SECTION_COUNT];
+		MBCBiquadCoeffs mLowLP, mLowHP, mHighLP, mHighHP, mHighAP;
+		// Linked envelope per band
+		float mEnvelope[3];
+		// Gain applied per band at the end of the last block, ramped from between gain updates
+		float mCurrentGain[3];
+		float mSamplerate;
+		// Band-split signal (3 bands x MAX_CHANNELS x SAMPLE_GRANULARITY)
+		AlignedFloatBuffer mBand;
+		// Per-sample gain per band (3 x SAMPLE_GRANULARITY)
+		AlignedFloatBuffer mGain;
+		void calcCrossovers();
+	public:
+		virtual void filter(float *aBuffer, unsigned int aSamples, unsigned int aBufferSize, unsigned int aChannels, float aSamplerate, time aTime);
+		virtual bool hasTail();
+		virtual void onSilence();
+		virtual ~MultibandCompressorFilterInstance();
+		MultibandCompressorFilterInstance(MultibandCompressorFilter *aParent);
+	};
+
+	class MultibandCompressorFilter : public Filter
+	{
+	public:
+		enum FILTERATTRIBUTE
+		{
+			WET = 0,
+			LOWCROSSOVER,
+			HIGHCROSSOVER,
+			LOWTHRESHOLD,
+			MIDTHRESHOLD,
+			HIGHTHRESHOLD,
+			RATIO,
+			ATTACK,
+			RELEASE,
+			MAKEUPGAIN,
+			LOWGAINREDUCTION,
+			MIDGAINREDUCTION,
+			HIGHGAINREDUCTION
+		};
+		float mLowCrossover;
+		float mHighCrossover;
+		float mThreshold[3];
+		float mRatio;
+		float mAttack;
+		float mRelease;
+		float mMakeupGain;
+		virtual int getParamCount();
+		virtual const char* getParamName(unsigned int aParamIndex);
+		virtual unsigned int getParamType(unsigned int aParamIndex);
+		virtual float getParamMax(unsigned int aParamIndex);
+		virtual float getParamMin(unsigned int aParamIndex);
+		virtual FilterInstance *createInstance();
+		MultibandCompressorFilter();
+		// Crossovers in Hz, threshold and makeup gain in dB, attack and release in seconds
+		result setParams(float aLowCrossover, float aHighCrossover, float aThreshold, float aRatio = 4.0f, float aAttack = 0.01f, float aRelease = 0.1f, float aMakeupGain = 0.0f);
+		// Set per-band thresholds in dB
+		result setBandThresholds(float aLow, float aMid, float aHigh);
+	};
+}
+
+#endif
@@ -0,0 +1,106 @@
+/*
+SoLoud audio engine
+Copyright (c) 2013-2021 Jari Komppa
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+
+#ifndef SOLOUD_OFFLINE_H
+#define SOLOUD_OFFLINE_H
+
+#include <stdio.h>
+#include "soloud.h"
+
+namespace SoLoud
+{
+	// Receives the output of Soloud::renderOffline
+	class OfflineSink
+	{
+	public:
+		// Called once before the first block with the output format
+		virtual result begin(unsigned int aChannels, unsigned int aSamplerate);
+		// Called for each mixed block. Data is planar; channel n starts at aBuffer + n * aStride.
+		virtual result write(const float *aBuffer, unsigned int aSamples, unsigned int aStride, unsigned int aChannels) = 0;
+		// Called once after the last block, also if rendering failed
+		virtual result end();
+		virtual ~OfflineSink();
+	};
+
+	// Writes the output to a file as WAV or as a raw interleaved float32 stream
+	class FileSink : public OfflineSink
+	{
+	public:
+		enum FORMAT
+		{
+			WAV_FLOAT32 = 0,
+			WAV_SIGNED16,
+			RAW_FLOAT32
+		};
+		FILE *mFile;
+		unsigned int mFormat;
+		unsigned int mChannels;
+		unsigned int mSamplerate;
+		// Bytes of sample data written so far
+		unsigned int mDataBytes;
+		// Interleave buffer, grown as needed
+		unsigned char *mBuffer;
+		unsigned int mBufferBytes;
+
+		FileSink();
+		// Open the file. Must be called before rendering.
+		result open(const char *aFilename, unsigned int aFormat = WAV_FLOAT32);
+		// Finish the header and close the file. Called by end().
+		void close();
+		virtual result begin(unsigned int aChannels, unsigned int aSamplerate);
+		virtual result write(const float *aBuffer, unsigned int aSamples, unsigned int aStride, unsigned int aChannels);
+		virtual result end();
+		virtual ~FileSink();
+	};
+
+	// Collects the output in memory as interleaved float32
+	class MemorySink : public OfflineSink
+	{
+	public:
+		float *mData;
+		// Samples per channel stored in mData
+		unsigned int mSamples;
+		unsigned int mCapacity;
+		unsigned int mChannels;
+		unsigned int mSamplerate;
+
+		MemorySink();
+		// Free the data
+		void clear();
+		virtual result begin(unsigned int aChannels, unsigned int aSamplerate);
+		virtual result write(const float *aBuffer, unsigned int aSamples, unsigned int aStride, unsigned int aChannels);
+		virtual ~MemorySink();
+	};
+
+	// Job for renderOfflineParallel. Called on a worker thread with a Soloud instance of its own,
+	// initialized on the null driver; set up the sounds and call renderOffline on it.
+	typedef result (*offlineRenderFunction)(Soloud &aSoloud, unsigned int aJob, void *aUserData);
+
+	// Run aJobCount independent render jobs over aThreads threads, each job with its own Soloud
+	// instance. With 0 threads the jobs are run on the calling thread. Returns the first error.
+	result renderOfflineParallel(unsigned int aJobCount, offlineRenderFunction aJob, void *aUserData, unsigned int aThreads, unsigned int aSamplerate = 44100, unsigned int aBufferSize = 2048, unsigned int aChannels = 2);
+};
+
+#endif
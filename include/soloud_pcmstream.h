@@ -0,0 +1,98 @@
+/*
+SoLoud audio engine
+Copyright (c) 2013-2021 Jari Komppa
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#ifndef SOLOUD_PCMSTREAM_H
+#define SOLOUD_PCMSTREAM_H
+
+#include "soloud.h"
+
+namespace SoLoud
+{
+	class PcmStream;
+
+	class PcmStreamInstance : public AudioSourceInstance
+	{
+		PcmStream *mParent;
+		// Waiting for the buffer to fill up to the target latency
+		bool mBuffering;
+		// Current target of buffered frames before each read
+		float mTarget;
+		// Smoothed number of buffered frames before each read
+		float mLevel;
+		// Fewest buffered frames before a read since mStableFrames was reset
+		unsigned int mMinLevel;
+		// Frames played since the last underrun or target change
+		unsigned int mStableFrames;
+		// Fade in gain after an underrun
+		float mFadeIn;
+		// Last output frame, faded out to cover underruns
+		float mLast[MAX_CHANNELS];
+	public:
+		PcmStreamInstance(PcmStream *aParent);
+		virtual unsigned int getAudio(float *aBuffer, unsigned int aSamplesToRead, unsigned int aBufferSize);
+		virtual bool hasEnded();
+		virtual ~PcmStreamInstance();
+	};
+
+	// Audio source playing samples written to it from another thread, through a jitter buffer.
+	// write() and the getters may be called from one thread at a time without locking the audio thread.
+	class PcmStream : public AudioSource
+	{
+	public:
+		PcmStream();
+		virtual ~PcmStream();
+		virtual PcmStreamInstance *createInstance();
+		// Set sample rate and channels. Only while not playing.
+		result setParams(float aSamplerate, unsigned int aChannels = 1);
+		// Set the latency the jitter buffer aims for, and how far it may grow after underruns (0 = 4 times the target)
+		result setLatency(time aTarget, time aMax = 0);
+		// Set the capacity of the sample ring in seconds. Only while not playing.
+		result setBufferSize(time aSeconds);
+		// Write samples, interleaved if more than one channel. aSampleCount is in sample frames.
+		result write(const float *aSamples, unsigned int aSampleCount);
+		// Number of sample frames written but not yet played
+		unsigned int getBufferedSamples();
+		// Number of times the stream has run dry while playing
+		unsigned int getUnderrunCount();
+		// Latency the jitter buffer currently aims for, after adapting to underruns
+		time getCurrentLatency();
+
+	public:
+		// Ring of written samples, interleaved; the producer owns mWritePos, the audio thread mReadPos
+		float *mRing;
+		unsigned int mRingFrames;
+		volatile unsigned int mWritePos, mReadPos;
+		time mTargetLatency;
+		time mMaxLatency;
+		time mBufferSize;
+		// Published by the audio thread
+		volatile unsigned int mUnderrunCount;
+		volatile float mCurrentLatency;
+		PcmStreamInstance *mInstance;
+		// Allocate the ring, if not done yet
+		result initRing_internal();
+	};
+};
+
+#endif
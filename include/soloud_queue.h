@@ -27,6 +27,7 @@ freely, subject to the following restrictions:
 
 #include "soloud.h"
 
+// Default number of queued sounds and sample blocks
 #define SOLOUD_QUEUE_MAX 32
 
 namespace SoLoud
@@ -36,6 +37,8 @@ namespace SoLoud
 	class QueueInstance : public AudioSourceInstance
 	{
 		Queue *mParent;
+		// Was the last finished entry a sound rather than pushed samples
+		bool mLastWasSound;
 	public:
 		QueueInstance(Queue *aParent);
 		virtual unsigned int getAudio(float *aBuffer, unsigned int aSamplesToRead, unsigned int aBufferSize);
@@ -43,13 +46,18 @@ namespace SoLoud
 		virtual ~QueueInstance();
 	};
 
+	// The queue is a single producer, single consumer queue: play(), pushSamples() and the
+	// getters may be called from one thread at a time without locking the audio thread.
 	class Queue : public AudioSource
 	{
 	public:
 		Queue();
+		virtual ~Queue();
 		virtual QueueInstance *createInstance();
 		// Play sound through the queue
 		result play(AudioSource &aSound);
+		// Queue raw samples, interleaved if more than one channel. aSampleCount is in sample frames.
+		result pushSamples(const float *aSamples, unsigned int aSampleCount);
         // Number of audio sources queued for replay
         unsigned int getQueueCount();
 		// Is this audio source currently playing?
@@ -58,13 +66,30 @@ namespace SoLoud
 		result setParamsFromAudioSource(AudioSource &aSound);
 		// Set params manually
 		result setParams(float aSamplerate, unsigned int aChannels = 2);
+		// Set how many sounds and sample blocks can be queued, and how many sample frames pushSamples can buffer. Only while the queue is empty.
+		result setQueueSize(unsigned int aMaxEntries, unsigned int aMaxSampleFrames = 0);
 		
 	public:
-	    unsigned int mReadIndex, mWriteIndex, mCount;
-	    AudioSourceInstance *mSource[SOLOUD_QUEUE_MAX];
+		// Entries are free, queued or waiting to be deleted: mFreeIndex <= mReadIndex <= mWriteIndex.
+		// The producer owns mWriteIndex and mFreeIndex, the audio thread mReadIndex.
+	    volatile unsigned int mReadIndex, mWriteIndex;
+		unsigned int mFreeIndex;
+		unsigned int mQueueSize;
+		// Queued instances; 0 for a block of pushed samples
+	    AudioSourceInstance **mSource;
+		// Sample frames of each pushed block
+		unsigned int *mSourceFrames;
+		// Ring of pushed samples, interleaved; the producer owns mPcmWrite, the audio thread mPcmRead
+		float *mPcm;
+		unsigned int mPcmFrames;
+		volatile unsigned int mPcmWrite, mPcmRead;
+		// Frames already played from the sample block at the head of the queue; owned by the audio thread
+		unsigned int mPcmOffset;
 		QueueInstance *mInstance;
 		handle mQueueHandle;
 		void findQueueHandle();
+		// Delete the instances the audio thread is done with
+		void freePlayed_internal();
 		
 	};
 };
@@ -44,6 +44,8 @@ namespace SoLoud
 		RobotizeFilter *mParent;
 	public:
 		virtual void filterChannel(float *aBuffer, unsigned int aSamples, float aSamplerate, time aTime, unsigned int aChannel, unsigned int aChannels);
+		virtual bool hasTail();
+		virtual bool canBypassWhenDry();
 		RobotizeFilterInstance(RobotizeFilter *aParent);
 	};
 
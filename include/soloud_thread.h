@@ -41,13 +41,35 @@ namespace SoLoud
 		void lockMutex(void *aHandle);
 		void unlockMutex(void *aHandle);
 
-		ThreadHandle createThread(threadFunction aThreadFunction, void *aParameter);
+		// Start a thread. Attributes the platform or user's privileges don't allow are skipped. Returns 0 on failure.
+		ThreadHandle createThread(threadFunction aThreadFunction, void *aParameter, const ThreadAttributes *aAttributes = 0);
+		// Attributes for a backend mixer thread: the thread gets a name if it has none
+		ThreadAttributes mixerThreadAttributes(const ThreadAttributes &aAttributes);
 
 		void sleep(int aMSec);
         void wait(ThreadHandle aThreadHandle);
         void release(ThreadHandle aThreadHandle);
 		int getTimeMillis();
-
+		// Full memory barrier, for handing data between threads without a mutex
+		void memoryBarrier();
+		// Monotonic time in nanoseconds, from an arbitrary starting point
+		long long getTimeNanos();
+		// Sleep until getTimeNanos() reaches aNanos
+		void sleepUntil(long long aNanos);
+
+		// Condition variables, used together with a mutex from createMutex
+		void * createCondition();
+		void destroyCondition(void *aHandle);
+		// Atomically unlock aMutex and sleep until signaled; aMutex is locked again on return. May wake spuriously.
+		void waitCondition(void *aHandle, void *aMutex);
+		// Wake one waiter
+		void signalCondition(void *aHandle);
+		// Wake all waiters
+		void broadcastCondition(void *aHandle);
+
+// Initial size of each worker's task queue; queues grow as needed
+#define THREADPOOL_INITIAL_TASKS 64
+// No longer a limit, since the queues grow; kept for source compatibility
 #define MAX_THREADPOOL_TASKS 1024
 
 		class PoolTask
@@ -56,26 +78,47 @@ namespace SoLoud
 			virtual void work() = 0;
 		};
 
+		// Set of tasks that can be waited on together with Pool::wait
+		class PoolGroup
+		{
+		public:
+			PoolGroup();
+			// Tasks added but not yet finished; protected by the pool's mutex
+			int mPending;
+		};
+
+		struct PoolWorker;
+
 		class Pool
 		{
 		public:
 			// Initialize and run thread pool. For thread count 0, work is done at addWork call.
-			void init(int aThreadCount);
+			void init(int aThreadCount, const ThreadAttributes *aAttributes = 0);
 			// Ctor, sets known state
 			Pool();
 			// Dtor. Waits for the threads to finish. Work may be unfinished.
 			~Pool();
 			// Add work to work list. Object is not automatically deleted when work is done.
-			void addWork(PoolTask *aTask);
-			// Called from worker thread to get a new task. Returns null if no work available.
+			void addWork(PoolTask *aTask, PoolGroup *aGroup = 0);
+			// Add several tasks at once, spread over the workers with a single wakeup
+			void addWork(PoolTask **aTasks, int aCount, PoolGroup *aGroup = 0);
+			// Wait until all tasks in aGroup (or all tasks, if null) are done. The calling thread helps with the work meanwhile.
+			void wait(PoolGroup *aGroup = 0);
+			// Take a pending task to run on the calling thread. Returns null if no work available.
+			// The task counts as done as soon as it is taken, so wait() doesn't wait for it.
 			PoolTask *getWork();
+			// Run one pending task, preferring worker aWorker's queue. Returns false if no work was available.
+			bool runTask_internal(int aWorker);
 		public:
 			int mThreadCount; // number of threads
 			ThreadHandle *mThread; // array of thread handles
-			void *mWorkMutex; // mutex to protect task array/maxtask
-			PoolTask *mTaskArray[MAX_THREADPOOL_TASKS]; // pointers to tasks
-			int mMaxTask; // how many tasks are pending
-			int mRobin; // cyclic counter, used to pick jobs for threads
+			PoolWorker *mWorker; // per-thread task queues, mThreadCount of them
+			void *mWorkMutex; // mutex protecting the counters below and the conditions
+			void *mWorkCondition; // signaled when tasks are queued or the pool stops
+			void *mDoneCondition; // broadcast when a group or the whole pool runs dry
+			int mQueued; // tasks sitting in queues
+			int mOutstanding; // tasks added but not finished
+			int mRobin; // cyclic counter, used to spread submissions over queues
 			volatile int mRunning; // running flag, used to flag threads to stop
 		};
 	}
@@ -43,6 +43,7 @@ namespace SoLoud
 		WavInstance(Wav *aParent);
 		virtual unsigned int getAudio(float *aBuffer, unsigned int aSamplesToRead, unsigned int aBufferSize);
 		virtual result rewind();
+		virtual result seek(time aSeconds, float *mScratch, unsigned int mScratchSize);
 		virtual bool hasEnded();
 	};
 
@@ -36,6 +36,8 @@ namespace SoLoud
 		WaveShaperFilter *mParent;
 	public:
 		virtual void filterChannel(float *aBuffer, unsigned int aSamples, float aSamplerate, time aTime, unsigned int aChannel, unsigned int aChannels);
+		virtual bool hasTail();
+		virtual bool canBypassWhenDry();
 		virtual ~WaveShaperFilterInstance();
 		WaveShaperFilterInstance(WaveShaperFilter *aParent);
 	};
@@ -0,0 +1,309 @@
+/*
+SoLoud audio engine
+Copyright (c) 2013-2021 Jari Komppa
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#include <string.h>
+#include <math.h>
+#include "soloud.h"
+#include "soloud_pcmstream.h"
+#include "soloud_thread.h"
+
+namespace SoLoud
+{
+	PcmStreamInstance::PcmStreamInstance(PcmStream *aParent)
+	{
+		mParent = aParent;
+		mBuffering = true;
+		mTarget = (float)(aParent->mTargetLatency * aParent->mBaseSamplerate);
+		mLevel = mTarget;
+		mMinLevel = ~0u;
+		mStableFrames = 0;
+		mFadeIn = 0;
+		int i;
+		for (i = 0; i < MAX_CHANNELS; i++)
+			mLast[i] = 0;
+	}
+
+	unsigned int PcmStreamInstance::getAudio(float *aBuffer, unsigned int aSamplesToRead, unsigned int aBufferSize)
+	{
+		PcmStream *p = mParent;
+		unsigned int i, j;
+		if (p->mRing == 0)
+		{
+			for (j = 0; j < mChannels; j++)
+				memset(aBuffer + j * aBufferSize, 0, sizeof(float) * aSamplesToRead);
+			return aSamplesToRead;
+		}
+
+		float rate = mBaseSamplerate;
+		// The mixer reads whole blocks, so less than one block buffered is an underrun waiting to happen
+		float mintarget = (float)(p->mTargetLatency * rate);
+		if (mintarget < aSamplesToRead)
+			mintarget = (float)aSamplesToRead;
+		float maxtarget = (float)(p->mMaxLatency * rate);
+		if (maxtarget < mintarget)
+			maxtarget = mintarget;
+		if (mTarget < mintarget)
+			mTarget = mintarget;
+		if (mTarget > maxtarget)
+			mTarget = maxtarget;
+
+		unsigned int writepos = p->mWritePos;
+		// Make sure we see the samples written before mWritePos moved
+		Thread::memoryBarrier();
+		unsigned int buffered = writepos - p->mReadPos;
+
+		if (mBuffering && buffered >= mTarget)
+		{
+			mBuffering = false;
+			mFadeIn = 0;
+			mLevel = (float)buffered;
+		}
+
+		unsigned int frames = 0;
+		if (!mBuffering)
+		{
+			mLevel += (buffered - mLevel) * 0.1f;
+			if (buffered < mMinLevel)
+				mMinLevel = buffered;
+
+			frames = buffered < aSamplesToRead ? buffered : aSamplesToRead;
+			unsigned int mask = p->mRingFrames - 1;
+			unsigned int pos = p->mReadPos;
+			// Fade in over 2ms after (re)starting
+			float fadestep = 1 / (rate * 0.002f);
+			for (i = 0; i < frames; i++, pos++)
+			{
+				const float *src = p->mRing + (pos & mask) * mChannels;
+				float gain = mFadeIn;
+				if (mFadeIn < 1)
+				{
+					mFadeIn += fadestep;
+					if (mFadeIn > 1)
+						mFadeIn = 1;
+				}
+				for (j = 0; j < mChannels; j++)
+					aBuffer[i + j * aBufferSize] = src[j] * gain;
+			}
+			if (frames)
+			{
+				for (j = 0; j < mChannels; j++)
+					mLast[j] = aBuffer[frames - 1 + j * aBufferSize];
+			}
+			Thread::memoryBarrier();
+			p->mReadPos = pos;
+
+			if (frames < aSamplesToRead)
+			{
+				// Ran dry: aim higher, and refill before playing again
+				p->mUnderrunCount++;
+				mBuffering = true;
+				mTarget *= 1.5f;
+				if (mTarget > maxtarget)
+					mTarget = maxtarget;
+				mStableFrames = 0;
+				mMinLevel = ~0u;
+			}
+			else
+			{
+				mStableFrames += aSamplesToRead;
+				if (mStableFrames > rate * 5)
+				{
+					// No underruns for a while; if there was always slack, aim lower
+					if (mMinLevel > aSamplesToRead + mTarget * 0.25f)
+					{
+						mTarget *= 0.9f;
+						if (mTarget < mintarget)
+							mTarget = mintarget;
+					}
+					mStableFrames = 0;
+					mMinLevel = ~0u;
+				}
+			}
+		}
+
+		if (frames < aSamplesToRead)
+		{
+			// Cover the gap by fading out from the last frame played (5ms)
+			float decay = (float)exp(-1 / (rate * 0.005f));
+			for (j = 0; j < mChannels; j++)
+			{
+				float v = mLast[j];
+				for (i = frames; i < aSamplesToRead; i++)
+				{
+					v *= decay;
+					aBuffer[i + j * aBufferSize] = v;
+				}
+				if (fabs(v) < 1e-6f)
+					v = 0;
+				mLast[j] = v;
+			}
+		}
+
+		// Hold the buffer level at the target by nudging the playback rate by up to 0.5%;
+		// the mixer's resampler takes care of the rest.
+		float speed = 1;
+		if (!mBuffering)
+		{
+			float error = (mLevel - mTarget) / mTarget;
+			if (error > 1)
+				error = 1;
+			if (error < -1)
+				error = -1;
+			speed += error * 0.005f;
+		}
+		mSamplerate = mBaseSamplerate * mOverallRelativePlaySpeed * speed;
+		p->mCurrentLatency = mTarget / rate;
+		return aSamplesToRead;
+	}
+
+	bool PcmStreamInstance::hasEnded()
+	{
+		return false;
+	}
+
+	PcmStreamInstance::~PcmStreamInstance()
+	{
+		if (mParent->mInstance == this)
+			mParent->mInstance = 0;
+	}
+
+	PcmStream::PcmStream()
+	{
+		mRing = 0;
+		mRingFrames = 0;
+		mWritePos = 0;
+		mReadPos = 0;
+		mTargetLatency = 0.02;
+		mMaxLatency = 0.08;
+		mBufferSize = 1;
+		mUnderrunCount = 0;
+		mCurrentLatency = 0.02f;
+		mInstance = 0;
+	}
+
+	PcmStream::~PcmStream()
+	{
+		stop();
+		delete[] mRing;
+	}
+
+	PcmStreamInstance * PcmStream::createInstance()
+	{
+		if (mInstance)
+		{
+			stop();
+			mInstance = 0;
+		}
+		// Not on the audio thread, so allocate here rather than on first read
+		initRing_internal();
+		mInstance = new PcmStreamInstance(this);
+		return mInstance;
+	}
+
+	result PcmStream::initRing_internal()
+	{
+		if (mRing)
+			return SO_NO_ERROR;
+		unsigned int frames = (unsigned int)(mBufferSize * mBaseSamplerate);
+		mRingFrames = SAMPLE_GRANULARITY * 2;
+		while (mRingFrames < frames)
+			mRingFrames *= 2;
+		mRing = new float[mRingFrames * mChannels];
+		if (mRing == 0)
+			return OUT_OF_MEMORY;
+		mWritePos = 0;
+		mReadPos = 0;
+		return SO_NO_ERROR;
+	}
+
+	result PcmStream::setParams(float aSamplerate, unsigned int aChannels)
+	{
+		if (aChannels < 1 || aChannels > MAX_CHANNELS || aSamplerate <= 0 || mInstance)
+			return INVALID_PARAMETER;
+		mChannels = aChannels;
+		mBaseSamplerate = aSamplerate;
+		delete[] mRing;
+		mRing = 0;
+		return SO_NO_ERROR;
+	}
+
+	result PcmStream::setLatency(time aTarget, time aMax)
+	{
+		if (aMax == 0)
+			aMax = aTarget * 4;
+		if (aTarget <= 0 || aMax < aTarget || aMax > mBufferSize)
+			return INVALID_PARAMETER;
+		mTargetLatency = aTarget;
+		mMaxLatency = aMax;
+		return SO_NO_ERROR;
+	}
+
+	result PcmStream::setBufferSize(time aSeconds)
+	{
+		if (aSeconds <= 0 || aSeconds < mMaxLatency || mInstance)
+			return INVALID_PARAMETER;
+		mBufferSize = aSeconds;
+		delete[] mRing;
+		mRing = 0;
+		return SO_NO_ERROR;
+	}
+
+	result PcmStream::write(const float *aSamples, unsigned int aSampleCount)
+	{
+		if (aSamples == 0)
+			return INVALID_PARAMETER;
+		result res = initRing_internal();
+		if (res != SO_NO_ERROR)
+			return res;
+
+		unsigned int readpos = mReadPos;
+		if (aSampleCount > mRingFrames - (mWritePos - readpos))
+			return OUT_OF_MEMORY;
+
+		unsigned int mask = mRingFrames - 1;
+		unsigned int pos = mWritePos;
+		unsigned int i;
+		for (i = 0; i < aSampleCount; i++, pos++)
+			memcpy(mRing + (pos & mask) * mChannels, aSamples + i * mChannels, sizeof(float) * mChannels);
+		// Publish the samples before the position
+		Thread::memoryBarrier();
+		mWritePos = pos;
+		return SO_NO_ERROR;
+	}
+
+	unsigned int PcmStream::getBufferedSamples()
+	{
+		return mWritePos - mReadPos;
+	}
+
+	unsigned int PcmStream::getUnderrunCount()
+	{
+		return mUnderrunCount;
+	}
+
+	time PcmStream::getCurrentLatency()
+	{
+		return mCurrentLatency;
+	}
+};
@@ -39,6 +39,7 @@ namespace SoLoud
 	{
 		mParent = aParent;
 		mOffset = 0;
+		mFlags |= AudioSourceInstance::FAST_SEEK;
 	}
 
 	unsigned int WavInstance::getAudio(float *aBuffer, unsigned int aSamplesToRead, unsigned int aBufferSize)
@@ -68,6 +69,38 @@ namespace SoLoud
 		return 0;
 	}
 
+	result WavInstance::seek(time aSeconds, float * /*mScratch*/, unsigned int /*mScratchSize*/)
+	{
+		// All data is in memory, so seeking is just moving the offset.
+		// Looping sounds wrap around the loop point, so virtual voices can
+		// seek straight to where they would be.
+		double count = mParent->mSampleCount;
+		double offset = floor(aSeconds * mBaseSamplerate + 0.5);
+		if (offset < 0)
+		{
+			offset = 0;
+			aSeconds = 0;
+		}
+		if (offset >= count && count > 0 && (mFlags & AudioSourceInstance::LOOPING))
+		{
+			double loop = floor(mLoopPoint * mBaseSamplerate);
+			if (loop >= count)
+				loop = 0;
+			double wraps = floor((offset - loop) / (count - loop));
+			mLoopCount += (unsigned int)wraps;
+			offset -= wraps * (count - loop);
+			aSeconds -= wraps * (count - loop) / mBaseSamplerate;
+		}
+		if (offset > count)
+		{
+			offset = count;
+			aSeconds = count / mBaseSamplerate;
+		}
+		mOffset = (unsigned int)offset;
+		mStreamPosition = aSeconds;
+		return SO_NO_ERROR;
+	}
+
 	bool WavInstance::hasEnded()
 	{
 		if (!(mFlags & AudioSourceInstance::LOOPING) && mOffset >= mParent->mSampleCount)
@@ -341,7 +341,8 @@ namespace SoLoud
 
 	result WavStreamInstance::seek(double aSeconds, float* mScratch, unsigned int mScratchSize)
 	{
-		if (mCodec.mOgg)
+		// mCodec is a union, so check the file type before using the ogg decoder
+		if (mParent->mFiletype == WAVSTREAM_OGG && mCodec.mOgg)
 		{
 			int pos = (int)floor(mBaseSamplerate * aSeconds);
 			stb_vorbis_seek(mCodec.mOgg, pos);
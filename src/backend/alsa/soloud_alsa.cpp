@@ -29,7 +29,7 @@ freely, subject to the following restrictions:
 
 namespace SoLoud
 {
-    result alsa_init(Soloud *aSoloud, unsigned int aFlags, unsigned int aSamplerate, unsigned int aBuffer)
+    result alsa_init(Soloud *aSoloud, unsigned int aFlags, unsigned int aSamplerate, unsigned int aBuffer, unsigned int aChannels)
 	{
 		return NOT_IMPLEMENTED;
 	}
@@ -43,39 +43,123 @@ namespace SoLoud
 #include <fcntl.h>
 #include <unistd.h>
 #include <string.h>
+#include <errno.h>
 
 namespace SoLoud
 {
     struct ALSAData
     {
-        float *buffer;
-        short *sampleBuffer;
+        unsigned char *sampleBuffer;
         snd_pcm_t *alsaDeviceHandle;
+        snd_pcm_format_t format;
+        bool mmap;
         Soloud *soloud;
         int samples;
         int channels;
+        int frameBytes;
         bool audioProcessingDone;
         Thread::ThreadHandle threadHandle;
     };
 
+    // Mix aFrames frames in the device's native format, so the output is written in a single pass.
+    static void alsaMix(ALSAData *data, void *aBuffer, unsigned int aFrames)
+    {
+        switch (data->format)
+        {
+        case SND_PCM_FORMAT_FLOAT:
+            data->soloud->mix(static_cast<float*>(aBuffer), aFrames);
+            break;
+        case SND_PCM_FORMAT_S32:
+            data->soloud->mixSigned32(static_cast<int*>(aBuffer), aFrames);
+            break;
+        case SND_PCM_FORMAT_S24_3LE:
+            data->soloud->mixSigned24(static_cast<unsigned char*>(aBuffer), aFrames);
+            break;
+        default:
+            data->soloud->mixSigned16(static_cast<short*>(aBuffer), aFrames);
+            break;
+        }
+    }
 
-    static void alsaThread(void *aParam)
+    // Count the xrun and get the device running again
+    static bool alsaRecover(ALSAData *data, int aError)
     {
-        
-        ALSAData *data = static_cast<ALSAData*>(aParam);
-        while (!data->audioProcessingDone) 
-        {            
-            data->soloud->mix(data->buffer, data->samples);            
-            for (int i=0;i<data->samples*data->channels;++i)
+        if (aError == -EPIPE || aError == -ESTRPIPE)
+        {
+            data->soloud->mBackendXrunCount++;
+        }
+        return snd_pcm_recover(data->alsaDeviceHandle, aError, 1) >= 0;
+    }
+
+    static void alsaMmapThread(ALSAData *data)
+    {
+        snd_pcm_t *handle = data->alsaDeviceHandle;
+        while (!data->audioProcessingDone)
+        {
+            snd_pcm_sframes_t avail = snd_pcm_avail_update(handle);
+            if (avail < 0)
             {
-                data->sampleBuffer[i] = static_cast<short>(floor(data->buffer[i] 
-                                                          * static_cast<float>(0x7fff)));
+                if (!alsaRecover(data, (int)avail))
+                    break;
+                continue;
+            }
+
+            if (avail < data->samples)
+            {
+                if (snd_pcm_state(handle) == SND_PCM_STATE_PREPARED)
+                {
+                    // Buffer is full but start threshold wasn't reached; kick it manually
+                    snd_pcm_start(handle);
+                    continue;
+                }
+                int rc = snd_pcm_wait(handle, 100);
+                if (rc < 0 && !alsaRecover(data, rc))
+                    break;
+                continue;
+            }
+
+            const snd_pcm_channel_area_t *areas;
+            snd_pcm_uframes_t offset;
+            snd_pcm_uframes_t frames = data->samples;
+            int rc = snd_pcm_mmap_begin(handle, &areas, &offset, &frames);
+            if (rc < 0)
+            {
+                if (!alsaRecover(data, rc))
+                    break;
+                continue;
+            }
+
+            // Interleaved access, so all channels share the first area
+            unsigned char *dst = static_cast<unsigned char*>(areas[0].addr) + (areas[0].first + offset * areas[0].step) / 8;
+            alsaMix(data, dst, (unsigned int)frames);
+
+            snd_pcm_sframes_t committed = snd_pcm_mmap_commit(handle, offset, frames);
+            if (committed < 0 || (snd_pcm_uframes_t)committed != frames)
+            {
+                if (!alsaRecover(data, committed < 0 ? (int)committed : -EPIPE))
+                    break;
             }
-            if (snd_pcm_writei(data->alsaDeviceHandle, data->sampleBuffer, data->samples) == -EPIPE)
-                snd_pcm_prepare(data->alsaDeviceHandle);
-                
         }
-        
+    }
+
+    static void alsaWriteThread(ALSAData *data)
+    {
+        while (!data->audioProcessingDone)
+        {
+            alsaMix(data, data->sampleBuffer, data->samples);
+            snd_pcm_sframes_t rc = snd_pcm_writei(data->alsaDeviceHandle, data->sampleBuffer, data->samples);
+            if (rc < 0 && !alsaRecover(data, (int)rc))
+                break;
+        }
+    }
+
+    static void alsaThread(void *aParam)
+    {
+        ALSAData *data = static_cast<ALSAData*>(aParam);
+        if (data->mmap)
+            alsaMmapThread(data);
+        else
+            alsaWriteThread(data);
     }
 
     static void alsaCleanup(Soloud *aSoloud)
@@ -91,28 +175,55 @@ namespace SoLoud
             Thread::wait(data->threadHandle);
             Thread::release(data->threadHandle);
         }
-        snd_pcm_drain(data->alsaDeviceHandle);
-        snd_pcm_close(data->alsaDeviceHandle);
-        if (0 != data->sampleBuffer)
+        if (data->alsaDeviceHandle)
         {
-            delete[] data->sampleBuffer;
+            snd_pcm_drain(data->alsaDeviceHandle);
+            snd_pcm_close(data->alsaDeviceHandle);
         }
-        if (0 != data->buffer)
+        if (0 != data->sampleBuffer)
         {
-            delete[] data->buffer;
+            delete[] data->sampleBuffer;
         }
         delete data;
         aSoloud->mBackendData = 0;
     }
 
+    // Pick the best sample format the device accepts natively
+    static snd_pcm_format_t alsaPickFormat(snd_pcm_t *aHandle, snd_pcm_hw_params_t *aParams, int &aBytes)
+    {
+        static const snd_pcm_format_t formats[] = { SND_PCM_FORMAT_FLOAT, SND_PCM_FORMAT_S32, SND_PCM_FORMAT_S24_3LE, SND_PCM_FORMAT_S16 };
+        static const int bytes[] = { 4, 4, 3, 2 };
+        int i;
+        for (i = 0; i < 4; i++)
+        {
+            if (snd_pcm_hw_params_test_format(aHandle, aParams, formats[i]) == 0)
+            {
+                aBytes = bytes[i];
+                return formats[i];
+            }
+        }
+        aBytes = 0;
+        return SND_PCM_FORMAT_UNKNOWN;
+    }
+
+    // Pick the requested channel count if possible, falling back to stereo and mono
+    static unsigned int alsaPickChannels(snd_pcm_t *aHandle, snd_pcm_hw_params_t *aParams, unsigned int aChannels)
+    {
+        if (snd_pcm_hw_params_test_channels(aHandle, aParams, aChannels) == 0)
+            return aChannels;
+        if (snd_pcm_hw_params_test_channels(aHandle, aParams, 2) == 0)
+            return 2;
+        if (snd_pcm_hw_params_test_channels(aHandle, aParams, 1) == 0)
+            return 1;
+        return 0;
+    }
+
     result alsa_init(Soloud *aSoloud, unsigned int aFlags, unsigned int aSamplerate, unsigned int aBuffer, unsigned int aChannels)
     {
         ALSAData *data = new ALSAData;
         memset(data, 0, sizeof(ALSAData));
         aSoloud->mBackendData = data;
         aSoloud->mBackendCleanupFunc = alsaCleanup;
-        data->samples = aBuffer;
-        data->channels = 2;
         data->soloud = aSoloud;
 
         int rc;
@@ -129,10 +240,25 @@ namespace SoLoud
         snd_pcm_hw_params_alloca(&params);
         snd_pcm_hw_params_any(handle, params);
 
-        snd_pcm_hw_params_set_access(handle, params, SND_PCM_ACCESS_RW_INTERLEAVED);
-        snd_pcm_hw_params_set_format(handle, params, SND_PCM_FORMAT_S16_LE);
-        snd_pcm_hw_params_set_channels(handle, params, 2);
-        snd_pcm_hw_params_set_buffer_size(handle, params, aBuffer);
+        // Prefer writing straight to the device buffer
+        data->mmap = snd_pcm_hw_params_set_access(handle, params, SND_PCM_ACCESS_MMAP_INTERLEAVED) == 0;
+        if (!data->mmap && snd_pcm_hw_params_set_access(handle, params, SND_PCM_ACCESS_RW_INTERLEAVED) < 0)
+        {
+            return UNKNOWN_ERROR;
+        }
+
+        int samplebytes;
+        data->format = alsaPickFormat(handle, params, samplebytes);
+        if (data->format == SND_PCM_FORMAT_UNKNOWN || snd_pcm_hw_params_set_format(handle, params, data->format) < 0)
+        {
+            return UNKNOWN_ERROR;
+        }
+
+        unsigned int channels = alsaPickChannels(handle, params, aChannels);
+        if (channels == 0 || snd_pcm_hw_params_set_channels(handle, params, channels) < 0)
+        {
+            return UNKNOWN_ERROR;
+        }
         
         unsigned int val = aSamplerate;
         int dir = 0;
@@ -142,21 +268,53 @@ namespace SoLoud
             return UNKNOWN_ERROR;
         }
 
+        // aBuffer is the target latency; split it in two periods.
+        snd_pcm_uframes_t period = aBuffer / 2;
+        if (period < 16)
+            period = 16;
+        dir = 0;
+        snd_pcm_hw_params_set_period_size_near(handle, params, &period, &dir);
+        unsigned int periods = 2;
+        dir = 0;
+        snd_pcm_hw_params_set_periods_near(handle, params, &periods, &dir);
+
         rc = snd_pcm_hw_params(handle, params);
         if (rc < 0) 
         {
             return UNKNOWN_ERROR;
         }
 
+        dir = 0;
         snd_pcm_hw_params_get_rate(params, &val, &dir);
         aSamplerate = val;
         snd_pcm_hw_params_get_channels(params, &val);
         data->channels = val;
+        dir = 0;
+        snd_pcm_hw_params_get_period_size(params, &period, &dir);
+        snd_pcm_uframes_t buffersize;
+        snd_pcm_hw_params_get_buffer_size(params, &buffersize);
+        data->samples = (int)period;
+        data->frameBytes = samplebytes * data->channels;
+
+        // Start once the whole buffer has been filled, and wake up once per period
+        snd_pcm_sw_params_t *swparams;
+        snd_pcm_sw_params_alloca(&swparams);
+        snd_pcm_sw_params_current(handle, swparams);
+        snd_pcm_sw_params_set_start_threshold(handle, swparams, buffersize);
+        snd_pcm_sw_params_set_avail_min(handle, swparams, period);
+        rc = snd_pcm_sw_params(handle, swparams);
+        if (rc < 0)
+        {
+            return UNKNOWN_ERROR;
+        }
 
-        data->buffer = new float[data->samples*data->channels];
-        data->sampleBuffer = new short[data->samples*data->channels];
-        aSoloud->postinit_internal(aSamplerate, data->samples * data->channels, aFlags, 2);
-        data->threadHandle = Thread::createThread(alsaThread, data);
+        if (!data->mmap)
+        {
+            data->sampleBuffer = new unsigned char[data->samples * data->frameBytes];
+        }
+        aSoloud->postinit_internal(aSamplerate, data->samples, aFlags, data->channels);
+        ThreadAttributes threadAttributes = Thread::mixerThreadAttributes(aSoloud->mMixerThreadAttributes);
+        data->threadHandle = Thread::createThread(alsaThread, data, &threadAttributes);
         if (0 == data->threadHandle)
         {
             return UNKNOWN_ERROR;
@@ -165,4 +323,4 @@ namespace SoLoud
         return 0;
     }
 };
-#endif
\ No newline at end of file
+#endif
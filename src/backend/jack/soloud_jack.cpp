@@ -24,7 +24,7 @@ freely, subject to the following restrictions:
 
 namespace SoLoud
 {
-    result jack_init(Soloud *aSoloud, unsigned int aFlags, unsigned int aSamplerate, unsigned int aBuffer)
+    result jack_init(Soloud *aSoloud, unsigned int aFlags, unsigned int aSamplerate, unsigned int aBuffer, unsigned int aChannels)
 	{
         return NOT_IMPLEMENTED;
     }
@@ -33,61 +33,120 @@ namespace SoLoud
 #else
 
 #include <jack/jack.h>
-#include <string>
+#include <stdio.h>
+#include <string.h>
 
 namespace SoLoud
 {
-    static jack_client_t *client;
-    static jack_port_t **ports;
-    static unsigned int portCount;
-
-    static void jack_cleanup(Soloud * /*aSoloud*/)
+    struct JackData
+    {
+        jack_client_t *client;
+        jack_port_t *ports[MAX_CHANNELS];
+        float *buffers[MAX_CHANNELS];
+        unsigned int portCount;
+        // Largest block soloud was set up to mix in one go
+        unsigned int maxFrames;
+        Soloud *soloud;
+    };
+
+    static void jack_cleanup(Soloud *aSoloud)
     {
-        jack_client_close(client);
+        JackData *data = (JackData*)aSoloud->mBackendData;
+        if (data == 0)
+            return;
+        if (data->client)
+        {
+            jack_deactivate(data->client);
+            jack_client_close(data->client);
+        }
+        delete data;
+        aSoloud->mBackendData = 0;
     }
 
-    int jack_callback(jack_nframes_t nframes, void* arg) {
-        Soloud* soloud = (Soloud*) arg;
-        jack_nframes_t dataLength = nframes * portCount;
-        jack_nframes_t samples = nframes;
-
-        jack_default_audio_sample_t data[dataLength];
-        soloud->mix(data, samples);
-
-        for (int i = 0; i < portCount; i++) {
-            jack_default_audio_sample_t* buf = (jack_default_audio_sample_t*) jack_port_get_buffer(ports[i], samples);
-            // de-interlaces the samples into each port buffer 121212 -> {111} {222}
-            int c = 0;
-            for (int j = i; j < dataLength; j += portCount) {
-                buf[c] = data[j];
-                c++;
-            }
+    static int jack_callback(jack_nframes_t nframes, void* arg)
+    {
+        JackData *data = (JackData*)arg;
+        unsigned int i;
+        for (i = 0; i < data->portCount; i++)
+        {
+            data->buffers[i] = (float*)jack_port_get_buffer(data->ports[i], nframes);
         }
 
+        // Mix straight into the port buffers; blocks larger than the
+        // mixer was set up for are mixed in pieces.
+        unsigned int done = 0;
+        while (done < nframes)
+        {
+            unsigned int frames = nframes - done;
+            if (frames > data->maxFrames)
+                frames = data->maxFrames;
+            float *buffers[MAX_CHANNELS];
+            for (i = 0; i < data->portCount; i++)
+                buffers[i] = data->buffers[i] + done;
+            data->soloud->mixPlanar(buffers, frames);
+            done += frames;
+        }
+        return 0;
+    }
+
+    static int jack_buffer_size_callback(jack_nframes_t nframes, void* arg)
+    {
+        JackData *data = (JackData*)arg;
+        // The process callback splits blocks bigger than maxFrames, so
+        // only the reported size needs to follow.
+        data->soloud->lockAudioMutex_internal();
+        data->soloud->mBufferSize = nframes < data->maxFrames ? nframes : data->maxFrames;
+        data->soloud->unlockAudioMutex_internal();
+        return 0;
+    }
+
+    static int jack_sample_rate_callback(jack_nframes_t nframes, void* arg)
+    {
+        JackData *data = (JackData*)arg;
+        data->soloud->lockAudioMutex_internal();
+        data->soloud->mSamplerate = nframes;
+        data->soloud->unlockAudioMutex_internal();
         return 0;
     }
 
     result jack_init(Soloud *aSoloud, unsigned int aFlags, unsigned int aSamplerate, unsigned int aBuffer, unsigned int aChannels)
     {
+        JackData *data = new JackData;
+        memset(data, 0, sizeof(JackData));
+        data->soloud = aSoloud;
+        aSoloud->mBackendData = data;
         aSoloud->mBackendCleanupFunc = jack_cleanup;
 
         // Starting Jack client
-        if ((client = jack_client_open("Solound_Audio", JackNullOption, NULL)) == 0) return UNKNOWN_ERROR;
+        if ((data->client = jack_client_open("Solound_Audio", JackNullOption, NULL)) == 0) return UNKNOWN_ERROR;
         aChannels = aChannels == 0 ? 1 : aChannels; // default to 1 channel if none are provided
-        portCount = aChannels;
-        ports = new jack_port_t*[portCount];
+        data->portCount = aChannels;
         // Registerring JACK Ports
-        for (int i = 0; i < portCount; i++)
+        unsigned int i;
+        for (i = 0; i < data->portCount; i++)
         {
-            ports[i] = jack_port_register(client, ("channel_" + std::to_string(i + 1)).c_str(), JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
+            char name[32];
+            snprintf(name, sizeof(name), "channel_%d", i + 1);
+            data->ports[i] = jack_port_register(data->client, name, JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
+            if (data->ports[i] == 0) return UNKNOWN_ERROR;
         }
 
+        // The server decides the rate and the block size
+        aSamplerate = jack_get_sample_rate(data->client);
+        jack_nframes_t blocksize = jack_get_buffer_size(data->client);
+        if (aBuffer < blocksize)
+            aBuffer = blocksize;
+        data->maxFrames = aBuffer;
+        aSoloud->postinit_internal(aSamplerate, aBuffer, aFlags, aChannels);
+
         // Activating Jack client
-        jack_set_process_callback(client, jack_callback, (void*) aSoloud);
-        if (jack_activate(client)) return UNKNOWN_ERROR;
+        jack_set_process_callback(data->client, jack_callback, (void*)data);
+        jack_set_buffer_size_callback(data->client, jack_buffer_size_callback, (void*)data);
+        jack_set_sample_rate_callback(data->client, jack_sample_rate_callback, (void*)data);
+        if (jack_activate(data->client)) return UNKNOWN_ERROR;
 
         // Connecting to audio ports
-        const char** audioPorts = jack_get_ports(client, NULL, JACK_DEFAULT_AUDIO_TYPE, JackPortIsPhysical | JackPortIsInput);
+        const char** audioPorts = jack_get_ports(data->client, NULL, JACK_DEFAULT_AUDIO_TYPE, JackPortIsPhysical | JackPortIsInput);
         if (audioPorts == NULL)
         {
             return UNKNOWN_ERROR; // Cannot find any physical audio playback ports
@@ -96,12 +155,12 @@ namespace SoLoud
         {
             for (int n = 0; audioPorts[n] != NULL; n++)
             {
-                int m = jack_connect(client, jack_port_name(ports[n % portCount]), audioPorts[n]);
+                int m = jack_connect(data->client, jack_port_name(data->ports[n % data->portCount]), audioPorts[n]);
                 // if (m) // Warning, cannot connect to audio output
             }
+            jack_free(audioPorts);
         }
 
-        aSoloud->postinit_internal(aSamplerate, aBuffer, aFlags, aChannels);
         aSoloud->mBackendString = "JACK driver";
         return SO_NO_ERROR;
     }
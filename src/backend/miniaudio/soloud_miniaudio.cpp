@@ -53,7 +53,10 @@ namespace SoLoud
     void soloud_miniaudio_audiomixer(ma_device* pDevice, void* pOutput, const void* pInput, ma_uint32 frameCount)
     {
         SoLoud::Soloud *soloud = (SoLoud::Soloud *)pDevice->pUserData;
-            soloud->mix((float *)pOutput, frameCount);
+        // Duplex devices hand us the input of this same cycle
+        if (pInput)
+            soloud->capture((const float *)pInput, frameCount);
+        soloud->mix((float *)pOutput, frameCount);
     }
 
     static void soloud_miniaudio_deinit(SoLoud::Soloud *aSoloud)
@@ -63,10 +66,12 @@ namespace SoLoud
 
     result miniaudio_init(SoLoud::Soloud *aSoloud, unsigned int aFlags, unsigned int aSamplerate, unsigned int aBuffer, unsigned int aChannels)
     {
-        ma_device_config config = ma_device_config_init(ma_device_type_playback);
+        ma_device_config config = ma_device_config_init((aFlags & Soloud::ENABLE_CAPTURE) ? ma_device_type_duplex : ma_device_type_playback);
         //config.periodSizeInFrames = aBuffer; // setting to aBuffer (like 2048) causes miniaudio to crash; let's just use the default.
         config.playback.format    = ma_format_f32;
         config.playback.channels  = aChannels;
+        config.capture.format     = ma_format_f32;
+        config.capture.channels   = 0; // device's own
         config.sampleRate         = aSamplerate;
         config.dataCallback       = soloud_miniaudio_audiomixer;
         config.pUserData          = (void *)aSoloud;
@@ -77,6 +82,14 @@ namespace SoLoud
         }
 
         aSoloud->postinit_internal(gDevice.sampleRate, gDevice.playback.internalPeriodSizeInFrames, aFlags, gDevice.playback.channels);
+        if (aFlags & Soloud::ENABLE_CAPTURE)
+        {
+            if (gDevice.capture.channels > MAX_CHANNELS || aSoloud->initCapture_internal(gDevice.capture.channels) != SO_NO_ERROR)
+            {
+                ma_device_uninit(&gDevice);
+                return UNKNOWN_ERROR;
+            }
+        }
 
         aSoloud->mBackendCleanupFunc = soloud_miniaudio_deinit;
 
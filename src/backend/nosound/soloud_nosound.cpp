@@ -29,7 +29,7 @@ freely, subject to the following restrictions:
 
 namespace SoLoud
 {
-	result nosound_init(Soloud *aSoloud, unsigned int aFlags, unsigned int aSamplerate, unsigned int aBuffer)
+	result nosound_init(Soloud *aSoloud, unsigned int aFlags, unsigned int aSamplerate, unsigned int aBuffer, unsigned int aChannels)
 	{
 		return NOT_IMPLEMENTED;
 	}
@@ -61,20 +61,31 @@ namespace SoLoud
     static void nosoundThread(void *aParam)
     {
         SoLoudNosoundData *data = static_cast<SoLoudNosoundData*>(aParam);
-		int delay = (1000 * data->mSamples) / data->mSamplerate;
-		int overflow = 0;
+		Soloud *soloud = data->mSoloud;
+		// Deadlines are computed from the start time and the number of
+		// samples mixed so far, so rounding errors don't accumulate.
+		long long start = Thread::getTimeNanos();
+		long long mixed = 0;
         while (data->mRunning) 
         {			
-			data->mSoloud->mix(data->mBuffer.mData, data->mSamples);            
-			int startwait = Thread::getTimeMillis() - overflow;
-			int t;
-			do
+			soloud->mix(data->mBuffer.mData, data->mSamples);
+			mixed += data->mSamples;
+			long long deadline = start + mixed * 1000000000LL / data->mSamplerate;
+			Thread::sleepUntil(deadline);
+			long long late = Thread::getTimeNanos() - deadline;
+			if (late > 1000000000LL)
 			{
-				Thread::sleep(1);
-				t = Thread::getTimeMillis() - startwait;
-			} 
-			while (t < delay);
-			overflow = t - delay;
+				// Over a second behind (debugger, suspend..); don't try to catch up.
+				soloud->mBackendXrunCount++;
+				start = Thread::getTimeNanos();
+				mixed = 0;
+				continue;
+			}
+			time latesec = late > 0 ? late / 1.0e9 : 0;
+			soloud->mBackendJitterSum += latesec;
+			if (latesec > soloud->mBackendJitterMax)
+				soloud->mBackendJitterMax = latesec;
+			soloud->mBackendJitterCount++;
         }
     }
 
@@ -105,15 +116,21 @@ namespace SoLoud
         data->mSoloud = aSoloud;
         data->mBuffer.init(data->mSamples * aChannels);
 		data->mRunning = true;
-        aSoloud->postinit_internal(aSamplerate, data->mSamples * aChannels, aFlags, aChannels);
-        data->mThreadHandle = Thread::createThread(nosoundThread, data);
+        aSoloud->postinit_internal(aSamplerate, data->mSamples, aFlags, aChannels);
+		aSoloud->mBackendString = "NoSound";
+		// With a virtual clock the application drives the mixing
+		if (aFlags & Soloud::VIRTUAL_CLOCK)
+		{
+			return 0;
+		}
+        ThreadAttributes threadAttributes = Thread::mixerThreadAttributes(aSoloud->mMixerThreadAttributes);
+        data->mThreadHandle = Thread::createThread(nosoundThread, data, &threadAttributes);
         if (0 == data->mThreadHandle)
         {
             return UNKNOWN_ERROR;
         }
-        aSoloud->mBackendString = "NoSound";
         return 0;
     }
 };
 
-#endif
\ No newline at end of file
+#endif
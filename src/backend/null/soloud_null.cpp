@@ -50,6 +50,13 @@ namespace SoLoud
         aSoloud->mBackendCleanupFunc = nullCleanup;
 
         aSoloud->postinit_internal(aSamplerate, aBuffer, aFlags, aChannels);
+        if (aFlags & Soloud::ENABLE_CAPTURE)
+        {
+            // Mono input, fed by the user with capture() or a stand-in source
+            result res = aSoloud->initCapture_internal(1);
+            if (res != SO_NO_ERROR)
+                return res;
+        }
         aSoloud->mBackendString = "null driver";
         return SO_NO_ERROR;
     }
@@ -186,7 +186,8 @@ namespace SoLoud
 
 		dll_al_SourcePlay(source);
 
-		Thread::createThread(openal_thread, (void*)aSoloud);
+		ThreadAttributes threadAttributes = Thread::mixerThreadAttributes(aSoloud->mMixerThreadAttributes);
+		Thread::createThread(openal_thread, (void*)aSoloud, &threadAttributes);
 
         aSoloud->mBackendString = "OpenAL";
 		return 0;
@@ -285,7 +285,8 @@ namespace SoLoud
 		aSoloud->mBackendCleanupFunc = soloud_opensles_deinit;
 
 		LOG_INFO( "Creating audio thread." );
-		Thread::createThread(opensles_thread, (void*)aSoloud);
+		ThreadAttributes threadAttributes = Thread::mixerThreadAttributes(aSoloud->mMixerThreadAttributes);
+		Thread::createThread(opensles_thread, (void*)aSoloud, &threadAttributes);
 
 		aSoloud->mBackendString = "OpenSL ES";
 		return SO_NO_ERROR;
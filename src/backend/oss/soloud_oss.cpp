@@ -55,7 +55,6 @@ namespace SoLoud
 
     struct OSSData
     {
-        float *buffer;
         short *sampleBuffer;
         int ossDeviceHandle;
         Soloud *soloud;
@@ -70,12 +69,7 @@ namespace SoLoud
         OSSData *data = static_cast<OSSData*>(aParam);
         while (!data->audioProcessingDone) 
         {
-            data->soloud->mix(data->buffer, data->samples);
-            for (int i=0;i<data->samples*data->channels;++i)
-            {
-                data->sampleBuffer[i] = static_cast<short>(floor(data->buffer[i] 
-                                                                 * static_cast<float>(0x7fff)));
-            }
+            data->soloud->mixSigned16(data->sampleBuffer, data->samples);
             write(data->ossDeviceHandle, data->sampleBuffer, 
                   sizeof(short)*data->samples*data->channels);
         }
@@ -99,10 +93,6 @@ namespace SoLoud
         {
             delete[] data->sampleBuffer;
         }
-        if (0 != data->buffer)
-        {
-            delete[] data->buffer;
-        }
         close(data->ossDeviceHandle);
         delete data;
         aSoloud->mBackendData = 0;
@@ -164,10 +154,10 @@ namespace SoLoud
         {
             return UNKNOWN_ERROR;
         }
-        data->buffer = new float[data->samples*data->channels];
         data->sampleBuffer = new short[data->samples*data->channels];
         aSoloud->postinit_internal(aSamplerate, data->samples * data->channels, aFlags, 2);
-        data->threadHandle = Thread::createThread(ossThread, data);
+        ThreadAttributes threadAttributes = Thread::mixerThreadAttributes(aSoloud->mMixerThreadAttributes);
+        data->threadHandle = Thread::createThread(ossThread, data, &threadAttributes);
         if (0 == data->threadHandle)
         {
             return UNKNOWN_ERROR;
@@ -363,7 +363,8 @@ namespace SoLoud
         data->channels = format.nChannels;
         data->soloud = aSoloud;
         aSoloud->postinit_internal(format.nSamplesPerSec, data->bufferFrames * format.nChannels, aFlags, 2);
-        data->thread = Thread::createThread(wasapiThread, data);
+        ThreadAttributes threadAttributes = Thread::mixerThreadAttributes(aSoloud->mMixerThreadAttributes);
+        data->thread = Thread::createThread(wasapiThread, data, &threadAttributes);
         if (0 == data->thread)
         {
             return UNKNOWN_ERROR;
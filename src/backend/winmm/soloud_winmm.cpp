@@ -195,7 +195,8 @@ namespace SoLoud
             }
         }
         aSoloud->postinit_internal(aSamplerate, data->samples * format.nChannels, aFlags, aChannels);
-        data->threadHandle = Thread::createThread(winMMThread, data);
+        ThreadAttributes threadAttributes = Thread::mixerThreadAttributes(aSoloud->mMixerThreadAttributes);
+        data->threadHandle = Thread::createThread(winMMThread, data, &threadAttributes);
         if (0 == data->threadHandle)
         {
             winMMCleanup(aSoloud);
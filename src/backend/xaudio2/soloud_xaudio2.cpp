@@ -233,7 +233,8 @@ namespace SoLoud
         data->samples = aBuffer;
         data->soloud = aSoloud;
         aSoloud->postinit_internal(aSamplerate, aBuffer * format.nChannels, aFlags, 2);
-        data->thread = Thread::createThread(xaudio2Thread, data);
+        ThreadAttributes threadAttributes = Thread::mixerThreadAttributes(aSoloud->mMixerThreadAttributes);
+        data->thread = Thread::createThread(xaudio2Thread, data, &threadAttributes);
         if (0 == data->thread)
         {
             return UNKNOWN_ERROR;
@@ -29,17 +29,19 @@ freely, subject to the following restrictions:
 #include "soloud_internal.h"
 #include "soloud_thread.h"
 #include "soloud_fft.h"
+#include "soloud_misc.h"
 
 
 #ifdef SOLOUD_SSE_INTRINSICS
 #include <xmmintrin.h>
-#ifdef _M_IX86
 #include <emmintrin.h>
 #endif
-#endif
 
 //#define FLOATING_POINT_DEBUG
 
+// End marker of the per-bus voice lists (see buildBusVoiceLists_internal)
+#define BUS_LIST_END 0xffffffff
+
 
 #if !defined(WITH_SDL2) && !defined(WITH_SDL1) && !defined(WITH_PORTAUDIO) && \
    !defined(WITH_OPENAL) && !defined(WITH_XAUDIO2) && !defined(WITH_WINMM) && \
@@ -115,6 +117,11 @@ namespace SoLoud
 		mBackendData = NULL;
 		mAudioThreadMutex = NULL;
 		mPostClipScaler = 0;
+		mDitherState[0] = 0x9e3779b9;
+		mDitherState[1] = 0x7f4a7c15;
+		mDitherState[2] = 0x85ebca6b;
+		mDitherState[3] = 0xc2b2ae35;
+		mSimdPath = simd_detect_path();
 		mBackendCleanupFunc = NULL;
 		mBackendPauseFunc = NULL;
 		mBackendResumeFunc = NULL;
@@ -124,11 +131,42 @@ namespace SoLoud
 		mAudioSourceID = 1;
 		mBackendString = 0;
 		mBackendID = 0;
+		mBackendXrunCount = 0;
+		mBackendJitterSum = 0;
+		mBackendJitterMax = 0;
+		mBackendJitterCount = 0;
+		mVirtualClockPending = 0;
 		mActiveVoiceDirty = true;
+		mProfiling = false;
+		mProfileStage = ProfileFrame::OTHER;
+		mProfileMark = 0;
+		mProfileXrunCount = 0;
+		mProfileWriteIndex = 0;
+		memset(&mProfileFrame, 0, sizeof(mProfileFrame));
+		memset(mSourceCost, 0, sizeof(mSourceCost));
+		mSourceCostNested = 0;
+		mCostTrace = 0;
+		mCostTraceCount = 0;
+		mCostTraceMax = 0;
+		mVoiceMeter = new VoiceMeterSlot[VOICE_COUNT];
+		memset(mVoiceMeter, 0, sizeof(VoiceMeterSlot) * VOICE_COUNT);
+		mCaptureRing = 0;
+		mCaptureRingFrames = 0;
+		mCaptureChannels = 0;
+		mCaptureWrite = 0;
+		mCaptureMixPos = 0;
+		mCaptureStandIn = 0;
 		mActiveVoiceCount = 0;
 		int i;
 		for (i = 0; i < VOICE_COUNT; i++)
 			mActiveVoice[i] = 0;
+		for (i = 0; i < VOICE_COUNT + 1; i++)
+			mBusFirstVoice[i] = BUS_LIST_END;
+		for (i = 0; i < VOICE_CATEGORY_COUNT; i++)
+		{
+			mCategoryLimit[i] = 0;
+			mCategoryLimitSteal[i] = true;
+		}
 		for (i = 0; i < FILTERS_PER_STREAM; i++)
 		{
 			mFilter[i] = NULL;
@@ -187,6 +225,8 @@ namespace SoLoud
 		delete[] mVoiceGroup;
 		delete[] mResampleData;
 		delete[] mResampleDataOwner;
+		delete[] mCostTrace;
+		delete[] mVoiceMeter;
 	}
 
 	void Soloud::deinit()
@@ -199,12 +239,47 @@ namespace SoLoud
 		if (mBackendCleanupFunc)
 			mBackendCleanupFunc(this);
 		mBackendCleanupFunc = 0;
+		delete mCaptureStandIn;
+		mCaptureStandIn = 0;
+		delete[] mCaptureRing;
+		mCaptureRing = 0;
+		mCaptureChannels = 0;
 		if (mAudioThreadMutex)
 			Thread::destroyMutex(mAudioThreadMutex);
 		mAudioThreadMutex = NULL;
 	}
 
+	ThreadAttributes::ThreadAttributes()
+	{
+		mPriority = PRIORITY_DEFAULT;
+		mRealtimePriority = 0;
+		mAffinityMask = 0;
+		mStackSize = 0;
+		mName = 0;
+	}
+
+	InitConfig::InitConfig()
+	{
+		mFlags = Soloud::CLIP_ROUNDOFF;
+		mBackend = Soloud::AUTO;
+		mSamplerate = Soloud::AUTO;
+		mBufferSize = Soloud::AUTO;
+		mChannels = 2;
+	}
+
 	result Soloud::init(unsigned int aFlags, unsigned int aBackend, unsigned int aSamplerate, unsigned int aBufferSize, unsigned int aChannels)
+	{
+		mMixerThreadAttributes = ThreadAttributes();
+		return init_internal(aFlags, aBackend, aSamplerate, aBufferSize, aChannels);
+	}
+
+	result Soloud::init(const InitConfig &aConfig)
+	{
+		mMixerThreadAttributes = aConfig.mMixerThread;
+		return init_internal(aConfig.mFlags, aConfig.mBackend, aConfig.mSamplerate, aConfig.mBufferSize, aConfig.mChannels);
+	}
+
+	result Soloud::init_internal(unsigned int aFlags, unsigned int aBackend, unsigned int aSamplerate, unsigned int aBufferSize, unsigned int aChannels)
 	{		
 		if (aBackend >= BACKEND_MAX || aChannels == 3 || aChannels == 5 || aChannels == 7 || aChannels > MAX_CHANNELS)
 			return INVALID_PARAMETER;
@@ -215,6 +290,13 @@ namespace SoLoud
 
 		mBackendID = 0;
 		mBackendString = 0;
+		mBackendXrunCount = 0;
+		mBackendJitterSum = 0;
+		mBackendJitterMax = 0;
+		mBackendJitterCount = 0;
+		mVirtualClockPending = 0;
+		mProfileXrunCount = 0;
+		mProfileWriteIndex = 0;
 
 		int samplerate = 44100;
 		int buffersize = 2048;
@@ -767,174 +849,12 @@ namespace SoLoud
 		return mFFTData;
 	}
 
-#if defined(SOLOUD_SSE_INTRINSICS)
-	void Soloud::clip_internal(AlignedFloatBuffer &aBuffer, AlignedFloatBuffer &aDestBuffer, unsigned int aSamples, float aVolume0, float aVolume1)
+	void Soloud::clip_internal(AlignedFloatBuffer &aBuffer, float *aDestBuffer, unsigned int aSamples, unsigned int aStride, float aVolume0, float aVolume1, bool aInterleave)
 	{
-		float vd = (aVolume1 - aVolume0) / aSamples;
-		float v = aVolume0;
-		unsigned int i, j, c, d;
-		unsigned int samplequads = (aSamples + 3) / 4; // rounded up
-
-		// Clip
-		if (mFlags & CLIP_ROUNDOFF)
-		{
-			float nb = -1.65f;		__m128 negbound = _mm_load_ps1(&nb);
-			float pb = 1.65f;		__m128 posbound = _mm_load_ps1(&pb);
-			float ls = 0.87f;		__m128 linearscale = _mm_load_ps1(&ls);
-			float cs = -0.1f;		__m128 cubicscale = _mm_load_ps1(&cs);
-			float nw = -0.9862875f;	__m128 negwall = _mm_load_ps1(&nw);
-			float pw = 0.9862875f;	__m128 poswall = _mm_load_ps1(&pw);
-			__m128 postscale = _mm_load_ps1(&mPostClipScaler);
-			TinyAlignedFloatBuffer volumes;
-			volumes.mData[0] = v;
-			volumes.mData[1] = v + vd;
-			volumes.mData[2] = v + vd + vd;
-			volumes.mData[3] = v + vd + vd + vd;
-			vd *= 4;
-			__m128 vdelta = _mm_load_ps1(&vd);
-			c = 0;
-			d = 0;
-			for (j = 0; j < mChannels; j++)
-			{
-				__m128 vol = _mm_load_ps(volumes.mData);
-
-				for (i = 0; i < samplequads; i++)
-				{
-					//float f1 = origdata[c] * v;	c++; v += vd;
-					__m128 f = _mm_load_ps(&aBuffer.mData[c]);
-					c += 4;
-					f = _mm_mul_ps(f, vol);
-					vol = _mm_add_ps(vol, vdelta);
-
-					//float u1 = (f1 > -1.65f);
-					__m128 u = _mm_cmpgt_ps(f, negbound);
-
-					//float o1 = (f1 < 1.65f);
-					__m128 o = _mm_cmplt_ps(f, posbound);
-
-					//f1 = (0.87f * f1 - 0.1f * f1 * f1 * f1) * u1 * o1;
-					__m128 lin = _mm_mul_ps(f, linearscale);
-					__m128 cubic = _mm_mul_ps(f, f);
-					cubic = _mm_mul_ps(cubic, f);
-					cubic = _mm_mul_ps(cubic, cubicscale);
-					f = _mm_add_ps(cubic, lin);
-
-					//f1 = f1 * u1 + !u1 * -0.9862875f;
-					__m128 lowmask = _mm_andnot_ps(u, negwall);
-					__m128 ilowmask = _mm_and_ps(u, f);
-					f = _mm_add_ps(lowmask, ilowmask);
-
-					//f1 = f1 * o1 + !o1 * 0.9862875f;
-					__m128 himask = _mm_andnot_ps(o, poswall);
-					__m128 ihimask = _mm_and_ps(o, f);
-					f = _mm_add_ps(himask, ihimask);
-
-					// outdata[d] = f1 * postclip; d++;
-					f = _mm_mul_ps(f, postscale);
-					_mm_store_ps(&aDestBuffer.mData[d], f);
-					d += 4;
-				}
-			}
-		}
-		else
-		{
-			float nb = -1.0f;	__m128 negbound = _mm_load_ps1(&nb);
-			float pb = 1.0f;	__m128 posbound = _mm_load_ps1(&pb);
-			__m128 postscale = _mm_load_ps1(&mPostClipScaler);
-			TinyAlignedFloatBuffer volumes;
-			volumes.mData[0] = v;
-			volumes.mData[1] = v + vd;
-			volumes.mData[2] = v + vd + vd;
-			volumes.mData[3] = v + vd + vd + vd;
-			vd *= 4;
-			__m128 vdelta = _mm_load_ps1(&vd);
-			c = 0;
-			d = 0;
-			for (j = 0; j < mChannels; j++)
-			{
-				__m128 vol = _mm_load_ps(volumes.mData);
-				for (i = 0; i < samplequads; i++) 
-				{
-					//float f1 = aBuffer.mData[c] * v; c++; v += vd;
-					__m128 f = _mm_load_ps(&aBuffer.mData[c]);
-					c += 4;
-					f = _mm_mul_ps(f, vol);
-					vol = _mm_add_ps(vol, vdelta);
-
-					//f1 = (f1 <= -1) ? -1 : (f1 >= 1) ? 1 : f1;
-					f = _mm_max_ps(f, negbound);
-					f = _mm_min_ps(f, posbound);
-
-					//aDestBuffer.mData[d] = f1 * mPostClipScaler; d++;
-					f = _mm_mul_ps(f, postscale);
-					_mm_store_ps(&aDestBuffer.mData[d], f);
-					d += 4;
-				}
-			}
-		}
+		// The volume ramp always spans the whole stride, so planar and interleaved output match.
+		float vd = (aVolume1 - aVolume0) / aStride;
+		clip_samples(mSimdPath, aBuffer.mData, aDestBuffer, aSamples, mChannels, aStride, aInterleave, (mFlags & CLIP_ROUNDOFF) != 0, aVolume0, vd, mPostClipScaler);
 	}
-#else // fallback code
-	void Soloud::clip_internal(AlignedFloatBuffer &aBuffer, AlignedFloatBuffer &aDestBuffer, unsigned int aSamples, float aVolume0, float aVolume1)
-	{
-		float vd = (aVolume1 - aVolume0) / aSamples;
-		float v = aVolume0;
-		unsigned int i, j, c, d;
-		unsigned int samplequads = (aSamples + 3) / 4; // rounded up
-		// Clip
-		if (mFlags & CLIP_ROUNDOFF)
-		{
-			c = 0;
-			d = 0;
-			for (j = 0; j < mChannels; j++)
-			{
-				v = aVolume0;
-				for (i = 0; i < samplequads; i++)
-				{
-					float f1 = aBuffer.mData[c] * v; c++; v += vd;
-					float f2 = aBuffer.mData[c] * v; c++; v += vd;
-					float f3 = aBuffer.mData[c] * v; c++; v += vd;
-					float f4 = aBuffer.mData[c] * v; c++; v += vd;
-
-					f1 = (f1 <= -1.65f) ? -0.9862875f : (f1 >= 1.65f) ? 0.9862875f : (0.87f * f1 - 0.1f * f1 * f1 * f1);
-					f2 = (f2 <= -1.65f) ? -0.9862875f : (f2 >= 1.65f) ? 0.9862875f : (0.87f * f2 - 0.1f * f2 * f2 * f2);
-					f3 = (f3 <= -1.65f) ? -0.9862875f : (f3 >= 1.65f) ? 0.9862875f : (0.87f * f3 - 0.1f * f3 * f3 * f3);
-					f4 = (f4 <= -1.65f) ? -0.9862875f : (f4 >= 1.65f) ? 0.9862875f : (0.87f * f4 - 0.1f * f4 * f4 * f4);
-
-					aDestBuffer.mData[d] = f1 * mPostClipScaler; d++;
-					aDestBuffer.mData[d] = f2 * mPostClipScaler; d++;
-					aDestBuffer.mData[d] = f3 * mPostClipScaler; d++;
-					aDestBuffer.mData[d] = f4 * mPostClipScaler; d++;
-				}
-			}
-		}
-		else
-		{
-			c = 0;
-			d = 0;
-			for (j = 0; j < mChannels; j++)
-			{
-				v = aVolume0;
-				for (i = 0; i < samplequads; i++) 
-				{
-					float f1 = aBuffer.mData[c] * v; c++; v += vd;
-					float f2 = aBuffer.mData[c] * v; c++; v += vd;
-					float f3 = aBuffer.mData[c] * v; c++; v += vd;
-					float f4 = aBuffer.mData[c] * v; c++; v += vd;
-
-					f1 = (f1 <= -1) ? -1 : (f1 >= 1) ? 1 : f1;
-					f2 = (f2 <= -1) ? -1 : (f2 >= 1) ? 1 : f2;
-					f3 = (f3 <= -1) ? -1 : (f3 >= 1) ? 1 : f3;
-					f4 = (f4 <= -1) ? -1 : (f4 >= 1) ? 1 : f4;
-
-					aDestBuffer.mData[d] = f1 * mPostClipScaler; d++;
-					aDestBuffer.mData[d] = f2 * mPostClipScaler; d++;
-					aDestBuffer.mData[d] = f3 * mPostClipScaler; d++;
-					aDestBuffer.mData[d] = f4 * mPostClipScaler; d++;
-			}
-		}
-	}
-}
-#endif
 
 #define FIXPOINT_FRAC_BITS 20
 #define FIXPOINT_FRAC_MUL (1 << FIXPOINT_FRAC_BITS)
@@ -1050,13 +970,44 @@ namespace SoLoud
 
 
 
-	void panAndExpand(AudioSourceInstance *aVoice, float *aBuffer, unsigned int aSamplesToRead, unsigned int aBufferSize, float *aScratch, unsigned int aChannels)
+	// Update the peak and RMS envelopes of a voice from the block about to be panned.
+	// The levels are taken after the voice volume and before panning.
+	static void meterVoice(AudioSourceInstance *aVoice, const float *aScratch, unsigned int aSamples, unsigned int aBufferSize, float aSamplerate)
+	{
+		float blocktime = aSamples / aSamplerate;
+		// Peaks fall by 20dB in about 1.5 seconds; RMS averages over about 300ms
+		float peakdecay = (float)exp(-blocktime / 0.65f);
+		float rmsweight = 1 - (float)exp(-blocktime / 0.3f);
+		float gain = aVoice->mOverallVolume;
+		unsigned int j, k;
+		for (k = 0; k < aVoice->mChannels; k++)
+		{
+			const float *src = aScratch + k * aBufferSize;
+			float peak = 0, sum = 0;
+			for (j = 0; j < aSamples; j++)
+			{
+				float s = src[j];
+				sum += s * s;
+				s = (float)fabs(s);
+				if (s > peak)
+					peak = s;
+			}
+			peak *= gain;
+			aVoice->mMeterPeak[k] = peak > aVoice->mMeterPeak[k] * peakdecay ? peak : aVoice->mMeterPeak[k] * peakdecay;
+			aVoice->mMeterMeanSquare[k] += (sum * gain * gain / aSamples - aVoice->mMeterMeanSquare[k]) * rmsweight;
+		}
+	}
+
+	void panAndExpand(AudioSourceInstance *aVoice, float *aBuffer, unsigned int aSamplesToRead, unsigned int aBufferSize, float *aScratch, unsigned int aChannels, float aSamplerate)
 	{
 #ifdef SOLOUD_SSE_INTRINSICS
 		SOLOUD_ASSERT(((size_t)aBuffer & 0xf) == 0);
 		SOLOUD_ASSERT(((size_t)aScratch & 0xf) == 0);
 		SOLOUD_ASSERT(((size_t)aBufferSize & 0xf) == 0);
 #endif
+		if ((aVoice->mFlags & AudioSourceInstance::METERING) && aSamplesToRead > 0)
+			meterVoice(aVoice, aScratch, aSamplesToRead, aBufferSize, aSamplerate);
+
 		float pan[MAX_CHANNELS]; // current speaker volume
 		float pand[MAX_CHANNELS]; // destination speaker volume
 		float pani[MAX_CHANNELS]; // speaker volume increment per sample
@@ -1599,7 +1550,137 @@ namespace SoLoud
 			aVoice->mCurrentChannelVolume[k] = pand[k];
 	}
 
-	void Soloud::mixBus_internal(float *aBuffer, unsigned int aSamplesToRead, unsigned int aBufferSize, float *aScratch, unsigned int aBus, float aSamplerate, unsigned int aChannels, unsigned int aResampler)
+	// Charges the time spent in its scope to a profiler stage
+	struct ProfileScope
+	{
+		Soloud *mSoloud;
+		unsigned int mPrevious;
+
+		ProfileScope(Soloud *aSoloud, unsigned int aStage)
+		{
+			mSoloud = 0;
+			mPrevious = 0;
+			if (aSoloud->mProfiling)
+			{
+				mSoloud = aSoloud;
+				mPrevious = aSoloud->profileStage_internal(aStage);
+			}
+		}
+
+		~ProfileScope()
+		{
+			if (mSoloud)
+				mSoloud->profileStage_internal(mPrevious);
+		}
+	};
+
+	// Charges a voice's getAudio and filter time to its audio source. Time
+	// charged by voices mixed inside it (a bus) is subtracted.
+	struct SourceCostScope
+	{
+		Soloud *mSoloud;
+		unsigned int mAudioSourceID;
+		long long mBefore;
+		long long mStart;
+		long long mNested;
+
+		static long long stageNanos(Soloud *aSoloud)
+		{
+			return aSoloud->mProfileFrame.mStageNanos[ProfileFrame::GETAUDIO] +
+				aSoloud->mProfileFrame.mStageNanos[ProfileFrame::VOICE_FILTERS] +
+				aSoloud->mProfileFrame.mStageNanos[ProfileFrame::BUS_FILTERS];
+		}
+
+		SourceCostScope(Soloud *aSoloud, AudioSourceInstance *aVoice)
+		{
+			mSoloud = 0;
+			if (aSoloud->mProfiling)
+			{
+				// The voice may be stopped (and deleted) before we're done
+				mSoloud = aSoloud;
+				mAudioSourceID = aVoice->mAudioSourceID;
+				mBefore = stageNanos(aSoloud);
+				mStart = aSoloud->mProfileMark;
+				mNested = aSoloud->mSourceCostNested;
+				aSoloud->mSourceCostNested = 0;
+			}
+		}
+
+		~SourceCostScope()
+		{
+			if (mSoloud)
+			{
+				long long spent = stageNanos(mSoloud) - mBefore;
+				long long own = spent - mSoloud->mSourceCostNested;
+				mSoloud->mSourceCostNested = mNested + spent;
+				mSoloud->addSourceCost_internal(mAudioSourceID, own, mStart, mSoloud->mProfileMark);
+			}
+		}
+	};
+
+	unsigned int Soloud::profileStage_internal(unsigned int aStage)
+	{
+		long long now = Thread::getTimeNanos();
+		unsigned int previous = mProfileStage;
+		mProfileFrame.mStageNanos[previous] += now - mProfileMark;
+		mProfileMark = now;
+		mProfileStage = aStage;
+		return previous;
+	}
+
+	void Soloud::buildBusVoiceLists_internal()
+	{
+		unsigned int i;
+		for (i = 0; i <= mHighestVoice; i++)
+			mBusFirstVoice[i] = BUS_LIST_END;
+
+		// Walk backwards so that the lists keep the active voice order
+		i = mActiveVoiceCount;
+		while (i > 0)
+		{
+			i--;
+			AudioSourceInstance *voice = mVoice[mActiveVoice[i]];
+			if (!voice)
+				continue;
+			unsigned int bus = 0;
+			if (voice->mBusHandle)
+			{
+				// Voices on a bus that is gone don't play anywhere
+				bus = voice->mBusHandle & 0xfff;
+				AudioSourceInstance *businstance = mVoice[bus - 1];
+				if (businstance == 0 ||
+					!(businstance->mFlags & AudioSourceInstance::BUS) ||
+					(businstance->mPlayIndex & 0xfffff) != (voice->mBusHandle >> 12))
+					continue;
+			}
+			mBusNextVoice[i] = mBusFirstVoice[bus];
+			mBusFirstVoice[bus] = i;
+		}
+	}
+
+	void Soloud::mixSends_internal(AudioSourceInstance *aVoice, const float *aScratch, unsigned int aSamples, unsigned int aBufferSize, time aBlockTime, float aSamplerate)
+	{
+		unsigned int k;
+		for (k = 0; k < SENDS_PER_VOICE; k++)
+		{
+			if (aVoice->mSendBus[k] == 0)
+				continue;
+			float from = aVoice->mCurrentSendVolume[k];
+			float to = aVoice->mSendVolume[k] * aVoice->mOverallVolume;
+			int bus = getVoiceFromHandle_internal(aVoice->mSendBus[k]);
+			if (bus == -1 || !(mVoice[bus]->mFlags & AudioSourceInstance::BUS) || (from == 0 && aVoice->mSendVolume[k] == 0))
+			{
+				// The bus is gone, or the send has faded out
+				aVoice->mSendBus[k] = 0;
+				aVoice->mCurrentSendVolume[k] = 0;
+				continue;
+			}
+			((BusInstance *)mVoice[bus])->accumulateSend(aScratch, aVoice->mChannels, aSamples, aBufferSize, aBlockTime, aSamplerate, from, to, aVoice->mSendState[k]);
+			aVoice->mCurrentSendVolume[k] = to;
+		}
+	}
+
+	void Soloud::mixBus_internal(float *aBuffer, unsigned int aSamplesToRead, unsigned int aBufferSize, float *aScratch, unsigned int aBus, float aSamplerate, unsigned int aChannels, unsigned int aResampler, time aBlockTime)
 	{
 		unsigned int i, j;
 		// Clear accumulation buffer
@@ -1612,14 +1693,14 @@ namespace SoLoud
 		}
 
 		// Accumulate sound sources		
-		for (i = 0; i < mActiveVoiceCount; i++)
+		for (i = mBusFirstVoice[aBus & 0xfff]; i != BUS_LIST_END; i = mBusNextVoice[i])
 		{
 			AudioSourceInstance *voice = mVoice[mActiveVoice[i]];
 			if (voice &&
-				voice->mBusHandle == aBus &&
 				!(voice->mFlags & AudioSourceInstance::PAUSED) &&
 				!(voice->mFlags & AudioSourceInstance::INAUDIBLE))
 			{
+				SourceCostScope cost(this, voice);
 				float step = voice->mSamplerate / aSamplerate;
 				// avoid step overflow
 				if (step > (1 << (32 - FIXPOINT_FRAC_BITS)))
@@ -1660,8 +1741,11 @@ namespace SoLoud
 						// Get a block of source data
 
 						int readcount = 0;
+						if (voice->mFlags & AudioSourceInstance::BUS)
+							((BusInstance *)voice)->mBlockTime = aBlockTime + outofs / aSamplerate;
 						if (!voice->hasEnded() || voice->mFlags & AudioSourceInstance::LOOPING)
 						{
+							ProfileScope profile(this, ProfileFrame::GETAUDIO);
 							readcount = voice->getAudio(voice->mResampleData[0], SAMPLE_GRANULARITY, SAMPLE_GRANULARITY);
 							if (readcount < SAMPLE_GRANULARITY)
 							{
@@ -1676,6 +1760,20 @@ namespace SoLoud
 									}
 								}
 							}
+
+							// Loudness of the source data, used to rank the voices
+							if (readcount > 0)
+							{
+								float sum = 0;
+								unsigned int k, n;
+								for (k = 0; k < voice->mChannels; k++)
+								{
+									const float *src = voice->mResampleData[0] + k * SAMPLE_GRANULARITY;
+									for (n = 0; n < (unsigned int)readcount; n++)
+										sum += src[n] * src[n];
+								}
+								voice->mRecentRMS = (voice->mRecentRMS + (float)sqrt(sum / (readcount * voice->mChannels))) * 0.5f;
+							}
 						}
 
                         // Clear remaining of the resample data if the full scratch wasn't used
@@ -1700,19 +1798,14 @@ namespace SoLoud
 					
 						// Run the per-stream filters to get our source data
 
-						for (j = 0; j < FILTERS_PER_STREAM; j++)
-						{
-							if (voice->mFilter[j])
-							{
-								voice->mFilter[j]->filter(
-									voice->mResampleData[0],
-									SAMPLE_GRANULARITY,
-									SAMPLE_GRANULARITY,
-									voice->mChannels,
-									voice->mSamplerate,
-									mStreamTime);
-							}
-						}
+						ProfileScope profile(this, (voice->mFlags & AudioSourceInstance::BUS) ? ProfileFrame::BUS_FILTERS : ProfileFrame::VOICE_FILTERS);
+						filterChain_internal(
+							voice->mFilter,
+							voice->mResampleData[0],
+							SAMPLE_GRANULARITY,
+							SAMPLE_GRANULARITY,
+							voice->mChannels,
+							voice->mSamplerate);
 					}
 					else
 					{
@@ -1744,6 +1837,7 @@ namespace SoLoud
 					// Call resampler to generate the samples, once per channel
 					if (writesamples)
 					{
+						ProfileScope profile(this, ProfileFrame::RESAMPLE);
 						for (j = 0; j < voice->mChannels; j++)
 						{
 							switch (aResampler)
@@ -1791,7 +1885,13 @@ namespace SoLoud
 				}
 				
 				// Handle panning and channel expansion (and/or shrinking)
-				panAndExpand(voice, aBuffer, aSamplesToRead, aBufferSize, aScratch, aChannels);
+				{
+					ProfileScope profile(this, ProfileFrame::PAN);
+					panAndExpand(voice, aBuffer, aSamplesToRead, aBufferSize, aScratch, aChannels, aSamplerate);
+					mixSends_internal(voice, aScratch, aSamplesToRead, aBufferSize, aBlockTime, aSamplerate);
+				}
+				if (voice->mFlags & AudioSourceInstance::METERING)
+					publishMeter_internal(mActiveVoice[i]);
 
 				// clear voice if the sound is over
 				if (!(voice->mFlags & (AudioSourceInstance::LOOPING | AudioSourceInstance::DISABLE_AUTOSTOP)) && voice->hasEnded())
@@ -1801,12 +1901,12 @@ namespace SoLoud
 			}
 			else
 				if (voice &&
-					voice->mBusHandle == aBus &&
 					!(voice->mFlags & AudioSourceInstance::PAUSED) &&
 					(voice->mFlags & AudioSourceInstance::INAUDIBLE) &&
 					(voice->mFlags & AudioSourceInstance::INAUDIBLE_TICK))
 			{
 				// Inaudible but needs ticking. Do minimal work (keep counters up to date and ask audiosource for data)
+				SourceCostScope cost(this, voice);
 				float step = voice->mSamplerate / aSamplerate;
 				int step_fixed = (int)floor(step * FIXPOINT_FRAC_MUL);
 				unsigned int outofs = 0;
@@ -1837,8 +1937,11 @@ namespace SoLoud
 						// Get a block of source data
 
 						int readcount = 0;
+						if (voice->mFlags & AudioSourceInstance::BUS)
+							((BusInstance *)voice)->mBlockTime = aBlockTime + outofs / aSamplerate;
 						if (!voice->hasEnded() || voice->mFlags & AudioSourceInstance::LOOPING)
 						{
+							ProfileScope profile(this, ProfileFrame::GETAUDIO);
 							readcount = voice->getAudio(voice->mResampleData[0], SAMPLE_GRANULARITY, SAMPLE_GRANULARITY);
 							if (readcount < SAMPLE_GRANULARITY)
 							{
@@ -1911,6 +2014,77 @@ namespace SoLoud
 		}
 	}
 
+	void Soloud::updateSidechain_internal(FilterInstance *aFilter)
+	{
+		int voiceno = getVoiceFromHandle_internal(aFilter->mSidechainHandle);
+		if (voiceno == -1 || !(mVoice[voiceno]->mFlags & AudioSourceInstance::BUS))
+		{
+			aFilter->mSidechainPeak = 0;
+			aFilter->mSidechainRMS = 0;
+			return;
+		}
+
+		BusInstance *bus = (BusInstance *)mVoice[voiceno];
+		aFilter->mSidechainPeak = bus->mSidechainPeak;
+		aFilter->mSidechainRMS = bus->mSidechainRMS;
+
+		if (!(bus->mFlags & AudioSourceInstance::SIDECHAIN_SOURCE))
+		{
+			// Flag the bus and every bus it plays through, so that calcActiveVoices_internal
+			// orders them before their siblings. Takes effect from the next mix.
+			while (voiceno != -1 && !(mVoice[voiceno]->mFlags & AudioSourceInstance::SIDECHAIN_SOURCE))
+			{
+				mVoice[voiceno]->mFlags |= AudioSourceInstance::SIDECHAIN_SOURCE;
+				voiceno = getVoiceFromHandle_internal(mVoice[voiceno]->mBusHandle);
+			}
+			mActiveVoiceDirty = true;
+		}
+	}
+
+	void Soloud::filterChain_internal(FilterInstance **aFilter, float *aBuffer, unsigned int aSamples, unsigned int aBufferSize, unsigned int aChannels, float aSamplerate)
+	{
+		// 0 = not checked, 1 = silent, 2 = not silent. Only needs checking again after a filter has run.
+		int silence = 0;
+		unsigned int i;
+		for (i = 0; i < FILTERS_PER_STREAM; i++)
+		{
+			FilterInstance *f = aFilter[i];
+			if (f == 0 || f->isBypassed())
+				continue;
+
+			if (silence == 0)
+				silence = Misc::isSilent(aBuffer, aSamples, aBufferSize, aChannels) ? 1 : 2;
+
+			if (silence == 1)
+			{
+				// Scheduled and smoothed changes need the filter to run to advance
+				bool skip = f->mEventCount == 0 && f->mSmoothingActive == 0 && (f->mFlushed || !f->hasTail());
+				if (f->mSilentSamples < 0x7fffffff)
+					f->mSilentSamples += aSamples;
+				if (skip)
+				{
+					// Nothing runs the filter until sound comes back, so it only needs asking once
+					if (!f->mFlushed)
+					{
+						f->onSilence();
+						f->mFlushed = true;
+					}
+					continue;
+				}
+			}
+			else
+			{
+				f->mSilentSamples = 0;
+			}
+
+			if (f->mSidechainHandle)
+				updateSidechain_internal(f);
+			f->filterBlock(aBuffer, aSamples, aBufferSize, aChannels, aSamplerate, mStreamTime);
+			f->mFlushed = false;
+			silence = 0;
+		}
+	}
+
 	void Soloud::mapResampleBuffers_internal()
 	{
 		SOLOUD_ASSERT(mMaxActiveVoices < 256);
@@ -1963,6 +2137,56 @@ namespace SoLoud
 		}
 	}
 
+	void Soloud::publishMeter_internal(unsigned int aVoice)
+	{
+		VoiceMeterSlot &slot = mVoiceMeter[aVoice];
+		AudioSourceInstance *voice = mVoice[aVoice];
+		slot.mSequence++;
+		Thread::memoryBarrier();
+		if (voice && (voice->mFlags & AudioSourceInstance::METERING))
+		{
+			unsigned int k;
+			for (k = 0; k < voice->mChannels; k++)
+			{
+				slot.mMeter.mPeak[k] = voice->mMeterPeak[k];
+				slot.mMeter.mRMS[k] = (float)sqrt(voice->mMeterMeanSquare[k]);
+			}
+			slot.mMeter.mChannels = voice->mChannels;
+			slot.mHandle = getHandleFromVoice_internal(aVoice);
+		}
+		else
+		{
+			slot.mHandle = 0;
+		}
+		Thread::memoryBarrier();
+		slot.mSequence++;
+	}
+
+	bool Soloud::isVoiceWeaker_internal(const AudioSourceInstance *aVoice, const AudioSourceInstance *aOther) const
+	{
+		if (aVoice->mPriority != aOther->mPriority)
+			return aVoice->mPriority < aOther->mPriority;
+		return aVoice->mOverallVolume * aVoice->mRecentRMS < aOther->mOverallVolume * aOther->mRecentRMS;
+	}
+
+	void Soloud::siftWeakestVoice_internal(unsigned int *aHeap, unsigned int aPos, unsigned int aCount)
+	{
+		for (;;)
+		{
+			unsigned int child = aPos * 2 + 1;
+			if (child >= aCount)
+				return;
+			if (child + 1 < aCount && isVoiceWeaker_internal(mVoice[aHeap[child + 1]], mVoice[aHeap[child]]))
+				child++;
+			if (!isVoiceWeaker_internal(mVoice[aHeap[child]], mVoice[aHeap[aPos]]))
+				return;
+			unsigned int temp = aHeap[aPos];
+			aHeap[aPos] = aHeap[child];
+			aHeap[child] = temp;
+			aPos = child;
+		}
+	}
+
 	void Soloud::calcActiveVoices_internal()
 	{
 		// TODO: consider whether we need to re-evaluate the active voices all the time.
@@ -1977,6 +2201,14 @@ namespace SoLoud
 		mustlive = 0;
 		for (i = 0; i < mHighestVoice; i++)
 		{
+			if (mVoice[i] && !(mVoice[i]->mFlags & AudioSourceInstance::PAUSED) &&
+				(mVoice[i]->mFlags & (AudioSourceInstance::INAUDIBLE | AudioSourceInstance::INAUDIBLE_TICK | AudioSourceInstance::FAST_SEEK)) ==
+				(AudioSourceInstance::INAUDIBLE | AudioSourceInstance::INAUDIBLE_TICK | AudioSourceInstance::FAST_SEEK))
+			{
+				// Inaudible but ticking; no need to mix it if it can just keep time
+				mVoice[i]->mFlags |= AudioSourceInstance::VIRTUAL;
+			}
+			else
 			if (mVoice[i] && (!(mVoice[i]->mFlags & (AudioSourceInstance::INAUDIBLE | AudioSourceInstance::PAUSED)) || (mVoice[i]->mFlags & AudioSourceInstance::INAUDIBLE_TICK)))
 			{
 				mActiveVoice[candidates] = i;
@@ -1990,11 +2222,26 @@ namespace SoLoud
 			}
 		}
 
+		// Sidechain sources (busses, which are always among the "must live" voices) go
+		// first, so they are mixed before any of their siblings that listen to them.
+		unsigned int sources = 0;
+		for (i = 0; i < mustlive; i++)
+		{
+			if (mVoice[mActiveVoice[i]]->mFlags & AudioSourceInstance::SIDECHAIN_SOURCE)
+			{
+				unsigned int temp = mActiveVoice[i];
+				mActiveVoice[i] = mActiveVoice[sources];
+				mActiveVoice[sources] = temp;
+				sources++;
+			}
+		}
+
 		// Check for early out
 		if (candidates <= mMaxActiveVoices)
 		{
 			// everything is audible, early out
 			mActiveVoiceCount = candidates;
+			updateVirtualVoices_internal(candidates);
 			mapResampleBuffers_internal();
 			return;
 		}
@@ -2007,52 +2254,72 @@ namespace SoLoud
 			// ate all our active voice slots.
 			// This is a potentially an error situation, but we have no way to report
 			// error from here. And asserting could be bad, too.
+			updateVirtualVoices_internal(candidates);
 			return;
 		}
 
-		// If we get this far, there's nothing to it: we'll have to sort the voices to find the most audible.
-
-		// Iterative partial quicksort:
-		int left = 0, stack[24], pos = 0, right;
-		int len = candidates - mustlive;
+		// If we get this far, we'll have to pick the most important voices. Keep the
+		// best ones found so far in a heap with the weakest on top, so this costs
+		// n log k instead of a sort of all candidates.
 		unsigned int *data = mActiveVoice + mustlive;
-		int k = mActiveVoiceCount;
-		for (;;) 
-		{                                 
-			for (; left + 1 < len; len++) 
-			{                
-				if (pos == 24) len = stack[pos = 0]; 
-				int pivot = data[left];
-				float pivotvol = mVoice[pivot]->mOverallVolume;
-				stack[pos++] = len;      
-				for (right = left - 1;;) 
-				{
-					do 
-					{
-						right++;
-					} 
-					while (mVoice[data[right]]->mOverallVolume > pivotvol);
-					do
-					{
-						len--;
-					}
-					while (pivotvol > mVoice[data[len]]->mOverallVolume);
-					if (right >= len) break;       
-					int temp = data[right];
-					data[right] = data[len];
-					data[len] = temp;
-				}                        
-			}
-			if (pos == 0) break;         
-			if (left >= k) break;
-			left = len;                  
-			len = stack[--pos];          
-		}	
-		// TODO: should the rest of the voices be flagged INAUDIBLE?
+		unsigned int len = candidates - mustlive;
+		unsigned int k = mActiveVoiceCount - mustlive;
+		for (i = k / 2; i > 0; i--)
+			siftWeakestVoice_internal(data, i - 1, k);
+		for (i = k; i < len; i++)
+		{
+			if (isVoiceWeaker_internal(mVoice[data[0]], mVoice[data[i]]))
+			{
+				unsigned int temp = data[0];
+				data[0] = data[i];
+				data[i] = temp;
+				siftWeakestVoice_internal(data, 0, k);
+			}
+		}
+		updateVirtualVoices_internal(candidates);
 		mapResampleBuffers_internal();
 	}
 
-	void Soloud::mix_internal(unsigned int aSamples, unsigned int aStride)
+	void Soloud::updateVirtualVoices_internal(unsigned int aCandidates)
+	{
+		unsigned int i;
+		for (i = 0; i < aCandidates; i++)
+		{
+			AudioSourceInstance *voice = mVoice[mActiveVoice[i]];
+			if (i < mActiveVoiceCount)
+			{
+				if (voice->mFlags & AudioSourceInstance::VIRTUAL)
+				{
+					// Promoted; the source already follows the play position, so
+					// only the resampler needs to start over.
+					voice->mFlags &= ~AudioSourceInstance::VIRTUAL;
+					voice->seek(voice->mStreamPosition, mScratch.mData, mScratchSize);
+					voice->mSrcOffset = 0;
+					voice->mLeftoverSamples = 0;
+				}
+			}
+			else
+			if (voice->mFlags & AudioSourceInstance::FAST_SEEK)
+			{
+				// Didn't fit in the active voices; keep time instead of freezing
+				voice->mFlags |= AudioSourceInstance::VIRTUAL;
+			}
+		}
+
+		// Voices that were virtual but are now paused, or inaudible without ticking,
+		// stop where they are.
+		for (i = 0; i < mHighestVoice; i++)
+		{
+			if (mVoice[i] && (mVoice[i]->mFlags & AudioSourceInstance::VIRTUAL) &&
+				(mVoice[i]->mFlags & AudioSourceInstance::PAUSED ||
+				(mVoice[i]->mFlags & (AudioSourceInstance::INAUDIBLE | AudioSourceInstance::INAUDIBLE_TICK)) == AudioSourceInstance::INAUDIBLE))
+			{
+				mVoice[i]->mFlags &= ~AudioSourceInstance::VIRTUAL;
+			}
+		}
+	}
+
+	void Soloud::mix_internal(unsigned int aSamples, unsigned int aStride, float *aInterleaved, float **aPlanar)
 	{
 #ifdef FLOATING_POINT_DEBUG
 		// This needs to be done in the audio thread as well..
@@ -2111,6 +2378,16 @@ namespace SoLoud
 		}
 #endif
 
+		long long profilestart = 0;
+		mProfiling = (mFlags & ENABLE_PROFILING) != 0;
+		if (mProfiling)
+		{
+			memset(&mProfileFrame, 0, sizeof(mProfileFrame));
+			profilestart = Thread::getTimeNanos();
+			mProfileMark = profilestart;
+			mProfileStage = ProfileFrame::OTHER;
+		}
+
 		float buffertime = aSamples / (float)mSamplerate;
 		float globalVolume[2];
 		mStreamTime += buffertime;
@@ -2126,12 +2403,16 @@ namespace SoLoud
 		lockAudioMutex_internal();
 
 		// Process faders. May change scratch size.
+		if (mProfiling)
+			profileStage_internal(ProfileFrame::FADERS);
+		unsigned int playing = 0;
 		int i;
 		for (i = 0; i < (signed)mHighestVoice; i++)
 		{
 			if (mVoice[i] && !(mVoice[i]->mFlags & AudioSourceInstance::PAUSED))
 			{
 				float volume[2];
+				playing++;
 
 				mVoice[i]->mActiveFader = 0;
 
@@ -2143,6 +2424,30 @@ namespace SoLoud
 				mVoice[i]->mStreamTime += buffertime;
 				mVoice[i]->mStreamPosition += (double)buffertime * (double)mVoice[i]->mOverallRelativePlaySpeed;
 
+				if ((mVoice[i]->mFlags & AudioSourceInstance::METERING) &&
+					(mVoice[i]->mFlags & (AudioSourceInstance::VIRTUAL | AudioSourceInstance::INAUDIBLE)))
+				{
+					// Not mixed, so nothing to hear
+					unsigned int k;
+					for (k = 0; k < MAX_CHANNELS; k++)
+					{
+						mVoice[i]->mMeterPeak[k] = 0;
+						mVoice[i]->mMeterMeanSquare[k] = 0;
+					}
+					publishMeter_internal(i);
+				}
+
+				if (mVoice[i]->mFlags & AudioSourceInstance::VIRTUAL)
+				{
+					// Virtual voices aren't mixed; move the source along arithmetically
+					mVoice[i]->seek(mVoice[i]->mStreamPosition, mScratch.mData, mScratchSize);
+					if (!(mVoice[i]->mFlags & (AudioSourceInstance::LOOPING | AudioSourceInstance::DISABLE_AUTOSTOP)) && mVoice[i]->hasEnded())
+					{
+						stopVoice_internal(i);
+						continue;
+					}
+				}
+
 				// TODO: this is actually unstable, because mStreamTime depends on the relative
 				// play speed. 
 				if (mVoice[i]->mRelativePlaySpeedFader.mActive > 0)
@@ -2190,24 +2495,79 @@ namespace SoLoud
 			}
 		}
 
+		if (mProfiling)
+			profileStage_internal(ProfileFrame::ACTIVE_VOICES);
 		if (mActiveVoiceDirty)
 			calcActiveVoices_internal();
-	
-		mixBus_internal(mOutputScratch.mData, aSamples, aStride, mScratch.mData, 0, (float)mSamplerate, mChannels, mResampler);
 
-		for (i = 0; i < FILTERS_PER_STREAM; i++)
+		if (mProfiling)
 		{
-			if (mFilterInstance[i])
+			profileStage_internal(ProfileFrame::OTHER);
+			unsigned int mixed = 0;
+			unsigned int j;
+			for (j = 0; j < mActiveVoiceCount; j++)
 			{
-				mFilterInstance[i]->filter(mOutputScratch.mData, aSamples, aStride, mChannels, (float)mSamplerate, mStreamTime);
+				AudioSourceInstance *voice = mVoice[mActiveVoice[j]];
+				if (voice && !(voice->mFlags & (AudioSourceInstance::PAUSED | AudioSourceInstance::INAUDIBLE)))
+					mixed++;
 			}
+			// Voices playing on buses are counted here too
+			mProfileFrame.mVoicesMixed = mixed;
+			mProfileFrame.mVoicesVirtual = playing > mixed ? playing - mixed : 0;
+		}
+	
+		if (mCaptureRing)
+		{
+			if (mCaptureStandIn)
+				pullCaptureStandIn_internal(aSamples);
+			// In full duplex, the input captured for this cycle ends at mCaptureWrite
+			mCaptureMixPos = mCaptureWrite - aSamples;
 		}
 
+		buildBusVoiceLists_internal();
+		mixBus_internal(mOutputScratch.mData, aSamples, aStride, mScratch.mData, 0, (float)mSamplerate, mChannels, mResampler, mStreamTime);
+
+		if (mProfiling)
+			profileStage_internal(ProfileFrame::GLOBAL_FILTERS);
+		filterChain_internal(mFilterInstance, mOutputScratch.mData, aSamples, aStride, mChannels, (float)mSamplerate);
+
 		unlockAudioMutex_internal();
 		
-		// Note: clipping channels*aStride, not channels*aSamples, so we're possibly clipping some unused data.
-		// The buffers should be large enough for it, we just may do a few bytes of unneccessary work.
-		clip_internal(mOutputScratch, mScratch, aStride, globalVolume[0], globalVolume[1]);
+		if (mProfiling)
+			profileStage_internal(ProfileFrame::CLIP);
+		const float *out[MAX_CHANNELS];
+		unsigned int outsamplestep = 1;
+		unsigned int ch;
+		if (aInterleaved)
+		{
+			// Clip straight to the caller's buffer, skipping the separate interleave pass.
+			clip_internal(mOutputScratch, aInterleaved, aSamples, aStride, globalVolume[0], globalVolume[1], true);
+			for (ch = 0; ch < mChannels; ch++)
+				out[ch] = aInterleaved + ch;
+			outsamplestep = mChannels;
+		}
+		else
+		if (aPlanar)
+		{
+			// Clip each channel straight to the caller's buffer for it.
+			float vd = (globalVolume[1] - globalVolume[0]) / aStride;
+			for (ch = 0; ch < mChannels; ch++)
+			{
+				clip_samples(mSimdPath, mOutputScratch.mData + ch * aStride, aPlanar[ch], aSamples, 1, aStride, false, (mFlags & CLIP_ROUNDOFF) != 0, globalVolume[0], vd, mPostClipScaler);
+				out[ch] = aPlanar[ch];
+			}
+		}
+		else
+		{
+			// Note: clipping channels*aStride, not channels*aSamples, so we're possibly clipping some unused data.
+			// The buffers should be large enough for it, we just may do a few bytes of unneccessary work.
+			clip_internal(mOutputScratch, mScratch.mData, aStride, aStride, globalVolume[0], globalVolume[1], false);
+			for (ch = 0; ch < mChannels; ch++)
+				out[ch] = mScratch.mData + ch * aStride;
+		}
+
+		if (mProfiling)
+			profileStage_internal(ProfileFrame::OTHER);
 
 		if (mFlags & ENABLE_VISUALIZATION)
 		{
@@ -2223,7 +2583,7 @@ namespace SoLoud
 					mVisualizationWaveData[i] = 0;
 					for (j = 0; j < (signed)mChannels; j++)
 					{
-						float sample = mScratch.mData[i + j * aStride];
+						float sample = out[j][i * outsamplestep];
 						float absvol = (float)fabs(sample);
 						if (mVisualizationChannelVolume[j] < absvol)
 							mVisualizationChannelVolume[j] = absvol;
@@ -2240,7 +2600,7 @@ namespace SoLoud
 					mVisualizationWaveData[i] = 0;
 					for (j = 0; j < (signed)mChannels; j++)
 					{
-						float sample = mScratch.mData[(i % aSamples) + j * aStride];
+						float sample = out[j][(i % aSamples) * outsamplestep];
 						float absvol = (float)fabs(sample);
 						if (mVisualizationChannelVolume[j] < absvol)
 							mVisualizationChannelVolume[j] = absvol;
@@ -2249,50 +2609,299 @@ namespace SoLoud
 				}
 			}
 		}
+
+		if (mProfiling)
+		{
+			profileStage_internal(ProfileFrame::OTHER);
+			mProfileFrame.mTotalNanos = mProfileMark - profilestart;
+			mProfileFrame.mSamples = aSamples;
+			unsigned int xruns = mBackendXrunCount;
+			mProfileFrame.mUnderruns = xruns - mProfileXrunCount;
+			mProfileXrunCount = xruns;
+			mProfileFrame.mDutyCycle = aSamples ? (float)(mProfileFrame.mTotalNanos * (double)mSamplerate / (aSamples * 1000000000.0)) : 0;
+			unsigned int w = mProfileWriteIndex;
+			mProfileRing[w % PROFILE_FRAMES] = mProfileFrame;
+			// Publish the frame before the index that makes it visible
+			Thread::memoryBarrier();
+			mProfileWriteIndex = w + 1;
+			mProfiling = false;
+			if (mCostTrace)
+			{
+				lockAudioMutex_internal();
+				addSourceCost_internal(0, 0, profilestart, mProfileMark);
+				unlockAudioMutex_internal();
+			}
+		}
 	}
 
 	void Soloud::mix(float *aBuffer, unsigned int aSamples)
 	{
 		unsigned int stride = (aSamples + 15) & ~0xf;
-		mix_internal(aSamples, stride);
-		interlace_samples_float(mScratch.mData, aBuffer, aSamples, mChannels, stride);
+		mix_internal(aSamples, stride, aBuffer);
+	}
+
+	void Soloud::mixPlanar(float **aBuffers, unsigned int aSamples)
+	{
+		unsigned int stride = (aSamples + 15) & ~0xf;
+		mix_internal(aSamples, stride, 0, aBuffers);
 	}
 
 	void Soloud::mixSigned16(short *aBuffer, unsigned int aSamples)
 	{
 		unsigned int stride = (aSamples + 15) & ~0xf;
 		mix_internal(aSamples, stride);
-		interlace_samples_s16(mScratch.mData, aBuffer, aSamples, mChannels, stride);
+		interlace_samples_s16(mScratch.mData, aBuffer, aSamples, mChannels, stride, (mFlags & TPDF_DITHER) ? mDitherState : 0);
+	}
+
+	void Soloud::mixSigned24(unsigned char *aBuffer, unsigned int aSamples)
+	{
+		unsigned int stride = (aSamples + 15) & ~0xf;
+		mix_internal(aSamples, stride);
+		interlace_samples_s24(mScratch.mData, aBuffer, aSamples, mChannels, stride);
+	}
+
+	void Soloud::mixSigned32(int *aBuffer, unsigned int aSamples)
+	{
+		unsigned int stride = (aSamples + 15) & ~0xf;
+		mix_internal(aSamples, stride);
+		interlace_samples_s32(mScratch.mData, aBuffer, aSamples, mChannels, stride);
+	}
+
+	// Produces 4 samples of triangular noise in range ]-1,1[, one from each
+	// xorshift lane. The SSE path below computes exactly the same values.
+	static void dither_quad(unsigned int *aState, float *aNoise)
+	{
+		int i;
+		for (i = 0; i < 4; i++)
+		{
+			unsigned int x = aState[i];
+			x ^= x << 13;
+			x ^= x >> 17;
+			x ^= x << 5;
+			unsigned int y = x;
+			y ^= y << 13;
+			y ^= y >> 17;
+			y ^= y << 5;
+			aState[i] = y;
+			union { unsigned int i; float f; } a, b;
+			a.i = (x >> 9) | 0x3f800000;
+			b.i = (y >> 9) | 0x3f800000;
+			aNoise[i] = a.f - b.f;
+		}
+	}
+
+#ifdef SOLOUD_SSE_INTRINSICS
+	static inline __m128i xorshift_sse(__m128i x)
+	{
+		x = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+		x = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+		x = _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+		return x;
+	}
+
+	static inline __m128 dither_quad_sse(unsigned int *aState)
+	{
+		__m128i x = xorshift_sse(_mm_loadu_si128((const __m128i*)aState));
+		__m128i y = xorshift_sse(x);
+		_mm_storeu_si128((__m128i*)aState, y);
+		__m128i one = _mm_set1_epi32(0x3f800000);
+		__m128 a = _mm_castsi128_ps(_mm_or_si128(_mm_srli_epi32(x, 9), one));
+		__m128 b = _mm_castsi128_ps(_mm_or_si128(_mm_srli_epi32(y, 9), one));
+		return _mm_sub_ps(a, b);
+	}
+
+	// Scale, optionally dither, clamp and convert 4 samples to 32-bit integers
+	static inline __m128i quantize_sse(const float *aSrc, __m128 aScale, __m128 aMin, __m128 aMax, unsigned int *aDither)
+	{
+		__m128 f = _mm_mul_ps(_mm_loadu_ps(aSrc), aScale);
+		if (aDither)
+			f = _mm_add_ps(f, dither_quad_sse(aDither));
+		f = _mm_max_ps(_mm_min_ps(f, aMax), aMin);
+		// Dithered output is rounded, otherwise the noise would truncate away near zero
+		return aDither ? _mm_cvtps_epi32(f) : _mm_cvttps_epi32(f);
+	}
+#endif
+
+	// Scalar counterpart of quantize_sse; aNoise may be null.
+	static inline int quantize(float aSample, float aScale, float aMin, float aMax, const float *aNoise, unsigned int aIndex)
+	{
+		float f = aSample * aScale;
+		if (aNoise)
+			f += aNoise[aIndex];
+		if (f > aMax) f = aMax;
+		if (f < aMin) f = aMin;
+		return aNoise ? (int)lrintf(f) : (int)f;
 	}
 
 	void interlace_samples_float(const float *aSourceBuffer, float *aDestBuffer, unsigned int aSamples, unsigned int aChannels, unsigned int aStride)
 	{
 		// 111222 -> 121212
 		unsigned int i, j, c;
-		c = 0;
+		if (aChannels == 1)
+		{
+			memcpy(aDestBuffer, aSourceBuffer, sizeof(float) * aSamples);
+			return;
+		}
+		i = 0;
+#ifdef SOLOUD_SSE_INTRINSICS
+		if (aChannels == 2)
+		{
+			const float *l = aSourceBuffer;
+			const float *r = aSourceBuffer + aStride;
+			for (; i + 4 <= aSamples; i += 4)
+			{
+				__m128 a = _mm_loadu_ps(l + i);
+				__m128 b = _mm_loadu_ps(r + i);
+				_mm_storeu_ps(aDestBuffer + i * 2, _mm_unpacklo_ps(a, b));
+				_mm_storeu_ps(aDestBuffer + i * 2 + 4, _mm_unpackhi_ps(a, b));
+			}
+		}
+#endif
 		for (j = 0; j < aChannels; j++)
 		{
-			c = j * aStride;
-			for (i = j; i < aSamples * aChannels; i += aChannels)
+			c = j * aStride + i;
+			for (unsigned int k = i * aChannels + j; k < aSamples * aChannels; k += aChannels)
 			{
-				aDestBuffer[i] = aSourceBuffer[c];
+				aDestBuffer[k] = aSourceBuffer[c];
 				c++;
 			}
 		}
 	}
 
-	void interlace_samples_s16(const float *aSourceBuffer, short *aDestBuffer, unsigned int aSamples, unsigned int aChannels, unsigned int aStride)
+	void interlace_samples_s16(const float *aSourceBuffer, short *aDestBuffer, unsigned int aSamples, unsigned int aChannels, unsigned int aStride, unsigned int *aDither)
 	{
 		// 111222 -> 121212
-		unsigned int i, j, c;
-		c = 0;
-		for (j = 0; j < aChannels; j++)
+		// Samples are handled in groups of 4 per channel so that dither noise
+		// is consumed in the same order by the SSE and the scalar paths.
+		unsigned int i, j, k;
+		i = 0;
+#ifdef SOLOUD_SSE_INTRINSICS
 		{
-			c = j * aStride;
-			for (i = j; i < aSamples * aChannels; i += aChannels)
+			__m128 scale = _mm_set1_ps((float)0x7fff);
+			__m128 mn = _mm_set1_ps(-32768.0f);
+			__m128 mx = _mm_set1_ps(32767.0f);
+			if (aChannels == 2)
 			{
-				aDestBuffer[i] = (short)(aSourceBuffer[c] * 0x7fff);
-				c++;
+				for (; i + 4 <= aSamples; i += 4)
+				{
+					__m128i l = quantize_sse(aSourceBuffer + i, scale, mn, mx, aDither);
+					__m128i r = quantize_sse(aSourceBuffer + aStride + i, scale, mn, mx, aDither);
+					__m128i packed = _mm_packs_epi32(_mm_unpacklo_epi32(l, r), _mm_unpackhi_epi32(l, r));
+					_mm_storeu_si128((__m128i*)(aDestBuffer + i * 2), packed);
+				}
+			}
+			else
+			{
+				int tmp[4];
+				for (; i + 4 <= aSamples; i += 4)
+				{
+					for (j = 0; j < aChannels; j++)
+					{
+						_mm_storeu_si128((__m128i*)tmp, quantize_sse(aSourceBuffer + j * aStride + i, scale, mn, mx, aDither));
+						for (k = 0; k < 4; k++)
+							aDestBuffer[(i + k) * aChannels + j] = (short)tmp[k];
+					}
+				}
+			}
+		}
+#endif
+		float noise[4];
+		for (; i < aSamples; i += 4)
+		{
+			unsigned int count = aSamples - i < 4 ? aSamples - i : 4;
+			for (j = 0; j < aChannels; j++)
+			{
+				if (aDither)
+					dither_quad(aDither, noise);
+				const float *src = aSourceBuffer + j * aStride + i;
+				for (k = 0; k < count; k++)
+					aDestBuffer[(i + k) * aChannels + j] = (short)quantize(src[k], (float)0x7fff, -32768.0f, 32767.0f, aDither ? noise : 0, k);
+			}
+		}
+	}
+
+	void interlace_samples_s24(const float *aSourceBuffer, unsigned char *aDestBuffer, unsigned int aSamples, unsigned int aChannels, unsigned int aStride)
+	{
+		// 111222 -> 121212, 3 bytes per sample, little endian
+		unsigned int i, j, k;
+		i = 0;
+#ifdef SOLOUD_SSE_INTRINSICS
+		{
+			__m128 scale = _mm_set1_ps((float)0x7fffff);
+			__m128 mn = _mm_set1_ps(-8388608.0f);
+			__m128 mx = _mm_set1_ps(8388607.0f);
+			int tmp[4];
+			for (; i + 4 <= aSamples; i += 4)
+			{
+				for (j = 0; j < aChannels; j++)
+				{
+					_mm_storeu_si128((__m128i*)tmp, quantize_sse(aSourceBuffer + j * aStride + i, scale, mn, mx, 0));
+					for (k = 0; k < 4; k++)
+					{
+						unsigned char *d = aDestBuffer + ((i + k) * aChannels + j) * 3;
+						d[0] = (unsigned char)(tmp[k] & 0xff);
+						d[1] = (unsigned char)((tmp[k] >> 8) & 0xff);
+						d[2] = (unsigned char)((tmp[k] >> 16) & 0xff);
+					}
+				}
+			}
+		}
+#endif
+		for (; i < aSamples; i++)
+		{
+			for (j = 0; j < aChannels; j++)
+			{
+				int s = quantize(aSourceBuffer[j * aStride + i], (float)0x7fffff, -8388608.0f, 8388607.0f, 0, 0);
+				unsigned char *d = aDestBuffer + (i * aChannels + j) * 3;
+				d[0] = (unsigned char)(s & 0xff);
+				d[1] = (unsigned char)((s >> 8) & 0xff);
+				d[2] = (unsigned char)((s >> 16) & 0xff);
+			}
+		}
+	}
+
+	void interlace_samples_s32(const float *aSourceBuffer, int *aDestBuffer, unsigned int aSamples, unsigned int aChannels, unsigned int aStride)
+	{
+		// 111222 -> 121212
+		// 2147483520 is the largest float below 2^31, so the clamped value
+		// always fits in an int.
+		unsigned int i, j, k;
+		i = 0;
+#ifdef SOLOUD_SSE_INTRINSICS
+		{
+			__m128 scale = _mm_set1_ps(2147483648.0f);
+			__m128 mn = _mm_set1_ps(-2147483648.0f);
+			__m128 mx = _mm_set1_ps(2147483520.0f);
+			if (aChannels == 2)
+			{
+				for (; i + 4 <= aSamples; i += 4)
+				{
+					__m128i l = quantize_sse(aSourceBuffer + i, scale, mn, mx, 0);
+					__m128i r = quantize_sse(aSourceBuffer + aStride + i, scale, mn, mx, 0);
+					_mm_storeu_si128((__m128i*)(aDestBuffer + i * 2), _mm_unpacklo_epi32(l, r));
+					_mm_storeu_si128((__m128i*)(aDestBuffer + i * 2 + 4), _mm_unpackhi_epi32(l, r));
+				}
+			}
+			else
+			{
+				int tmp[4];
+				for (; i + 4 <= aSamples; i += 4)
+				{
+					for (j = 0; j < aChannels; j++)
+					{
+						_mm_storeu_si128((__m128i*)tmp, quantize_sse(aSourceBuffer + j * aStride + i, scale, mn, mx, 0));
+						for (k = 0; k < 4; k++)
+							aDestBuffer[(i + k) * aChannels + j] = tmp[k];
+					}
+				}
+			}
+		}
+#endif
+		for (; i < aSamples; i++)
+		{
+			for (j = 0; j < aChannels; j++)
+			{
+				aDestBuffer[i * aChannels + j] = quantize(aSourceBuffer[j * aStride + i], 2147483648.0f, -2147483648.0f, 2147483520.0f, 0, 0);
 			}
 		}
 	}
@@ -0,0 +1,209 @@
+/*
+SoLoud audio engine
+Copyright (c) 2013-2021 Jari Komppa
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+
+#include <string.h>
+#include "soloud.h"
+#include "soloud_audioinput.h"
+
+namespace SoLoud
+{
+	AudioInputInstance::AudioInputInstance(AudioInput *aParent)
+	{
+		mSoloud = aParent->mSoloud;
+		mReadPos = 0;
+		mStarted = false;
+	}
+
+	unsigned int AudioInputInstance::getAudio(float *aBuffer, unsigned int aSamplesToRead, unsigned int aBufferSize)
+	{
+		unsigned int i, j;
+		unsigned int frames = 0;
+		if (mSoloud && mSoloud->mCaptureRing)
+		{
+			unsigned int write = mSoloud->mCaptureWrite;
+			if (!mStarted || write - mReadPos > mSoloud->mCaptureRingFrames - aSamplesToRead)
+			{
+				// Starting, or fell behind while paused: the mixer reads SAMPLE_GRANULARITY
+				// frames at a time, so stay that far behind the input to never run out of it.
+				mReadPos = mSoloud->mCaptureMixPos - SAMPLE_GRANULARITY;
+				mStarted = true;
+			}
+			int avail = (int)(write - mReadPos);
+			if (avail > 0)
+				frames = (unsigned int)avail < aSamplesToRead ? (unsigned int)avail : aSamplesToRead;
+
+			unsigned int mask = mSoloud->mCaptureRingFrames - 1;
+			unsigned int channels = mSoloud->mCaptureChannels;
+			for (j = 0; j < mChannels; j++)
+			{
+				float *dst = aBuffer + j * aBufferSize;
+				if (j < channels)
+				{
+					for (i = 0; i < frames; i++)
+						dst[i] = mSoloud->mCaptureRing[((mReadPos + i) & mask) * channels + j];
+				}
+				else
+				{
+					memset(dst, 0, sizeof(float) * frames);
+				}
+			}
+			mReadPos += aSamplesToRead;
+		}
+
+		for (j = 0; j < mChannels; j++)
+			memset(aBuffer + j * aBufferSize + frames, 0, sizeof(float) * (aSamplesToRead - frames));
+		return aSamplesToRead;
+	}
+
+	bool AudioInputInstance::hasEnded()
+	{
+		return false;
+	}
+
+	AudioInput::AudioInput()
+	{
+	}
+
+	AudioInput::~AudioInput()
+	{
+		stop();
+	}
+
+	AudioSourceInstance * AudioInput::createInstance()
+	{
+		// The input comes at the output rate, with as many channels as the device captures
+		if (mSoloud)
+		{
+			mBaseSamplerate = (float)mSoloud->mSamplerate;
+			mChannels = mSoloud->mCaptureChannels ? mSoloud->mCaptureChannels : 1;
+		}
+		return new AudioInputInstance(this);
+	}
+
+	result Soloud::initCapture_internal(unsigned int aChannels)
+	{
+		if (aChannels < 1 || aChannels > MAX_CHANNELS)
+			return INVALID_PARAMETER;
+		// Room for a few mixes of any size, so AudioInput can tell when it has fallen behind
+		unsigned int frames = SAMPLE_GRANULARITY;
+		while (frames < mScratchSize * 4)
+			frames *= 2;
+		float *ring = new float[frames * aChannels];
+		if (ring == 0)
+			return OUT_OF_MEMORY;
+		memset(ring, 0, sizeof(float) * frames * aChannels);
+
+		lockAudioMutex_internal();
+		float *old = mCaptureRing;
+		mCaptureRing = ring;
+		mCaptureRingFrames = frames;
+		mCaptureChannels = aChannels;
+		mCaptureWrite = 0;
+		mCaptureMixPos = 0;
+		unlockAudioMutex_internal();
+		delete[] old;
+		return SO_NO_ERROR;
+	}
+
+	void Soloud::capture(const float *aBuffer, unsigned int aSamples)
+	{
+		if (aBuffer == 0)
+			return;
+		lockAudioMutex_internal();
+		if (mCaptureRing && !mCaptureStandIn)
+		{
+			unsigned int mask = mCaptureRingFrames - 1;
+			unsigned int skip = aSamples > mCaptureRingFrames ? aSamples - mCaptureRingFrames : 0;
+			unsigned int i;
+			for (i = skip; i < aSamples; i++)
+				memcpy(mCaptureRing + ((mCaptureWrite + i) & mask) * mCaptureChannels, aBuffer + i * mCaptureChannels, sizeof(float) * mCaptureChannels);
+			mCaptureWrite += aSamples;
+		}
+		unlockAudioMutex_internal();
+	}
+
+	result Soloud::setCaptureStandIn(AudioSource *aSource)
+	{
+		AudioSourceInstance *instance = 0;
+		if (aSource)
+		{
+			// The ring is sized from the output buffer, so init() first
+			if (mScratchSize == 0)
+				return INVALID_PARAMETER;
+			if (mCaptureChannels == 0 || mCaptureChannels != aSource->mChannels)
+			{
+				result res = initCapture_internal(aSource->mChannels);
+				if (res != SO_NO_ERROR)
+					return res;
+			}
+			instance = aSource->createInstance();
+			if (instance == 0)
+				return OUT_OF_MEMORY;
+			instance->init(*aSource, 0);
+		}
+
+		lockAudioMutex_internal();
+		AudioSourceInstance *old = mCaptureStandIn;
+		mCaptureStandIn = instance;
+		unlockAudioMutex_internal();
+		delete old;
+		return SO_NO_ERROR;
+	}
+
+	void Soloud::pullCaptureStandIn_internal(unsigned int aSamples)
+	{
+		AudioSourceInstance *source = mCaptureStandIn;
+		unsigned int mask = mCaptureRingFrames - 1;
+		unsigned int done = 0;
+		while (done < aSamples)
+		{
+			unsigned int n = aSamples - done;
+			if (n > SAMPLE_GRANULARITY)
+				n = SAMPLE_GRANULARITY;
+			unsigned int got = source->hasEnded() ? 0 : source->getAudio(mScratch.mData, n, n);
+			if (got == 0 && (source->mFlags & AudioSourceInstance::LOOPING) && source->rewind() == SO_NO_ERROR)
+			{
+				source->mLoopCount++;
+				got = source->getAudio(mScratch.mData, n, n);
+			}
+			if (got == 0)
+			{
+				// Ran out; the rest is silence
+				got = n;
+				memset(mScratch.mData, 0, sizeof(float) * n * source->mChannels);
+			}
+
+			unsigned int i, j;
+			for (i = 0; i < got; i++)
+			{
+				float *dst = mCaptureRing + ((mCaptureWrite + i) & mask) * mCaptureChannels;
+				for (j = 0; j < mCaptureChannels; j++)
+					dst[j] = j < source->mChannels ? mScratch.mData[i + j * n] : 0;
+			}
+			mCaptureWrite += got;
+			done += got;
+		}
+	}
+};
@@ -23,6 +23,7 @@ freely, subject to the following restrictions:
 */
 
 #include "soloud.h"
+#include "soloud_bus.h"
 
 namespace SoLoud
 {
@@ -65,6 +66,18 @@ namespace SoLoud
 		mDopplerValue = 1.0f;
 	}
 
+	AudioSendState::AudioSendState()
+	{
+		mNextFrame = 0;
+		mPos = 0;
+		mNextTime = 0;
+		mSourceSamplerate = 0;
+		mBusSamplerate = 0;
+		for (int i = 0; i < MAX_CHANNELS; i++)
+			mLast[i] = 0;
+		mValid = false;
+	}
+
 	AudioSourceInstance::AudioSourceInstance()
 	{
 		mPlayIndex = 0;
@@ -93,6 +106,14 @@ namespace SoLoud
 		for (i = 0; i < MAX_CHANNELS; i++)
 		{
 			mCurrentChannelVolume[i] = 0;
+			mMeterPeak[i] = 0;
+			mMeterMeanSquare[i] = 0;
+		}
+		for (i = 0; i < SENDS_PER_VOICE; i++)
+		{
+			mSendBus[i] = 0;
+			mSendVolume[i] = 0;
+			mCurrentSendVolume[i] = 0;
 		}
 		// behind pointers because we swap between the two buffers
 		mResampleData[0] = 0;
@@ -102,6 +123,9 @@ namespace SoLoud
 		mDelaySamples = 0;
 		mOverallVolume = 0;
 		mOverallRelativePlaySpeed = 1;
+		mPriority = 0;
+		mCategory = 0;
+		mRecentRMS = 1;
 	}
 
 	AudioSourceInstance::~AudioSourceInstance()
@@ -122,6 +146,8 @@ namespace SoLoud
 		mStreamTime = 0.0f;
 		mStreamPosition = 0.0f;
 		mLoopPoint = aSource.mLoopPoint;
+		mPriority = aSource.mPriority;
+		mCategory = aSource.mCategory;
 
 		if (aSource.mFlags & AudioSource::SHOULD_LOOP)
 		{
@@ -147,6 +173,22 @@ namespace SoLoud
 		{
 			mFlags |= AudioSourceInstance::DISABLE_AUTOSTOP;
 		}
+		if (aSource.mFlags & AudioSource::METERING)
+		{
+			mFlags |= AudioSourceInstance::METERING;
+		}
+
+		int i;
+		for (i = 0; i < SENDS_PER_VOICE; i++)
+		{
+			Bus *bus = aSource.mSendBus[i];
+			if (bus && bus->mInstance && bus->mSoloud)
+			{
+				bus->findBusHandle();
+				mSendBus[i] = bus->mChannelHandle;
+				mSendVolume[i] = aSource.mSendVolume[i];
+			}
+		}
 	}
 
 	result AudioSourceInstance::rewind()
@@ -203,11 +245,23 @@ namespace SoLoud
 		mColliderData = 0;
 		mVolume = 1;
 		mLoopPoint = 0;
+		mSharedFilterBus = 0;
+		mSharedFilterHandle = 0;
+		mPriority = 0;
+		mCategory = 0;
+		mInstanceLimit = 0;
+		mInstanceLimitSteal = true;
+		for (i = 0; i < SENDS_PER_VOICE; i++)
+		{
+			mSendBus[i] = 0;
+			mSendVolume[i] = 0;
+		}
 	}
 
 	AudioSource::~AudioSource() 
 	{
 		stop();
+		delete mSharedFilterBus;
 	}
 
 	void AudioSource::setVolume(float aVolume)
@@ -261,11 +315,87 @@ namespace SoLoud
 		}
 	}
 
+	void AudioSource::setSharedFilters(bool aShared)
+	{
+		if (aShared)
+		{
+			mFlags |= SHARED_FILTERS;
+		}
+		else
+		{
+			mFlags &= ~SHARED_FILTERS;
+		}
+	}
+
+	void AudioSource::setMetering(bool aEnable)
+	{
+		if (aEnable)
+		{
+			mFlags |= METERING;
+		}
+		else
+		{
+			mFlags &= ~METERING;
+		}
+	}
+
+	void AudioSource::setPriority(int aPriority)
+	{
+		mPriority = aPriority;
+	}
+
+	result AudioSource::setCategory(unsigned int aCategory)
+	{
+		if (aCategory >= VOICE_CATEGORY_COUNT)
+			return INVALID_PARAMETER;
+		mCategory = aCategory;
+		return SO_NO_ERROR;
+	}
+
+	void AudioSource::setInstanceLimit(unsigned int aMaxInstances, bool aSteal)
+	{
+		mInstanceLimit = aMaxInstances;
+		mInstanceLimitSteal = aSteal;
+	}
+
+	result AudioSource::setSend(Bus &aBus, float aVolume)
+	{
+		int i, slot = -1;
+		for (i = 0; i < SENDS_PER_VOICE && slot == -1; i++)
+			if (mSendBus[i] == &aBus)
+				slot = i;
+		if (aVolume == 0)
+		{
+			if (slot != -1)
+				mSendBus[slot] = 0;
+			return SO_NO_ERROR;
+		}
+		for (i = 0; i < SENDS_PER_VOICE && slot == -1; i++)
+			if (mSendBus[i] == 0)
+				slot = i;
+		if (slot == -1)
+			return INVALID_PARAMETER;
+
+		mSendBus[slot] = &aBus;
+		mSendVolume[slot] = aVolume;
+		aBus.mSendTarget = true;
+		if (aBus.mInstance && aBus.mSoloud)
+		{
+			aBus.mSoloud->lockAudioMutex_internal();
+			if (aBus.mInstance)
+				aBus.mInstance->initSendRing();
+			aBus.mSoloud->unlockAudioMutex_internal();
+		}
+		return SO_NO_ERROR;
+	}
+
 	void AudioSource::setFilter(unsigned int aFilterId, Filter *aFilter)
 	{
 		if (aFilterId >= FILTERS_PER_STREAM)
 			return;
 		mFilter[aFilterId] = aFilter;
+		if (mSharedFilterBus)
+			mSharedFilterBus->setFilter(aFilterId, aFilter);
 	}
 
 	void AudioSource::stop()
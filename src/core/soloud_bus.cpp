@@ -31,13 +31,161 @@ namespace SoLoud
 	BusInstance::BusInstance(Bus *aParent)
 	{
 		mParent = aParent;
-		mFlags |= PROTECTED | INAUDIBLE_TICK;		
+		mFlags |= PROTECTED | INAUDIBLE_TICK | BUS;
 		for (int i = 0; i < MAX_CHANNELS; i++)
 			mVisualizationChannelVolume[i] = 0;
 		for (int i = 0; i < 256; i++)
 			mVisualizationWaveData[i] = 0;
+		mSidechainPeak = 0;
+		mSidechainRMS = 0;
 		mScratchSize = SAMPLE_GRANULARITY;
 		mScratch.init(mScratchSize * MAX_CHANNELS);
+		mBlockTime = 0;
+		mSendRingSize = 0;
+		mSendLatency = 0;
+		mSendReadFrame = 0;
+		mSendSynced = false;
+		if (aParent->mSendTarget)
+			initSendRing();
+	}
+
+	void BusInstance::initSendRing()
+	{
+		if (mSendRing.mData)
+			return;
+		// A send can be mixed after this bus has already read the same time span, at most
+		// one mix call plus the resampler lookahead later; reading that late catches all of it.
+		unsigned int buffersize = mParent->mSoloud ? mParent->mSoloud->mBufferSize : 0;
+		if (buffersize < SAMPLE_GRANULARITY)
+			buffersize = SAMPLE_GRANULARITY;
+		mSendLatency = buffersize + 2 * SAMPLE_GRANULARITY;
+		mSendRingSize = SAMPLE_GRANULARITY;
+		while (mSendRingSize < mSendLatency * 2 + SAMPLE_GRANULARITY)
+			mSendRingSize *= 2;
+		if (mSendRing.init(mSendRingSize * mParent->mChannels) != SO_NO_ERROR)
+			return;
+		mSendRing.clear();
+		mSendSynced = false;
+	}
+
+	void BusInstance::accumulateSend(const float *aBuffer, unsigned int aChannels, unsigned int aSamples, unsigned int aBufferSize, time aTime, float aSamplerate, float aVolumeFrom, float aVolumeTo, AudioSendState &aState)
+	{
+		if (!mSendRing.mData || aSamples == 0)
+			return;
+
+		unsigned int channels = mSendRing.mFloats / mSendRingSize;
+		if (channels > mChannels)
+			channels = mChannels;
+		unsigned int mask = mSendRingSize - 1;
+		unsigned int j, k;
+
+		// Source samples per ring frame
+		double step = (double)aSamplerate / mSamplerate;
+		long long start;
+		double pos = 0;
+		unsigned int frames = aSamples;
+		if (aSamplerate == mSamplerate)
+		{
+			start = (long long)floor(aTime * mSamplerate + 0.5);
+			aState.mValid = false;
+		}
+		else
+		{
+			if (aState.mValid &&
+				aState.mSourceSamplerate == aSamplerate &&
+				aState.mBusSamplerate == mSamplerate &&
+				fabs(aTime - aState.mNextTime) * aSamplerate < 0.5)
+			{
+				// Carry on where the previous block left off
+				start = aState.mNextFrame;
+				pos = aState.mPos;
+			}
+			else
+			{
+				// First frame at or after the block start
+				start = (long long)ceil(aTime * mSamplerate - 1e-6);
+				pos = (start / (double)mSamplerate - aTime) * aSamplerate;
+				if (pos < 0)
+					pos = 0;
+			}
+			// Frames past the last source sample need the next block to interpolate
+			frames = 0;
+			if (pos < aSamples - 1)
+				frames = (unsigned int)ceil((aSamples - 1 - pos) / step);
+		}
+
+		// Only write to the part of the ring that hasn't been read yet
+		unsigned int first = 0;
+		unsigned int last = frames;
+		if (mSendSynced)
+		{
+			if (start + frames <= mSendReadFrame || start >= mSendReadFrame + mSendRingSize)
+			{
+				last = 0;
+			}
+			else
+			{
+				if (start < mSendReadFrame)
+					first = (unsigned int)(mSendReadFrame - start);
+				if (start + frames > mSendReadFrame + mSendRingSize)
+					last = (unsigned int)(mSendReadFrame + mSendRingSize - start);
+			}
+		}
+
+		float voli = frames ? (aVolumeTo - aVolumeFrom) / frames : 0;
+		for (k = 0; k < channels; k++)
+		{
+			// Channels map one to one; mono feeds all of them
+			const float *src = aBuffer + (k % aChannels) * aBufferSize;
+			float *dst = mSendRing.mData + k * mSendRingSize;
+			unsigned int ofs = (unsigned int)((start + first) & mask);
+			if (aSamplerate == mSamplerate && aVolumeFrom == aVolumeTo)
+			{
+				for (j = first; j < last; j++)
+				{
+					dst[ofs] += src[j] * aVolumeTo;
+					ofs = (ofs + 1) & mask;
+				}
+			}
+			else if (aSamplerate == mSamplerate)
+			{
+				float vol = aVolumeFrom + voli * first;
+				for (j = first; j < last; j++)
+				{
+					vol += voli;
+					dst[ofs] += src[j] * vol;
+					ofs = (ofs + 1) & mask;
+				}
+			}
+			else
+			{
+				// Linear interpolation; a negative position falls between the previous block and this one
+				float vol = aVolumeFrom + voli * first;
+				for (j = first; j < last; j++)
+				{
+					vol += voli;
+					double p = pos + j * step;
+					int s = (int)floor(p);
+					float f = (float)(p - s);
+					float s0 = s < 0 ? aState.mLast[k] : src[s];
+					float s1 = src[s + 1];
+					dst[ofs] += (s0 + (s1 - s0) * f) * vol;
+					ofs = (ofs + 1) & mask;
+				}
+			}
+		}
+
+		if (aSamplerate != mSamplerate)
+		{
+			for (k = 0; k < channels; k++)
+				aState.mLast[k] = aBuffer[(k % aChannels) * aBufferSize + aSamples - 1];
+			aState.mNextFrame = start + frames;
+			aState.mPos = pos + frames * step - aSamples;
+			aState.mNextTime = aTime + aSamples / (double)aSamplerate;
+			aState.mSourceSamplerate = aSamplerate;
+			aState.mBusSamplerate = mSamplerate;
+			aState.mValid = true;
+		}
 	}
 	
 	unsigned int BusInstance::getAudio(float *aBuffer, unsigned int aSamplesToRead, unsigned int aBufferSize)
@@ -53,10 +201,61 @@ namespace SoLoud
 		}
 		
 		Soloud *s = mParent->mSoloud;
+
 		
-		s->mixBus_internal(aBuffer, aSamplesToRead, aBufferSize, mScratch.mData, handle, mSamplerate, mChannels, mParent->mResampler);
+		s->mixBus_internal(aBuffer, aSamplesToRead, aBufferSize, mScratch.mData, handle, mSamplerate, mChannels, mParent->mResampler, mBlockTime);
+
+		if (mSendRing.mData)
+		{
+			long long frame = (long long)floor(mBlockTime * mSamplerate + 0.5) - mSendLatency;
+			if (!mSendSynced || frame > mSendReadFrame + SAMPLE_GRANULARITY || frame < mSendReadFrame - SAMPLE_GRANULARITY)
+			{
+				// First read, or the bus wasn't mixed for a while; the ring only has stale data
+				mSendRing.clear();
+				mSendReadFrame = frame;
+				mSendSynced = true;
+			}
+			unsigned int channels = mSendRing.mFloats / mSendRingSize;
+			if (channels > mChannels)
+				channels = mChannels;
+			unsigned int mask = mSendRingSize - 1;
+			unsigned int j, k;
+			for (k = 0; k < channels; k++)
+			{
+				float *src = mSendRing.mData + k * mSendRingSize;
+				float *dst = aBuffer + k * aBufferSize;
+				unsigned int pos = (unsigned int)(mSendReadFrame & mask);
+				for (j = 0; j < aSamplesToRead; j++)
+				{
+					dst[j] += src[pos];
+					src[pos] = 0;
+					pos = (pos + 1) & mask;
+				}
+			}
+			mSendReadFrame += aSamplesToRead;
+		}
 
 		int i;
+		if (mFlags & SIDECHAIN_SOURCE)
+		{
+			float peak = 0;
+			float sum = 0;
+			unsigned int j, k;
+			for (k = 0; k < mChannels; k++)
+			{
+				const float *ch = aBuffer + aBufferSize * k;
+				for (j = 0; j < aSamplesToRead; j++)
+				{
+					float absvol = (float)fabs(ch[j]);
+					if (absvol > peak)
+						peak = absvol;
+					sum += ch[j] * ch[j];
+				}
+			}
+			mSidechainPeak = peak;
+			mSidechainRMS = aSamplesToRead ? (float)sqrt(sum / (aSamplesToRead * mChannels)) : 0;
+		}
+
 		if (mParent->mFlags & AudioSource::VISUALIZATION_DATA)
 		{
 			for (i = 0; i < MAX_CHANNELS; i++)
@@ -102,7 +301,23 @@ namespace SoLoud
 	bool BusInstance::hasEnded()
 	{
 		// Busses never stop for fear of going under 50mph.
-		return 0;
+		if (!mParent->mStopWhenIdle || mParent->mChannelHandle == 0)
+			return 0;
+
+		// ..except when nothing plays through us and the filters have nothing left to say.
+		Soloud *s = mParent->mSoloud;
+		int i;
+		for (i = 0; i < (signed)s->mHighestVoice; i++)
+		{
+			if (s->mVoice[i] && s->mVoice[i]->mBusHandle == mParent->mChannelHandle)
+				return 0;
+		}
+		for (i = 0; i < FILTERS_PER_STREAM; i++)
+		{
+			if (mFilter[i] && !mFilter[i]->isBypassed() && !mFilter[i]->mFlushed && mFilter[i]->hasTail())
+				return 0;
+		}
+		return 1;
 	}
 
 	BusInstance::~BusInstance()
@@ -116,12 +331,20 @@ namespace SoLoud
 				s->stopVoice_internal(i);
 			}
 		}
+		// Don't leave the parent pointing at a dead instance
+		if (mParent->mInstance == this)
+		{
+			mParent->mInstance = 0;
+			mParent->mChannelHandle = 0;
+		}
 	}
 
 	Bus::Bus()
 	{
 		mChannelHandle = 0;
 		mInstance = 0;
+		mStopWhenIdle = false;
+		mSendTarget = false;
 		mChannels = 2;
 		mResampler = SOLOUD_DEFAULT_RESAMPLER;
 		for (int i = 0; i < 256; i++)
@@ -233,6 +456,46 @@ namespace SoLoud
 		FOR_ALL_VOICES_POST_EXT
 	}
 
+	result Bus::setSend(handle aVoiceHandle, float aVolume)
+	{
+		if (!mInstance || !mSoloud)
+			return INVALID_PARAMETER;
+
+		findBusHandle();
+		if (mChannelHandle == 0)
+			return INVALID_PARAMETER;
+
+		mSendTarget = true;
+		result res = SO_NO_ERROR;
+		FOR_ALL_VOICES_PRE_EXT
+			if (mInstance)
+				mInstance->initSendRing();
+			AudioSourceInstance *voice = mSoloud->mVoice[ch];
+			int i, slot = -1;
+			for (i = 0; i < SENDS_PER_VOICE && slot == -1; i++)
+				if (voice->mSendBus[i] == mChannelHandle)
+					slot = i;
+			if (slot == -1 && aVolume != 0)
+			{
+				for (i = 0; i < SENDS_PER_VOICE && slot == -1; i++)
+					if (voice->mSendBus[i] == 0)
+						slot = i;
+				if (slot == -1)
+					res = INVALID_PARAMETER;
+				else
+				{
+					voice->mSendBus[slot] = mChannelHandle;
+					voice->mCurrentSendVolume[slot] = 0;
+					voice->mSendState[slot].mValid = false;
+				}
+			}
+			// The mixer fades the send out and frees it once the volume is 0
+			if (slot != -1)
+				voice->mSendVolume[slot] = aVolume;
+		FOR_ALL_VOICES_POST_EXT
+		return res;
+	}
+
 	void Bus::setFilter(unsigned int aFilterId, Filter *aFilter)
 	{
 		if (aFilterId >= FILTERS_PER_STREAM)
@@ -240,17 +503,24 @@ namespace SoLoud
 
 		mFilter[aFilterId] = aFilter;
 
-		if (mInstance)
+		if (mInstance && mSoloud)
 		{
-			mSoloud->lockAudioMutex_internal();
-			delete mInstance->mFilter[aFilterId];
-			mInstance->mFilter[aFilterId] = 0;
-		
+			FilterInstance *instance = 0;
 			if (aFilter)
 			{
-				mInstance->mFilter[aFilterId] = mFilter[aFilterId]->createInstance();
+				instance = aFilter->createInstance();
+				instance->prepare(mChannels, mBaseSamplerate);
+			}
+
+			mSoloud->lockAudioMutex_internal();
+			if (mInstance)
+			{
+				delete mInstance->mFilter[aFilterId];
+				mInstance->mFilter[aFilterId] = instance;
+				instance = 0;
 			}
 			mSoloud->unlockAudioMutex_internal();
+			delete instance;
 		}
 	}
 
@@ -0,0 +1,423 @@
+/*
+SoLoud audio engine
+Copyright (c) 2013-2020 Jari Komppa
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+
+#include "soloud_internal.h"
+
+#if defined(SOLOUD_SSE_INTRINSICS)
+#include <xmmintrin.h>
+#include <emmintrin.h>
+#endif
+
+#if defined(SOLOUD_AVX2_INTRINSICS)
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define SOLOUD_TARGET_AVX2
+#else
+#define SOLOUD_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+#if defined(SOLOUD_NEON_INTRINSICS)
+#include <arm_neon.h>
+#endif
+
+// All clipper paths must round identically, so don't let gcc fuse
+// the multiplies and adds in one path but not in another.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC optimize ("fp-contract=off")
+#endif
+
+namespace SoLoud
+{
+	// Reference clipper. The SIMD paths perform the same operations in the
+	// same order, so every path produces bit-identical output.
+	static inline float clip_sample(float aSample, unsigned int aIndex, float aVolume0, float aVolumeDelta, bool aRoundoff, float aPostClipScaler)
+	{
+		float vol = aVolumeDelta * (float)aIndex;
+		vol = vol + aVolume0;
+		float f = aSample * vol;
+		if (aRoundoff)
+		{
+			if (f <= -1.65f)
+			{
+				f = -0.9862875f;
+			}
+			else
+			if (f >= 1.65f)
+			{
+				f = 0.9862875f;
+			}
+			else
+			{
+				float lin = f * 0.87f;
+				float cubic = f * f;
+				cubic = cubic * f;
+				cubic = cubic * -0.1f;
+				f = cubic + lin;
+			}
+		}
+		else
+		{
+			f = (f <= -1) ? -1 : (f >= 1) ? 1 : f;
+		}
+		return f * aPostClipScaler;
+	}
+
+	// Clips samples aFirst..aSamples of every channel. Also used for the tails of the SIMD paths.
+	static void clip_scalar(const float *aSrc, float *aDst, unsigned int aFirst, unsigned int aSamples, unsigned int aChannels, unsigned int aStride, bool aInterleave, bool aRoundoff, float aVolume0, float aVolumeDelta, float aPostClipScaler)
+	{
+		unsigned int i, j;
+		for (j = 0; j < aChannels; j++)
+		{
+			const float *src = aSrc + j * aStride;
+			for (i = aFirst; i < aSamples; i++)
+			{
+				float f = clip_sample(src[i], i, aVolume0, aVolumeDelta, aRoundoff, aPostClipScaler);
+				if (aInterleave)
+					aDst[i * aChannels + j] = f;
+				else
+					aDst[j * aStride + i] = f;
+			}
+		}
+	}
+
+#if defined(SOLOUD_SSE_INTRINSICS)
+	static inline __m128 clip_sse4(__m128 aSample, __m128 aIndex, __m128 aVolume0, __m128 aVolumeDelta, bool aRoundoff, __m128 aPostClipScaler)
+	{
+		__m128 vol = _mm_mul_ps(aVolumeDelta, aIndex);
+		vol = _mm_add_ps(vol, aVolume0);
+		__m128 f = _mm_mul_ps(aSample, vol);
+		if (aRoundoff)
+		{
+			__m128 lin = _mm_mul_ps(f, _mm_set1_ps(0.87f));
+			__m128 cubic = _mm_mul_ps(f, f);
+			cubic = _mm_mul_ps(cubic, f);
+			cubic = _mm_mul_ps(cubic, _mm_set1_ps(-0.1f));
+			__m128 r = _mm_add_ps(cubic, lin);
+			__m128 lo = _mm_cmple_ps(f, _mm_set1_ps(-1.65f));
+			__m128 hi = _mm_cmpge_ps(f, _mm_set1_ps(1.65f));
+			r = _mm_or_ps(_mm_and_ps(lo, _mm_set1_ps(-0.9862875f)), _mm_andnot_ps(lo, r));
+			r = _mm_or_ps(_mm_and_ps(hi, _mm_set1_ps(0.9862875f)), _mm_andnot_ps(hi, r));
+			f = r;
+		}
+		else
+		{
+			f = _mm_max_ps(f, _mm_set1_ps(-1.0f));
+			f = _mm_min_ps(f, _mm_set1_ps(1.0f));
+		}
+		return _mm_mul_ps(f, aPostClipScaler);
+	}
+
+	static void clip_sse(const float *aSrc, float *aDst, unsigned int aSamples, unsigned int aChannels, unsigned int aStride, bool aInterleave, bool aRoundoff, float aVolume0, float aVolumeDelta, float aPostClipScaler)
+	{
+		unsigned int i, j, k;
+		unsigned int quads = aSamples & ~3;
+		__m128 v0 = _mm_set1_ps(aVolume0);
+		__m128 vd = _mm_set1_ps(aVolumeDelta);
+		__m128 post = _mm_set1_ps(aPostClipScaler);
+		__m128 four = _mm_set1_ps(4.0f);
+		if (!aInterleave || aChannels == 1)
+		{
+			for (j = 0; j < aChannels; j++)
+			{
+				__m128 idx = _mm_set_ps(3, 2, 1, 0);
+				for (i = 0; i < quads; i += 4)
+				{
+					__m128 f = clip_sse4(_mm_loadu_ps(aSrc + j * aStride + i), idx, v0, vd, aRoundoff, post);
+					_mm_storeu_ps(aDst + j * aStride + i, f);
+					idx = _mm_add_ps(idx, four);
+				}
+			}
+		}
+		else
+		if (aChannels == 2)
+		{
+			__m128 idx = _mm_set_ps(3, 2, 1, 0);
+			for (i = 0; i < quads; i += 4)
+			{
+				__m128 l = clip_sse4(_mm_loadu_ps(aSrc + i), idx, v0, vd, aRoundoff, post);
+				__m128 r = clip_sse4(_mm_loadu_ps(aSrc + aStride + i), idx, v0, vd, aRoundoff, post);
+				_mm_storeu_ps(aDst + i * 2, _mm_unpacklo_ps(l, r));
+				_mm_storeu_ps(aDst + i * 2 + 4, _mm_unpackhi_ps(l, r));
+				idx = _mm_add_ps(idx, four);
+			}
+		}
+		else
+		{
+			float tmp[4];
+			__m128 idx = _mm_set_ps(3, 2, 1, 0);
+			for (i = 0; i < quads; i += 4)
+			{
+				for (j = 0; j < aChannels; j++)
+				{
+					_mm_storeu_ps(tmp, clip_sse4(_mm_loadu_ps(aSrc + j * aStride + i), idx, v0, vd, aRoundoff, post));
+					for (k = 0; k < 4; k++)
+						aDst[(i + k) * aChannels + j] = tmp[k];
+				}
+				idx = _mm_add_ps(idx, four);
+			}
+		}
+		clip_scalar(aSrc, aDst, quads, aSamples, aChannels, aStride, aInterleave, aRoundoff, aVolume0, aVolumeDelta, aPostClipScaler);
+	}
+#endif
+
+#if defined(SOLOUD_AVX2_INTRINSICS)
+	SOLOUD_TARGET_AVX2 static inline __m256 clip_avx8(__m256 aSample, __m256 aIndex, __m256 aVolume0, __m256 aVolumeDelta, bool aRoundoff, __m256 aPostClipScaler)
+	{
+		__m256 vol = _mm256_mul_ps(aVolumeDelta, aIndex);
+		vol = _mm256_add_ps(vol, aVolume0);
+		__m256 f = _mm256_mul_ps(aSample, vol);
+		if (aRoundoff)
+		{
+			__m256 lin = _mm256_mul_ps(f, _mm256_set1_ps(0.87f));
+			__m256 cubic = _mm256_mul_ps(f, f);
+			cubic = _mm256_mul_ps(cubic, f);
+			cubic = _mm256_mul_ps(cubic, _mm256_set1_ps(-0.1f));
+			__m256 r = _mm256_add_ps(cubic, lin);
+			r = _mm256_blendv_ps(r, _mm256_set1_ps(-0.9862875f), _mm256_cmp_ps(f, _mm256_set1_ps(-1.65f), _CMP_LE_OQ));
+			r = _mm256_blendv_ps(r, _mm256_set1_ps(0.9862875f), _mm256_cmp_ps(f, _mm256_set1_ps(1.65f), _CMP_GE_OQ));
+			f = r;
+		}
+		else
+		{
+			f = _mm256_max_ps(f, _mm256_set1_ps(-1.0f));
+			f = _mm256_min_ps(f, _mm256_set1_ps(1.0f));
+		}
+		return _mm256_mul_ps(f, aPostClipScaler);
+	}
+
+	SOLOUD_TARGET_AVX2 static void clip_avx2(const float *aSrc, float *aDst, unsigned int aSamples, unsigned int aChannels, unsigned int aStride, bool aInterleave, bool aRoundoff, float aVolume0, float aVolumeDelta, float aPostClipScaler)
+	{
+		unsigned int i, j, k;
+		unsigned int octs = aSamples & ~7;
+		__m256 v0 = _mm256_set1_ps(aVolume0);
+		__m256 vd = _mm256_set1_ps(aVolumeDelta);
+		__m256 post = _mm256_set1_ps(aPostClipScaler);
+		__m256 eight = _mm256_set1_ps(8.0f);
+		if (!aInterleave || aChannels == 1)
+		{
+			for (j = 0; j < aChannels; j++)
+			{
+				__m256 idx = _mm256_set_ps(7, 6, 5, 4, 3, 2, 1, 0);
+				for (i = 0; i < octs; i += 8)
+				{
+					__m256 f = clip_avx8(_mm256_loadu_ps(aSrc + j * aStride + i), idx, v0, vd, aRoundoff, post);
+					_mm256_storeu_ps(aDst + j * aStride + i, f);
+					idx = _mm256_add_ps(idx, eight);
+				}
+			}
+		}
+		else
+		if (aChannels == 2)
+		{
+			__m256 idx = _mm256_set_ps(7, 6, 5, 4, 3, 2, 1, 0);
+			for (i = 0; i < octs; i += 8)
+			{
+				__m256 l = clip_avx8(_mm256_loadu_ps(aSrc + i), idx, v0, vd, aRoundoff, post);
+				__m256 r = clip_avx8(_mm256_loadu_ps(aSrc + aStride + i), idx, v0, vd, aRoundoff, post);
+				// unpack works within 128-bit halves, so swap the halves back in order
+				__m256 lo = _mm256_unpacklo_ps(l, r);
+				__m256 hi = _mm256_unpackhi_ps(l, r);
+				_mm256_storeu_ps(aDst + i * 2, _mm256_permute2f128_ps(lo, hi, 0x20));
+				_mm256_storeu_ps(aDst + i * 2 + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+				idx = _mm256_add_ps(idx, eight);
+			}
+		}
+		else
+		{
+			float tmp[8];
+			__m256 idx = _mm256_set_ps(7, 6, 5, 4, 3, 2, 1, 0);
+			for (i = 0; i < octs; i += 8)
+			{
+				for (j = 0; j < aChannels; j++)
+				{
+					_mm256_storeu_ps(tmp, clip_avx8(_mm256_loadu_ps(aSrc + j * aStride + i), idx, v0, vd, aRoundoff, post));
+					for (k = 0; k < 8; k++)
+						aDst[(i + k) * aChannels + j] = tmp[k];
+				}
+				idx = _mm256_add_ps(idx, eight);
+			}
+		}
+		clip_scalar(aSrc, aDst, octs, aSamples, aChannels, aStride, aInterleave, aRoundoff, aVolume0, aVolumeDelta, aPostClipScaler);
+	}
+
+	static bool cpu_has_avx2()
+	{
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+			return false;
+		__cpuid(info, 1);
+		// OSXSAVE and AVX
+		if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0)
+			return false;
+		// OS saves the ymm registers
+		if ((_xgetbv(0) & 6) != 6)
+			return false;
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		return __builtin_cpu_supports("avx2") != 0;
+#endif
+	}
+#endif
+
+#if defined(SOLOUD_NEON_INTRINSICS)
+	static inline float32x4_t clip_neon4(float32x4_t aSample, float32x4_t aIndex, float32x4_t aVolume0, float32x4_t aVolumeDelta, bool aRoundoff, float32x4_t aPostClipScaler)
+	{
+		float32x4_t vol = vmulq_f32(aVolumeDelta, aIndex);
+		vol = vaddq_f32(vol, aVolume0);
+		float32x4_t f = vmulq_f32(aSample, vol);
+		if (aRoundoff)
+		{
+			float32x4_t lin = vmulq_f32(f, vdupq_n_f32(0.87f));
+			float32x4_t cubic = vmulq_f32(f, f);
+			cubic = vmulq_f32(cubic, f);
+			cubic = vmulq_f32(cubic, vdupq_n_f32(-0.1f));
+			float32x4_t r = vaddq_f32(cubic, lin);
+			r = vbslq_f32(vcleq_f32(f, vdupq_n_f32(-1.65f)), vdupq_n_f32(-0.9862875f), r);
+			r = vbslq_f32(vcgeq_f32(f, vdupq_n_f32(1.65f)), vdupq_n_f32(0.9862875f), r);
+			f = r;
+		}
+		else
+		{
+			f = vmaxq_f32(f, vdupq_n_f32(-1.0f));
+			f = vminq_f32(f, vdupq_n_f32(1.0f));
+		}
+		return vmulq_f32(f, aPostClipScaler);
+	}
+
+	static void clip_neon(const float *aSrc, float *aDst, unsigned int aSamples, unsigned int aChannels, unsigned int aStride, bool aInterleave, bool aRoundoff, float aVolume0, float aVolumeDelta, float aPostClipScaler)
+	{
+		unsigned int i, j, k;
+		unsigned int quads = aSamples & ~3;
+		static const float first[4] = { 0, 1, 2, 3 };
+		float32x4_t v0 = vdupq_n_f32(aVolume0);
+		float32x4_t vd = vdupq_n_f32(aVolumeDelta);
+		float32x4_t post = vdupq_n_f32(aPostClipScaler);
+		float32x4_t four = vdupq_n_f32(4.0f);
+		if (!aInterleave || aChannels == 1)
+		{
+			for (j = 0; j < aChannels; j++)
+			{
+				float32x4_t idx = vld1q_f32(first);
+				for (i = 0; i < quads; i += 4)
+				{
+					float32x4_t f = clip_neon4(vld1q_f32(aSrc + j * aStride + i), idx, v0, vd, aRoundoff, post);
+					vst1q_f32(aDst + j * aStride + i, f);
+					idx = vaddq_f32(idx, four);
+				}
+			}
+		}
+		else
+		if (aChannels == 2)
+		{
+			float32x4_t idx = vld1q_f32(first);
+			for (i = 0; i < quads; i += 4)
+			{
+				float32x4x2_t lr;
+				lr.val[0] = clip_neon4(vld1q_f32(aSrc + i), idx, v0, vd, aRoundoff, post);
+				lr.val[1] = clip_neon4(vld1q_f32(aSrc + aStride + i), idx, v0, vd, aRoundoff, post);
+				vst2q_f32(aDst + i * 2, lr);
+				idx = vaddq_f32(idx, four);
+			}
+		}
+		else
+		{
+			float tmp[4];
+			float32x4_t idx = vld1q_f32(first);
+			for (i = 0; i < quads; i += 4)
+			{
+				for (j = 0; j < aChannels; j++)
+				{
+					vst1q_f32(tmp, clip_neon4(vld1q_f32(aSrc + j * aStride + i), idx, v0, vd, aRoundoff, post));
+					for (k = 0; k < 4; k++)
+						aDst[(i + k) * aChannels + j] = tmp[k];
+				}
+				idx = vaddq_f32(idx, four);
+			}
+		}
+		clip_scalar(aSrc, aDst, quads, aSamples, aChannels, aStride, aInterleave, aRoundoff, aVolume0, aVolumeDelta, aPostClipScaler);
+	}
+#endif
+
+	bool simd_path_supported(unsigned int aPath)
+	{
+		switch (aPath)
+		{
+		case SIMD_SCALAR:
+			return true;
+#if defined(SOLOUD_SSE_INTRINSICS)
+		case SIMD_SSE:
+			return true;
+#endif
+#if defined(SOLOUD_AVX2_INTRINSICS)
+		case SIMD_AVX2:
+			return cpu_has_avx2();
+#endif
+#if defined(SOLOUD_NEON_INTRINSICS)
+		case SIMD_NEON:
+			return true;
+#endif
+		}
+		return false;
+	}
+
+	unsigned int simd_detect_path()
+	{
+		if (simd_path_supported(SIMD_AVX2))
+			return SIMD_AVX2;
+		if (simd_path_supported(SIMD_SSE))
+			return SIMD_SSE;
+		if (simd_path_supported(SIMD_NEON))
+			return SIMD_NEON;
+		return SIMD_SCALAR;
+	}
+
+	void clip_samples(unsigned int aPath, const float *aSrc, float *aDst, unsigned int aSamples, unsigned int aChannels, unsigned int aStride, bool aInterleave, bool aRoundoff, float aVolume0, float aVolumeDelta, float aPostClipScaler)
+	{
+		switch (aPath)
+		{
+#if defined(SOLOUD_SSE_INTRINSICS)
+		case SIMD_SSE:
+			clip_sse(aSrc, aDst, aSamples, aChannels, aStride, aInterleave, aRoundoff, aVolume0, aVolumeDelta, aPostClipScaler);
+			return;
+#endif
+#if defined(SOLOUD_AVX2_INTRINSICS)
+		case SIMD_AVX2:
+			clip_avx2(aSrc, aDst, aSamples, aChannels, aStride, aInterleave, aRoundoff, aVolume0, aVolumeDelta, aPostClipScaler);
+			return;
+#endif
+#if defined(SOLOUD_NEON_INTRINSICS)
+		case SIMD_NEON:
+			clip_neon(aSrc, aDst, aSamples, aChannels, aStride, aInterleave, aRoundoff, aVolume0, aVolumeDelta, aPostClipScaler);
+			return;
+#endif
+		}
+		clip_scalar(aSrc, aDst, 0, aSamples, aChannels, aStride, aInterleave, aRoundoff, aVolume0, aVolumeDelta, aPostClipScaler);
+	}
+};
@@ -24,6 +24,7 @@ freely, subject to the following restrictions:
 
 #include <string.h>
 #include "soloud_internal.h"
+#include "soloud_bus.h"
 
 // Core "basic" operations - play, stop, etc
 
@@ -42,14 +43,57 @@ namespace SoLoud
 		aSound.mSoloud = this;
 		SoLoud::AudioSourceInstance *instance = aSound.createInstance();
 
+		// Same goes for filters, which may need to allocate delay lines.
+		unsigned int sharedbus = 0;
+		if ((aSound.mFlags & AudioSource::SHARED_FILTERS) && !(instance->mFlags & AudioSourceInstance::BUS))
+		{
+			sharedbus = getSharedFilterBus_internal(aSound, aBus);
+		}
+
+		FilterInstance *filter[FILTERS_PER_STREAM];
+		int i;
+		for (i = 0; i < FILTERS_PER_STREAM; i++)
+		{
+			filter[i] = 0;
+			if (aSound.mFilter[i] && !sharedbus)
+			{
+				filter[i] = aSound.mFilter[i]->createInstance();
+				filter[i]->prepare(aSound.mChannels, aSound.mBaseSamplerate);
+			}
+		}
+
 		lockAudioMutex_internal();
-		int ch = findFreeVoice_internal();
+		if (!applyVoiceLimits_internal(aSound))
+		{
+			unlockAudioMutex_internal();
+			delete instance;
+			for (i = 0; i < FILTERS_PER_STREAM; i++)
+				delete filter[i];
+			return 0;
+		}
+		int ch = findFreeVoice_internal(aSound.mPriority);
 		if (ch < 0) 
 		{
 			unlockAudioMutex_internal();
 			delete instance;
+			for (i = 0; i < FILTERS_PER_STREAM; i++)
+				delete filter[i];
 			return UNKNOWN_ERROR;
 		}
+
+		if (sharedbus && getVoiceFromHandle_internal(sharedbus) == -1)
+		{
+			// The submix stopped in the meantime; fall back to our own filters
+			sharedbus = 0;
+			for (i = 0; i < FILTERS_PER_STREAM; i++)
+			{
+				if (aSound.mFilter[i])
+				{
+					filter[i] = aSound.mFilter[i]->createInstance();
+					filter[i]->prepare(aSound.mChannels, aSound.mBaseSamplerate);
+				}
+			}
+		}
 		if (!aSound.mAudioSourceID)
 		{
 			aSound.mAudioSourceID = mAudioSourceID;
@@ -57,7 +101,7 @@ namespace SoLoud
 		}
 		mVoice[ch] = instance;
 		mVoice[ch]->mAudioSourceID = aSound.mAudioSourceID;
-		mVoice[ch]->mBusHandle = aBus;
+		mVoice[ch]->mBusHandle = sharedbus ? sharedbus : aBus;
 		mVoice[ch]->init(aSound, mPlayIndex);
 		m3dData[ch].init(aSound);
 
@@ -85,7 +129,6 @@ namespace SoLoud
 		}
 
 		// Fix initial voice volume ramp up		
-		int i;
 		for (i = 0; i < MAX_CHANNELS; i++)
 		{
 			mVoice[ch]->mCurrentChannelVolume[i] = mVoice[ch]->mChannelVolume[i] * mVoice[ch]->mOverallVolume;
@@ -95,10 +138,7 @@ namespace SoLoud
 		
 		for (i = 0; i < FILTERS_PER_STREAM; i++)
 		{
-			if (aSound.mFilter[i])
-			{
-				mVoice[ch]->mFilter[i] = aSound.mFilter[i]->createInstance();
-			}
+			mVoice[ch]->mFilter[i] = filter[i];
 		}
 
 		mActiveVoiceDirty = true;
@@ -109,6 +149,50 @@ namespace SoLoud
 		return handle;
 	}
 
+	handle Soloud::getSharedFilterBus_internal(AudioSource &aSound, unsigned int aBus)
+	{
+		int i;
+		bool hasfilters = false;
+		for (i = 0; i < FILTERS_PER_STREAM; i++)
+		{
+			if (aSound.mFilter[i])
+				hasfilters = true;
+		}
+		if (!hasfilters)
+			return 0;
+
+		lockAudioMutex_internal();
+		int voiceno = aSound.mSharedFilterHandle ? getVoiceFromHandle_internal(aSound.mSharedFilterHandle) : -1;
+		if (voiceno != -1)
+		{
+			// All instances share the one submix; if this one is going elsewhere, it gets filters of its own.
+			handle h = mVoice[voiceno]->mBusHandle == aBus ? aSound.mSharedFilterHandle : 0;
+			unlockAudioMutex_internal();
+			return h;
+		}
+		unlockAudioMutex_internal();
+
+		if (aSound.mSharedFilterBus == 0)
+		{
+			aSound.mSharedFilterBus = new Bus;
+			if (aSound.mSharedFilterBus == 0)
+				return 0;
+			aSound.mSharedFilterBus->mStopWhenIdle = true;
+		}
+
+		Bus *bus = aSound.mSharedFilterBus;
+		for (i = 0; i < FILTERS_PER_STREAM; i++)
+			bus->mFilter[i] = aSound.mFilter[i];
+		bus->mChannels = aSound.mChannels > 2 ? aSound.mChannels : 2;
+
+		handle h = play(*bus, 1.0f, 0.0f, false, aBus);
+		if (!isValidVoiceHandle(h))
+			return 0;
+		bus->mChannelHandle = h;
+		aSound.mSharedFilterHandle = h;
+		return h;
+	}
+
 	handle Soloud::playClocked(time aSoundTime, AudioSource &aSound, float aVolume, float aPan, unsigned int aBus)
 	{
 		handle h = play(aSound, aVolume, aPan, 1, aBus);
@@ -206,4 +290,102 @@ namespace SoLoud
 		return count;
 	}
 
+	int Soloud::countCategory(unsigned int aCategory)
+	{
+		int count = 0;
+		if (aCategory && aCategory < VOICE_CATEGORY_COUNT)
+		{
+			lockAudioMutex_internal();
+
+			int i;
+			for (i = 0; i < (signed)mHighestVoice; i++)
+			{
+				if (mVoice[i] && mVoice[i]->mCategory == aCategory)
+				{
+					count++;
+				}
+			}
+			unlockAudioMutex_internal();
+		}
+		return count;
+	}
+
+	int Soloud::findWeakestVoice_internal(unsigned int aAudioSourceID, unsigned int aCategory, const bool *aSkip)
+	{
+		int weakest = -1;
+		int i;
+		for (i = 0; i < (signed)mHighestVoice; i++)
+		{
+			AudioSourceInstance *voice = mVoice[i];
+			if (voice &&
+				!(voice->mFlags & AudioSourceInstance::PROTECTED) &&
+				!aSkip[i] &&
+				(aAudioSourceID == 0 || voice->mAudioSourceID == aAudioSourceID) &&
+				(aCategory == 0 || voice->mCategory == aCategory) &&
+				(weakest == -1 || isVoiceWeaker_internal(voice, mVoice[weakest])))
+			{
+				weakest = i;
+			}
+		}
+		return weakest;
+	}
+
+	bool Soloud::applyVoiceLimits_internal(AudioSource &aSound)
+	{
+		unsigned int category = aSound.mCategory < VOICE_CATEGORY_COUNT ? aSound.mCategory : 0;
+		unsigned int categorylimit = category ? mCategoryLimit[category] : 0;
+		// A source that hasn't played yet has no instances to count
+		unsigned int instancelimit = aSound.mAudioSourceID ? aSound.mInstanceLimit : 0;
+		if (categorylimit == 0 && instancelimit == 0)
+			return true;
+
+		unsigned int instances = 0, categoryvoices = 0;
+		int i;
+		for (i = 0; i < (signed)mHighestVoice; i++)
+		{
+			if (mVoice[i])
+			{
+				if (mVoice[i]->mAudioSourceID == aSound.mAudioSourceID)
+					instances++;
+				if (category && mVoice[i]->mCategory == category)
+					categoryvoices++;
+			}
+		}
+
+		bool instancefull = instancelimit && instances >= instancelimit;
+		bool categoryfull = categorylimit && categoryvoices >= categorylimit;
+		if ((instancefull && !aSound.mInstanceLimitSteal) || (categoryfull && !mCategoryLimitSteal[category]))
+			return false;
+
+		// Pick all the victims before stopping any, so a rejected sound doesn't stop anything
+		bool victim[VOICE_COUNT];
+		for (i = 0; i < (signed)mHighestVoice; i++)
+			victim[i] = false;
+
+		while (instancelimit && instances >= instancelimit)
+		{
+			int v = findWeakestVoice_internal(aSound.mAudioSourceID, 0, victim);
+			if (v < 0)
+				return false;
+			if (category && mVoice[v]->mCategory == category)
+				categoryvoices--;
+			victim[v] = true;
+			instances--;
+		}
+
+		while (categorylimit && categoryvoices >= categorylimit)
+		{
+			int v = findWeakestVoice_internal(0, category, victim);
+			// Don't steal from a more important sound
+			if (v < 0 || mVoice[v]->mPriority > aSound.mPriority)
+				return false;
+			victim[v] = true;
+			categoryvoices--;
+		}
+
+		for (i = 0; i < (signed)mHighestVoice; i++)
+			if (victim[i])
+				stopVoice_internal(i);
+		return true;
+	}
 }
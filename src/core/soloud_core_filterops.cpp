@@ -24,6 +24,10 @@ freely, subject to the following restrictions:
 
 #include "soloud_internal.h"
 
+// Resampler playhead fraction; must match soloud.cpp
+#define FIXPOINT_FRAC_BITS 20
+#define FIXPOINT_FRAC_MUL (1 << FIXPOINT_FRAC_BITS)
+
 // Core operations related to filters
 
 namespace SoLoud
@@ -33,15 +37,17 @@ namespace SoLoud
 		if (aFilterId >= FILTERS_PER_STREAM)
 			return;
 
-		lockAudioMutex_internal();
-		delete mFilterInstance[aFilterId];
-		mFilterInstance[aFilterId] = 0;
-		
-		mFilter[aFilterId] = aFilter;
+		FilterInstance *instance = 0;
 		if (aFilter)
 		{
-			mFilterInstance[aFilterId] = mFilter[aFilterId]->createInstance();
+			instance = aFilter->createInstance();
+			instance->prepare(mChannels, (float)mSamplerate);
 		}
+
+		lockAudioMutex_internal();
+		delete mFilterInstance[aFilterId];
+		mFilterInstance[aFilterId] = instance;
+		mFilter[aFilterId] = aFilter;
 		unlockAudioMutex_internal();
 	}
 
@@ -153,4 +159,96 @@ namespace SoLoud
 		FOR_ALL_VOICES_POST
 	}
 
+	void Soloud::setFilterParameterClocked(time aSoundTime, handle aVoiceHandle, unsigned int aFilterId, unsigned int aAttributeId, float aValue)
+	{
+		if (aFilterId >= FILTERS_PER_STREAM)
+			return;
+
+		lockAudioMutex_internal();
+		// mLastClockedTime is cleared to zero at start of every output buffer
+		time lasttime = mLastClockedTime;
+		if (lasttime == 0)
+		{
+			mLastClockedTime = aSoundTime;
+			lasttime = aSoundTime;
+		}
+		unlockAudioMutex_internal();
+		int samples = (int)floor((aSoundTime - lasttime) * mSamplerate);
+		// Make sure we don't delay too much (or overflow)
+		if (samples < 0 || samples > 2048)
+			samples = 0;
+
+		if (aVoiceHandle == 0)
+		{
+			lockAudioMutex_internal();
+			if (mFilterInstance[aFilterId])
+			{
+				mFilterInstance[aFilterId]->scheduleFilterParameter(aAttributeId, aValue, samples);
+			}
+			unlockAudioMutex_internal();
+			return;
+		}
+
+		FOR_ALL_VOICES_PRE
+		AudioSourceInstance *voice = mVoice[ch];
+		if (voice &&
+			voice->mFilter[aFilterId])
+		{
+			// Voices are mixed at the rate and with the resampler of the bus they play on
+			float busrate = (float)mSamplerate;
+			unsigned int resampler = mResampler;
+			int bus = voice->mBusHandle ? getVoiceFromHandle_internal(voice->mBusHandle) : -1;
+			if (bus != -1 && mVoice[bus] && (mVoice[bus]->mFlags & AudioSourceInstance::BUS))
+			{
+				busrate = mVoice[bus]->mSamplerate;
+				resampler = ((BusInstance *)mVoice[bus])->mParent->mResampler;
+			}
+			// Output samples until the change, after any delayed start
+			double out = samples * (double)busrate / mSamplerate - voice->mDelaySamples;
+			if (out < 0)
+				out = 0;
+			// Voice filters run on source blocks read ahead of the output, and the
+			// delay counts from the next block they process. Find the playhead in
+			// the current block; without leftover samples, the next block is read
+			// before anything more is played.
+			double pos = (double)voice->mSrcOffset / FIXPOINT_FRAC_MUL;
+			if (voice->mLeftoverSamples == 0 && pos < SAMPLE_GRANULARITY)
+				pos = SAMPLE_GRANULARITY;
+			// The interpolating resamplers play from behind the playhead
+			if (resampler == RESAMPLER_LINEAR)
+				pos -= 1;
+			if (resampler == RESAMPLER_CATMULLROM)
+				pos -= 2;
+			double delay = pos - SAMPLE_GRANULARITY + out * voice->mSamplerate / busrate;
+			// A change that falls in the block already filtered happens at the next block
+			voice->mFilter[aFilterId]->scheduleFilterParameter(aAttributeId, aValue, delay > 0 ? (unsigned int)floor(delay) : 0);
+		}
+		FOR_ALL_VOICES_POST
+	}
+
+	void Soloud::setFilterParameterSmoothing(handle aVoiceHandle, unsigned int aFilterId, unsigned int aAttributeId, unsigned int aMode, time aTime)
+	{
+		if (aFilterId >= FILTERS_PER_STREAM)
+			return;
+
+		if (aVoiceHandle == 0)
+		{
+			lockAudioMutex_internal();
+			if (mFilterInstance[aFilterId])
+			{
+				mFilterInstance[aFilterId]->setFilterParameterSmoothing(aAttributeId, aMode, aTime);
+			}
+			unlockAudioMutex_internal();
+			return;
+		}
+
+		FOR_ALL_VOICES_PRE
+		if (mVoice[ch] &&
+			mVoice[ch]->mFilter[aFilterId])
+		{
+			mVoice[ch]->mFilter[aFilterId]->setFilterParameterSmoothing(aAttributeId, aMode, aTime);
+		}
+		FOR_ALL_VOICES_POST
+	}
+
 }
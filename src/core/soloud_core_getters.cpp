@@ -22,7 +22,10 @@ freely, subject to the following restrictions:
    distribution.
 */
 
+#include <string.h>
 #include "soloud.h"
+#include "soloud_thread.h"
+#include "soloud_internal.h"
 
 // Getters - return information about SoLoud state
 
@@ -107,6 +110,47 @@ namespace SoLoud
 		return c;
 	}
 
+	unsigned int Soloud::getVirtualVoiceCount()
+	{
+		lockAudioMutex_internal();
+		if (mActiveVoiceDirty)
+			calcActiveVoices_internal();
+		int i;
+		int c = 0;
+		for (i = 0; i < (signed)mHighestVoice; i++)
+		{
+			if (mVoice[i] && (mVoice[i]->mFlags & AudioSourceInstance::VIRTUAL))
+			{
+				c++;
+			}
+		}
+		unlockAudioMutex_internal();
+		return c;
+	}
+
+	result Soloud::getVoiceMeter(handle aVoiceHandle, VoiceMeter &aMeter)
+	{
+		unsigned int voice = (aVoiceHandle & 0xfff) - 1;
+		if ((aVoiceHandle & 0xfffff000) == 0xfffff000 || voice >= VOICE_COUNT)
+			return INVALID_PARAMETER;
+		VoiceMeterSlot &slot = mVoiceMeter[voice];
+		// The mixer may be writing the slot; retry until we get a consistent copy
+		int tries;
+		for (tries = 0; tries < 16; tries++)
+		{
+			unsigned int sequence = slot.mSequence;
+			if (sequence & 1)
+				continue;
+			Thread::memoryBarrier();
+			handle h = slot.mHandle;
+			aMeter = slot.mMeter;
+			Thread::memoryBarrier();
+			if (slot.mSequence == sequence)
+				return h == aVoiceHandle ? SO_NO_ERROR : INVALID_PARAMETER;
+		}
+		return UNKNOWN_ERROR;
+	}
+
 	bool Soloud::isValidVoiceHandle(handle aVoiceHandle)
 	{
 		// voice groups are not valid voice handles
@@ -306,11 +350,10 @@ namespace SoLoud
 		return v != 0;
 	}
 
-	int Soloud::findFreeVoice_internal()
+	int Soloud::findFreeVoice_internal(int aPriority)
 	{
 		int i;
-		unsigned int lowest_play_index_value = 0xffffffff;
-		int lowest_play_index = -1;
+		int weakest = -1;
 		
 		// (slowly) drag the highest active voice index down
 		if (mHighestVoice > 0 && mVoice[mHighestVoice - 1] == NULL)
@@ -326,15 +369,19 @@ namespace SoLoud
 				}
 				return i;
 			}
-			if (((mVoice[i]->mFlags & AudioSourceInstance::PROTECTED) == 0) && 
-				mVoice[i]->mPlayIndex < lowest_play_index_value)
+			// Steal the least important voice; the oldest one if there's a tie
+			if (((mVoice[i]->mFlags & AudioSourceInstance::PROTECTED) == 0) &&
+				(weakest == -1 ||
+				isVoiceWeaker_internal(mVoice[i], mVoice[weakest]) ||
+				(!isVoiceWeaker_internal(mVoice[weakest], mVoice[i]) && mVoice[i]->mPlayIndex < mVoice[weakest]->mPlayIndex)))
 			{
-				lowest_play_index_value = mVoice[i]->mPlayIndex;
-				lowest_play_index = i;
+				weakest = i;
 			}
 		}
-		stopVoice_internal(lowest_play_index);
-		return lowest_play_index;
+		if (weakest == -1 || mVoice[weakest]->mPriority > aPriority)
+			return -1;
+		stopVoice_internal(weakest);
+		return weakest;
 	}
 
 	unsigned int Soloud::getLoopCount(handle aVoiceHandle)
@@ -382,6 +429,101 @@ namespace SoLoud
 		return mBufferSize;
 	}
 
+	unsigned int Soloud::getCaptureChannels()
+	{
+		return mCaptureChannels;
+	}
+
+	unsigned int Soloud::getBackendXrunCount()
+	{
+		return mBackendXrunCount;
+	}
+
+	time Soloud::getBackendJitterAverage()
+	{
+		if (mBackendJitterCount == 0)
+			return 0;
+		return mBackendJitterSum / mBackendJitterCount;
+	}
+
+	time Soloud::getBackendJitterMax()
+	{
+		return mBackendJitterMax;
+	}
+
+	unsigned int Soloud::getProfileFrames(ProfileFrame *aFrames, unsigned int aMaxFrames)
+	{
+		if (aFrames == 0)
+			return 0;
+		unsigned int written = mProfileWriteIndex;
+		Thread::memoryBarrier();
+		// The slot after the newest one may be half overwritten already
+		unsigned int count = written < PROFILE_FRAMES - 1 ? written : PROFILE_FRAMES - 1;
+		if (count > aMaxFrames)
+			count = aMaxFrames;
+		unsigned int first = written - count;
+		unsigned int i;
+		for (i = 0; i < count; i++)
+			aFrames[i] = mProfileRing[(first + i) % PROFILE_FRAMES];
+		Thread::memoryBarrier();
+
+		// Drop frames the mixer lapped while we were copying
+		unsigned int now = mProfileWriteIndex;
+		unsigned int oldest = now > PROFILE_FRAMES - 1 ? now - (PROFILE_FRAMES - 1) : 0;
+		if ((int)(oldest - first) > 0)
+		{
+			unsigned int skip = oldest - first;
+			if (skip >= count)
+				return 0;
+			for (i = 0; i < count - skip; i++)
+				aFrames[i] = aFrames[i + skip];
+			count -= skip;
+		}
+		return count;
+	}
+
+	void Soloud::getProfileStats(ProfileStats &aStats)
+	{
+		memset(&aStats, 0, sizeof(aStats));
+		ProfileFrame frames[PROFILE_FRAMES];
+		unsigned int count = getProfileFrames(frames, PROFILE_FRAMES);
+		aStats.mFrames = count;
+		aStats.mTotalFrames = mProfileWriteIndex;
+		if (count == 0)
+			return;
+
+		unsigned int i, j;
+		for (i = 0; i < count; i++)
+		{
+			const ProfileFrame &f = frames[i];
+			for (j = 0; j < ProfileFrame::STAGE_COUNT; j++)
+			{
+				aStats.mAverageNanos[j] += (double)f.mStageNanos[j];
+				if (aStats.mMaxNanos[j] < f.mStageNanos[j])
+					aStats.mMaxNanos[j] = f.mStageNanos[j];
+			}
+			aStats.mAverageTotalNanos += (double)f.mTotalNanos;
+			if (aStats.mMaxTotalNanos < f.mTotalNanos)
+				aStats.mMaxTotalNanos = f.mTotalNanos;
+			aStats.mAverageVoicesMixed += (float)f.mVoicesMixed;
+			if (aStats.mMaxVoicesMixed < f.mVoicesMixed)
+				aStats.mMaxVoicesMixed = f.mVoicesMixed;
+			aStats.mAverageVoicesVirtual += (float)f.mVoicesVirtual;
+			if (aStats.mMaxVoicesVirtual < f.mVoicesVirtual)
+				aStats.mMaxVoicesVirtual = f.mVoicesVirtual;
+			aStats.mUnderruns += f.mUnderruns;
+			aStats.mAverageDutyCycle += f.mDutyCycle;
+			if (aStats.mMaxDutyCycle < f.mDutyCycle)
+				aStats.mMaxDutyCycle = f.mDutyCycle;
+		}
+		for (j = 0; j < ProfileFrame::STAGE_COUNT; j++)
+			aStats.mAverageNanos[j] /= count;
+		aStats.mAverageTotalNanos /= count;
+		aStats.mAverageVoicesMixed /= count;
+		aStats.mAverageVoicesVirtual /= count;
+		aStats.mAverageDutyCycle /= count;
+	}
+
 	// Get speaker position in 3d space
 	result Soloud::getSpeakerPosition(unsigned int aChannel, float &aX, float &aY, float &aZ)
 	{
@@ -70,6 +70,17 @@ namespace SoLoud
 		FOR_ALL_VOICES_POST
 	}
 
+	result Soloud::setCategoryLimit(unsigned int aCategory, unsigned int aMaxVoices, bool aSteal)
+	{
+		if (aCategory == 0 || aCategory >= VOICE_CATEGORY_COUNT)
+			return INVALID_PARAMETER;
+		lockAudioMutex_internal();
+		mCategoryLimit[aCategory] = aMaxVoices;
+		mCategoryLimitSteal[aCategory] = aSteal;
+		unlockAudioMutex_internal();
+		return SO_NO_ERROR;
+	}
+
 	result Soloud::setMaxActiveVoiceCount(unsigned int aVoiceCount)
 	{
 		if (aVoiceCount == 0 || aVoiceCount >= VOICE_COUNT)
@@ -178,6 +189,21 @@ namespace SoLoud
 		FOR_ALL_VOICES_POST
 	}
 
+	void Soloud::setMetering(handle aVoiceHandle, bool aEnable)
+	{
+		FOR_ALL_VOICES_PRE
+			if (aEnable)
+			{
+				mVoice[ch]->mFlags |= AudioSourceInstance::METERING;
+			}
+			else
+			{
+				mVoice[ch]->mFlags &= ~AudioSourceInstance::METERING;
+				publishMeter_internal(ch);
+			}
+		FOR_ALL_VOICES_POST
+	}
+
 	void Soloud::setLoopPoint(handle aVoiceHandle, time aLoopPoint)
 	{
 		FOR_ALL_VOICES_PRE
@@ -240,6 +266,20 @@ namespace SoLoud
 		}
 	}
 
+	void Soloud::setProfilingEnable(bool aEnable)
+	{
+		if (aEnable)
+		{
+			// Don't charge xruns from before profiling to the first frame
+			mProfileXrunCount = mBackendXrunCount;
+			mFlags |= ENABLE_PROFILING;
+		}
+		else
+		{
+			mFlags &= ~ENABLE_PROFILING;
+		}
+	}
+
 	result Soloud::setSpeakerPosition(unsigned int aChannel, float aX, float aY, float aZ)
 	{
 		if (aChannel >= mChannels)
@@ -23,6 +23,7 @@ freely, subject to the following restrictions:
 */
 
 #include "soloud.h"
+#include "soloud_internal.h"
 
 // Direct voice operations (no mutexes - called from other functions)
 
@@ -123,6 +124,8 @@ namespace SoLoud
 			// Delete via temporary variable to avoid recursion
 			AudioSourceInstance * v = mVoice[aVoice];
 			mVoice[aVoice] = 0;
+			if (mVoiceMeter[aVoice].mHandle)
+				publishMeter_internal(aVoice);
 
 			unsigned int i;
 			for (i = 0; i < mMaxActiveVoices; i++)
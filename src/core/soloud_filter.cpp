@@ -66,6 +66,14 @@ namespace SoLoud
 		mParamChanged = 0;
 		mParam = 0;
 		mParamFader = 0;
+		mParamSmoother = 0;
+		mSmoothingActive = 0;
+		mEventCount = 0;
+		mSidechainHandle = 0;
+		mSidechainPeak = 0;
+		mSidechainRMS = 0;
+		mSilentSamples = 0;
+		mFlushed = false;
 	}
 
 	result FilterInstance::initParams(int aNumParams)
@@ -73,15 +81,21 @@ namespace SoLoud
 		mNumParams = aNumParams;
 		delete[] mParam;
 		delete[] mParamFader;
+		delete[] mParamSmoother;
 		mParam = new float[mNumParams];
 		mParamFader = new Fader[mNumParams];
+		mParamSmoother = new FilterParamSmoother[mNumParams];
+		mSmoothingActive = 0;
+		mEventCount = 0;
 
-		if (mParam == NULL || mParamFader == NULL)
+		if (mParam == NULL || mParamFader == NULL || mParamSmoother == NULL)
 		{
 			delete[] mParam;
 			delete[] mParamFader;
+			delete[] mParamSmoother;
 			mParam = NULL;
 			mParamFader = NULL;
+			mParamSmoother = NULL;
 			mNumParams = 0;
 			return OUT_OF_MEMORY;
 		}
@@ -91,12 +105,20 @@ namespace SoLoud
 		{
 			mParam[i] = 0;
 			mParamFader[i].mActive = 0;
+			mParamSmoother[i].mMode = Filter::NO_SMOOTHING;
+			mParamSmoother[i].mTime = 0;
+			mParamSmoother[i].mTarget = 0;
+			mParamSmoother[i].mStep = 0;
 		}
 		mParam[0] = 1; // set 'wet' to 1
 
 		return 0;
 	}
 
+	void FilterInstance::prepare(unsigned int /*aChannels*/, float /*aSamplerate*/)
+	{
+	}
+
 	void FilterInstance::updateParams(double aTime)
 	{
 		unsigned int i;
@@ -104,8 +126,18 @@ namespace SoLoud
 		{
 			if (mParamFader[i].mActive > 0)
 			{
-				mParamChanged |= 1 << i;
-				mParam[i] = mParamFader[i].get(aTime);
+				if (mParamSmoother[i].mMode != Filter::NO_SMOOTHING)
+				{
+					// Fader sets the target, the smoother takes care of the rest
+					mParamSmoother[i].mTarget = mParamFader[i].get(aTime);
+					mParamSmoother[i].mStep = 0;
+					mSmoothingActive |= 1 << i;
+				}
+				else
+				{
+					mParamChanged |= 1 << i;
+					mParam[i] = mParamFader[i].get(aTime);
+				}
 			}
 		}
 	}
@@ -114,6 +146,7 @@ namespace SoLoud
 	{
 		delete[] mParam;
 		delete[] mParamFader;
+		delete[] mParamSmoother;
 	}
 
 	void FilterInstance::setFilterParameter(unsigned int aAttributeId, float aValue)
@@ -122,10 +155,157 @@ namespace SoLoud
 			return;
 
 		mParamFader[aAttributeId].mActive = 0;
+		if (mParamSmoother[aAttributeId].mMode != Filter::NO_SMOOTHING)
+		{
+			mParamSmoother[aAttributeId].mTarget = aValue;
+			mParamSmoother[aAttributeId].mStep = 0;
+			mSmoothingActive |= 1 << aAttributeId;
+			return;
+		}
 		mParam[aAttributeId] = aValue;
 		mParamChanged |= 1 << aAttributeId;
 	}
 
+	void FilterInstance::setFilterParameterSmoothing(unsigned int aAttributeId, unsigned int aMode, double aTime)
+	{
+		if (aAttributeId >= mNumParams || aMode > Filter::LINEAR_SMOOTHING)
+			return;
+
+		if (aTime <= 0)
+			aMode = Filter::NO_SMOOTHING;
+
+		FilterParamSmoother &s = mParamSmoother[aAttributeId];
+		if (aMode == Filter::NO_SMOOTHING && (mSmoothingActive & (1 << aAttributeId)))
+		{
+			// Jump to where we were going
+			mParam[aAttributeId] = s.mTarget;
+			mParamChanged |= 1 << aAttributeId;
+		}
+		mSmoothingActive &= ~(1 << aAttributeId);
+		s.mMode = aMode;
+		s.mTime = (float)aTime;
+		s.mTarget = mParam[aAttributeId];
+		s.mStep = 0;
+	}
+
+	void FilterInstance::scheduleFilterParameter(unsigned int aAttributeId, float aValue, unsigned int aDelay)
+	{
+		if (aAttributeId >= mNumParams)
+			return;
+
+		if (aDelay == 0 || mEventCount == FILTER_EVENT_COUNT)
+		{
+			// Nothing to wait for, or no room to wait; apply right away
+			setFilterParameter(aAttributeId, aValue);
+			return;
+		}
+
+		mEvent[mEventCount].mAttributeId = aAttributeId;
+		mEvent[mEventCount].mValue = aValue;
+		mEvent[mEventCount].mDelay = aDelay;
+		mEventCount++;
+	}
+
+	void FilterInstance::advanceSmoothing(unsigned int aSamples, float aSamplerate)
+	{
+		unsigned int i;
+		for (i = 0; i < mNumParams; i++)
+		{
+			if (!(mSmoothingActive & (1 << i)))
+				continue;
+
+			FilterParamSmoother &s = mParamSmoother[i];
+			float v = mParam[i];
+			if (s.mMode == Filter::ONEPOLE_SMOOTHING)
+			{
+				v = s.mTarget + (v - s.mTarget) * (float)exp(-(float)aSamples / (s.mTime * aSamplerate));
+			}
+			else
+			{
+				if (s.mStep == 0)
+					s.mStep = (s.mTarget - v) / (s.mTime * aSamplerate);
+				v += s.mStep * aSamples;
+				if ((s.mStep > 0 && v > s.mTarget) || (s.mStep < 0 && v < s.mTarget))
+					v = s.mTarget;
+			}
+
+			if (fabs(v - s.mTarget) <= 0.00001f * (1.0f + (float)fabs(s.mTarget)))
+			{
+				v = s.mTarget;
+				s.mStep = 0;
+				mSmoothingActive &= ~(1 << i);
+			}
+			mParam[i] = v;
+			mParamChanged |= 1 << i;
+		}
+	}
+
+	void FilterInstance::filterBlock(float *aBuffer, unsigned int aSamples, unsigned int aBufferSize, unsigned int aChannels, float aSamplerate, double aTime)
+	{
+		if (mEventCount == 0 && mSmoothingActive == 0)
+		{
+			filter(aBuffer, aSamples, aBufferSize, aChannels, aSamplerate, aTime);
+			return;
+		}
+
+		unsigned int i;
+		unsigned int ofs = 0;
+		while (ofs < aSamples)
+		{
+			unsigned int end = aSamples;
+
+			// Apply changes that are due in the order they were scheduled, and find the next one
+			unsigned int kept = 0;
+			for (i = 0; i < mEventCount; i++)
+			{
+				if (mEvent[i].mDelay <= ofs)
+				{
+					setFilterParameter(mEvent[i].mAttributeId, mEvent[i].mValue);
+				}
+				else
+				{
+					if (mEvent[i].mDelay < end)
+						end = mEvent[i].mDelay;
+					mEvent[kept] = mEvent[i];
+					kept++;
+				}
+			}
+			mEventCount = kept;
+
+			if (mSmoothingActive && ofs + FILTER_SMOOTHING_STEP < end)
+				end = ofs + FILTER_SMOOTHING_STEP;
+
+			filter(aBuffer + ofs, end - ofs, aBufferSize, aChannels, aSamplerate, aTime + ofs / aSamplerate);
+			if (mSmoothingActive)
+				advanceSmoothing(end - ofs, aSamplerate);
+			ofs = end;
+		}
+
+		for (i = 0; i < mEventCount; i++)
+			mEvent[i].mDelay -= aSamples;
+	}
+
+	bool FilterInstance::hasTail()
+	{
+		return true;
+	}
+
+	void FilterInstance::onSilence()
+	{
+	}
+
+	bool FilterInstance::canBypassWhenDry()
+	{
+		return false;
+	}
+
+	bool FilterInstance::isBypassed()
+	{
+		if (mNumParams == 0 || mParam[0] != 0 || mEventCount || mSmoothingActive || !canBypassWhenDry())
+			return false;
+		return mParamFader[0].mActive <= 0;
+	}
+
 	void FilterInstance::fadeFilterParameter(unsigned int aAttributeId, float aTo, double aTime, double aStartTime)
 	{
 		if (aAttributeId >= mNumParams || aTime <= 0 || aTo == mParam[aAttributeId])
@@ -25,6 +25,10 @@ freely, subject to the following restrictions:
 #include "soloud_misc.h"
 #include <math.h>
 
+#ifdef SOLOUD_SSE_INTRINSICS
+#include <xmmintrin.h>
+#endif
+
 namespace SoLoud
 {
 	namespace Misc
@@ -72,6 +76,61 @@ namespace SoLoud
 			}
 		}
 
+		void linkedPeak(float *aDst, const float *aBuffer, unsigned int aSamples, unsigned int aBufferSize, unsigned int aChannels)
+		{
+			unsigned int i, j;
+			i = 0;
+#ifdef SOLOUD_SSE_INTRINSICS
+			const __m128 signmask = _mm_set1_ps(-0.0f);
+			for (; i + 4 <= aSamples; i += 4)
+			{
+				__m128 peak = _mm_andnot_ps(signmask, _mm_loadu_ps(aBuffer + i));
+				for (j = 1; j < aChannels; j++)
+				{
+					__m128 v = _mm_andnot_ps(signmask, _mm_loadu_ps(aBuffer + i + j * aBufferSize));
+					peak = _mm_max_ps(peak, v);
+				}
+				_mm_storeu_ps(aDst + i, peak);
+			}
+#endif
+			for (; i < aSamples; i++)
+			{
+				float peak = (float)fabs(aBuffer[i]);
+				for (j = 1; j < aChannels; j++)
+				{
+					float v = (float)fabs(aBuffer[i + j * aBufferSize]);
+					if (v > peak)
+						peak = v;
+				}
+				aDst[i] = peak;
+			}
+		}
+
+		bool isSilent(const float *aBuffer, unsigned int aSamples, unsigned int aBufferSize, unsigned int aChannels)
+		{
+			unsigned int i, j;
+			for (j = 0; j < aChannels; j++)
+			{
+				const float *src = aBuffer + j * aBufferSize;
+				i = 0;
+#ifdef SOLOUD_SSE_INTRINSICS
+				const __m128 zero = _mm_setzero_ps();
+				for (; i + 4 <= aSamples; i += 4)
+				{
+					// -0.0 compares equal to 0.0, which is what we want
+					if (_mm_movemask_ps(_mm_cmpneq_ps(_mm_loadu_ps(src + i), zero)))
+						return false;
+				}
+#endif
+				for (; i < aSamples; i++)
+				{
+					if (src[i] != 0)
+						return false;
+				}
+			}
+			return true;
+		}
+
 		Prg::Prg()
 		{
 			srand(0);
@@ -0,0 +1,393 @@
+/*
+SoLoud audio engine
+Copyright (c) 2013-2021 Jari Komppa
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+
+#undef _CRT_SECURE_NO_WARNINGS
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <string.h>
+#include "soloud.h"
+#include "soloud_offline.h"
+#include "soloud_thread.h"
+
+namespace SoLoud
+{
+	result Soloud::renderOffline(time aDuration, OfflineSink &aSink)
+	{
+		// Other back-ends pull the audio on their own
+		if (mBackendID != NULLDRIVER)
+			return NOT_IMPLEMENTED;
+		if (aDuration <= 0)
+			return INVALID_PARAMETER;
+
+		unsigned int left = (unsigned int)(aDuration * mSamplerate + 0.5);
+		result res = aSink.begin(mChannels, mSamplerate);
+		while (res == SO_NO_ERROR && left > 0)
+		{
+			unsigned int samples = left < mBufferSize ? left : mBufferSize;
+			unsigned int stride = (samples + 15) & ~0xf;
+			mix_internal(samples, stride);
+			res = aSink.write(mScratch.mData, samples, stride, mChannels);
+			left -= samples;
+		}
+		result endres = aSink.end();
+		return res != SO_NO_ERROR ? res : endres;
+	}
+
+	result Soloud::stepVirtualClock(time aSeconds)
+	{
+		if (!(mFlags & VIRTUAL_CLOCK))
+			return NOT_IMPLEMENTED;
+		if (aSeconds < 0)
+			return INVALID_PARAMETER;
+
+		// Always mix whole buffers so the result matches the real-time
+		// backend block for block; leftover time carries to the next step.
+		mVirtualClockPending += aSeconds * mSamplerate;
+		unsigned int stride = (mBufferSize + 15) & ~0xf;
+		while (mVirtualClockPending >= mBufferSize)
+		{
+			mix_internal(mBufferSize, stride);
+			mVirtualClockPending -= mBufferSize;
+		}
+		return SO_NO_ERROR;
+	}
+
+	result OfflineSink::begin(unsigned int /*aChannels*/, unsigned int /*aSamplerate*/)
+	{
+		return SO_NO_ERROR;
+	}
+
+	result OfflineSink::end()
+	{
+		return SO_NO_ERROR;
+	}
+
+	OfflineSink::~OfflineSink()
+	{
+	}
+
+	static void writeLE16(unsigned char *aDst, unsigned int aValue)
+	{
+		aDst[0] = (unsigned char)(aValue & 0xff);
+		aDst[1] = (unsigned char)((aValue >> 8) & 0xff);
+	}
+
+	static void writeLE32(unsigned char *aDst, unsigned int aValue)
+	{
+		writeLE16(aDst, aValue & 0xffff);
+		writeLE16(aDst + 2, aValue >> 16);
+	}
+
+	FileSink::FileSink()
+	{
+		mFile = 0;
+		mFormat = WAV_FLOAT32;
+		mChannels = 0;
+		mSamplerate = 0;
+		mDataBytes = 0;
+		mBuffer = 0;
+		mBufferBytes = 0;
+	}
+
+	result FileSink::open(const char *aFilename, unsigned int aFormat)
+	{
+		if (aFilename == 0 || aFormat > RAW_FLOAT32)
+			return INVALID_PARAMETER;
+		close();
+		mFile = fopen(aFilename, "wb");
+		if (mFile == 0)
+			return FILE_NOT_FOUND;
+		mFormat = aFormat;
+		mDataBytes = 0;
+		return SO_NO_ERROR;
+	}
+
+	void FileSink::close()
+	{
+		if (mFile == 0)
+			return;
+
+		if (mFormat != RAW_FLOAT32)
+		{
+			// Now that we know the size, go back and write the header
+			unsigned char hdr[44];
+			unsigned int bytespersample = mFormat == WAV_SIGNED16 ? 2 : 4;
+			memcpy(hdr, "RIFF", 4);
+			writeLE32(hdr + 4, 36 + mDataBytes);
+			memcpy(hdr + 8, "WAVEfmt ", 8);
+			writeLE32(hdr + 16, 16);
+			writeLE16(hdr + 20, mFormat == WAV_SIGNED16 ? 1 : 3); // PCM or IEEE float
+			writeLE16(hdr + 22, mChannels);
+			writeLE32(hdr + 24, mSamplerate);
+			writeLE32(hdr + 28, mSamplerate * mChannels * bytespersample);
+			writeLE16(hdr + 32, mChannels * bytespersample);
+			writeLE16(hdr + 34, bytespersample * 8);
+			memcpy(hdr + 36, "data", 4);
+			writeLE32(hdr + 40, mDataBytes);
+			fseek(mFile, 0, SEEK_SET);
+			fwrite(hdr, 1, 44, mFile);
+		}
+		fclose(mFile);
+		mFile = 0;
+	}
+
+	result FileSink::begin(unsigned int aChannels, unsigned int aSamplerate)
+	{
+		if (mFile == 0)
+			return INVALID_PARAMETER;
+		mChannels = aChannels;
+		mSamplerate = aSamplerate;
+		mDataBytes = 0;
+		if (mFormat != RAW_FLOAT32)
+		{
+			// Placeholder, filled in by close()
+			unsigned char hdr[44];
+			memset(hdr, 0, 44);
+			if (fwrite(hdr, 1, 44, mFile) != 44)
+				return UNKNOWN_ERROR;
+		}
+		return SO_NO_ERROR;
+	}
+
+	result FileSink::write(const float *aBuffer, unsigned int aSamples, unsigned int aStride, unsigned int aChannels)
+	{
+		if (mFile == 0)
+			return INVALID_PARAMETER;
+
+		unsigned int bytes = aSamples * aChannels * (mFormat == WAV_SIGNED16 ? 2 : 4);
+		if (bytes > mBufferBytes)
+		{
+			delete[] mBuffer;
+			mBuffer = new unsigned char[bytes];
+			if (mBuffer == 0)
+			{
+				mBufferBytes = 0;
+				return OUT_OF_MEMORY;
+			}
+			mBufferBytes = bytes;
+		}
+
+		// Interleave straight into the file buffer
+		unsigned int i, j;
+		if (mFormat == WAV_SIGNED16)
+		{
+			unsigned char *d = mBuffer;
+			for (i = 0; i < aSamples; i++)
+			{
+				for (j = 0; j < aChannels; j++)
+				{
+					float s = aBuffer[i + j * aStride];
+					if (s > 1) s = 1;
+					if (s < -1) s = -1;
+					writeLE16(d, (unsigned short)(short)(s * 0x7fff));
+					d += 2;
+				}
+			}
+		}
+		else
+		{
+			float *d = (float*)mBuffer;
+			for (i = 0; i < aSamples; i++)
+			{
+				for (j = 0; j < aChannels; j++)
+				{
+					*d++ = aBuffer[i + j * aStride];
+				}
+			}
+		}
+
+		if (fwrite(mBuffer, 1, bytes, mFile) != bytes)
+			return UNKNOWN_ERROR;
+		mDataBytes += bytes;
+		return SO_NO_ERROR;
+	}
+
+	result FileSink::end()
+	{
+		close();
+		return SO_NO_ERROR;
+	}
+
+	FileSink::~FileSink()
+	{
+		close();
+		delete[] mBuffer;
+	}
+
+	MemorySink::MemorySink()
+	{
+		mData = 0;
+		mSamples = 0;
+		mCapacity = 0;
+		mChannels = 0;
+		mSamplerate = 0;
+	}
+
+	void MemorySink::clear()
+	{
+		delete[] mData;
+		mData = 0;
+		mSamples = 0;
+		mCapacity = 0;
+	}
+
+	result MemorySink::begin(unsigned int aChannels, unsigned int aSamplerate)
+	{
+		clear();
+		mChannels = aChannels;
+		mSamplerate = aSamplerate;
+		return SO_NO_ERROR;
+	}
+
+	result MemorySink::write(const float *aBuffer, unsigned int aSamples, unsigned int aStride, unsigned int aChannels)
+	{
+		if (mSamples + aSamples > mCapacity)
+		{
+			unsigned int capacity = mCapacity ? mCapacity * 2 : 44100;
+			while (capacity < mSamples + aSamples)
+				capacity *= 2;
+			float *data = new float[capacity * aChannels];
+			if (data == 0)
+				return OUT_OF_MEMORY;
+			if (mData)
+				memcpy(data, mData, sizeof(float) * mSamples * aChannels);
+			delete[] mData;
+			mData = data;
+			mCapacity = capacity;
+		}
+
+		float *d = mData + mSamples * aChannels;
+		unsigned int i, j;
+		for (i = 0; i < aSamples; i++)
+		{
+			for (j = 0; j < aChannels; j++)
+			{
+				*d++ = aBuffer[i + j * aStride];
+			}
+		}
+		mSamples += aSamples;
+		return SO_NO_ERROR;
+	}
+
+	MemorySink::~MemorySink()
+	{
+		clear();
+	}
+
+	struct OfflineJobData
+	{
+		offlineRenderFunction mJob;
+		void *mUserData;
+		unsigned int mJobCount;
+		unsigned int mNextJob;
+		unsigned int mSamplerate;
+		unsigned int mBufferSize;
+		unsigned int mChannels;
+		result mResult;
+		void *mMutex;
+	};
+
+	static void offlineWorker(void *aParam)
+	{
+		OfflineJobData *data = (OfflineJobData *)aParam;
+		result res = SO_NO_ERROR;
+		for (;;)
+		{
+			if (data->mMutex) Thread::lockMutex(data->mMutex);
+			if (res != SO_NO_ERROR && data->mResult == SO_NO_ERROR)
+				data->mResult = res;
+			unsigned int job = data->mJobCount;
+			if (data->mResult == SO_NO_ERROR && data->mNextJob < data->mJobCount)
+			{
+				job = data->mNextJob;
+				data->mNextJob++;
+			}
+			if (data->mMutex) Thread::unlockMutex(data->mMutex);
+
+			if (job >= data->mJobCount)
+				break;
+
+			// Each job gets a fresh instance so that jobs can't affect each other
+			Soloud soloud;
+			res = soloud.init(Soloud::CLIP_ROUNDOFF, Soloud::NULLDRIVER, data->mSamplerate, data->mBufferSize, data->mChannels);
+			if (res == SO_NO_ERROR)
+				res = data->mJob(soloud, job, data->mUserData);
+			soloud.deinit();
+		}
+	}
+
+	result renderOfflineParallel(unsigned int aJobCount, offlineRenderFunction aJob, void *aUserData, unsigned int aThreads, unsigned int aSamplerate, unsigned int aBufferSize, unsigned int aChannels)
+	{
+		if (aJob == 0)
+			return INVALID_PARAMETER;
+
+		OfflineJobData data;
+		data.mJob = aJob;
+		data.mUserData = aUserData;
+		data.mJobCount = aJobCount;
+		data.mNextJob = 0;
+		data.mSamplerate = aSamplerate;
+		data.mBufferSize = aBufferSize;
+		data.mChannels = aChannels;
+		data.mResult = SO_NO_ERROR;
+		data.mMutex = 0;
+
+		if (aThreads > aJobCount)
+			aThreads = aJobCount;
+
+		if (aThreads == 0)
+		{
+			offlineWorker(&data);
+			return data.mResult;
+		}
+
+		data.mMutex = Thread::createMutex();
+		Thread::ThreadHandle *thread = new Thread::ThreadHandle[aThreads];
+		unsigned int i, started = 0;
+		for (i = 0; i < aThreads; i++)
+		{
+			thread[i] = Thread::createThread(offlineWorker, &data);
+			if (thread[i])
+				started++;
+		}
+		if (started == 0)
+		{
+			// No threads to be had; do the work here
+			offlineWorker(&data);
+		}
+		for (i = 0; i < aThreads; i++)
+		{
+			if (thread[i])
+			{
+				Thread::wait(thread[i]);
+				Thread::release(thread[i]);
+			}
+		}
+		delete[] thread;
+		Thread::destroyMutex(data.mMutex);
+		return data.mResult;
+	}
+};
@@ -0,0 +1,195 @@
+/*
+SoLoud audio engine
+Copyright (c) 2013-2021 Jari Komppa
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+
+#undef _CRT_SECURE_NO_WARNINGS
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <string.h>
+#include "soloud.h"
+#include "soloud_internal.h"
+
+// Per-source cost accounting and Chrome trace export
+
+namespace SoLoud
+{
+	void Soloud::addSourceCost_internal(unsigned int aAudioSourceID, long long aNanos, long long aStart, long long aEnd)
+	{
+		if (aAudioSourceID)
+		{
+			unsigned int i;
+			unsigned int slot = aAudioSourceID % SOURCE_COST_SLOTS;
+			for (i = 0; i < SOURCE_COST_SLOTS; i++)
+			{
+				SourceCost &c = mSourceCost[slot];
+				if (c.mAudioSourceID == aAudioSourceID || c.mAudioSourceID == 0)
+				{
+					c.mAudioSourceID = aAudioSourceID;
+					c.mNanos += aNanos;
+					c.mMixes++;
+					break;
+				}
+				slot = (slot + 1) % SOURCE_COST_SLOTS;
+			}
+			// If the table is full, the cost is dropped
+		}
+
+		if (mCostTrace && mCostTraceCount < mCostTraceMax)
+		{
+			CostTraceEvent &e = mCostTrace[mCostTraceCount];
+			e.mAudioSourceID = aAudioSourceID;
+			e.mStart = aStart;
+			e.mEnd = aEnd;
+			mCostTraceCount++;
+		}
+	}
+
+	unsigned int Soloud::getSourceCosts(SourceCost *aCosts, unsigned int aMaxCount)
+	{
+		if (aCosts == 0 || aMaxCount == 0)
+			return 0;
+		unsigned int count = 0;
+		unsigned int i, j;
+		lockAudioMutex_internal();
+		for (i = 0; i < SOURCE_COST_SLOTS; i++)
+		{
+			const SourceCost &c = mSourceCost[i];
+			if (c.mAudioSourceID == 0)
+				continue;
+			// Insertion into the sorted top list
+			if (count == aMaxCount && aCosts[count - 1].mNanos >= c.mNanos)
+				continue;
+			j = count < aMaxCount ? count++ : count - 1;
+			while (j > 0 && aCosts[j - 1].mNanos < c.mNanos)
+			{
+				aCosts[j] = aCosts[j - 1];
+				j--;
+			}
+			aCosts[j] = c;
+		}
+		unlockAudioMutex_internal();
+		return count;
+	}
+
+	time Soloud::getSourceCost(AudioSource &aSound)
+	{
+		time t = 0;
+		if (aSound.mAudioSourceID == 0)
+			return 0;
+		lockAudioMutex_internal();
+		unsigned int i;
+		unsigned int slot = aSound.mAudioSourceID % SOURCE_COST_SLOTS;
+		for (i = 0; i < SOURCE_COST_SLOTS; i++)
+		{
+			const SourceCost &c = mSourceCost[slot];
+			if (c.mAudioSourceID == 0)
+				break;
+			if (c.mAudioSourceID == aSound.mAudioSourceID)
+			{
+				t = c.mNanos / 1000000000.0;
+				break;
+			}
+			slot = (slot + 1) % SOURCE_COST_SLOTS;
+		}
+		unlockAudioMutex_internal();
+		return t;
+	}
+
+	void Soloud::resetSourceCosts()
+	{
+		lockAudioMutex_internal();
+		memset(mSourceCost, 0, sizeof(mSourceCost));
+		unlockAudioMutex_internal();
+	}
+
+	result Soloud::startCostTrace(unsigned int aMaxEvents)
+	{
+		if (aMaxEvents == 0)
+			return INVALID_PARAMETER;
+		CostTraceEvent *trace = new CostTraceEvent[aMaxEvents];
+		if (trace == 0)
+			return OUT_OF_MEMORY;
+		lockAudioMutex_internal();
+		CostTraceEvent *old = mCostTrace;
+		mCostTrace = trace;
+		mCostTraceCount = 0;
+		mCostTraceMax = aMaxEvents;
+		unlockAudioMutex_internal();
+		delete[] old;
+		return SO_NO_ERROR;
+	}
+
+	result Soloud::saveCostTrace(const char *aFilename)
+	{
+		if (aFilename == 0)
+			return INVALID_PARAMETER;
+		lockAudioMutex_internal();
+		CostTraceEvent *trace = mCostTrace;
+		unsigned int count = mCostTraceCount;
+		mCostTrace = 0;
+		mCostTraceCount = 0;
+		mCostTraceMax = 0;
+		unlockAudioMutex_internal();
+		if (trace == 0)
+			return INVALID_PARAMETER;
+
+		FILE *f = fopen(aFilename, "w");
+		if (f == 0)
+		{
+			delete[] trace;
+			return FILE_NOT_FOUND;
+		}
+
+		// Complete ("X") events in microseconds. Voices are recorded as they
+		// finish, so a bus comes after the voices playing on it; the viewer
+		// nests them by time.
+		long long base = count ? trace[0].mStart : 0;
+		unsigned int i;
+		for (i = 1; i < count; i++)
+			if (trace[i].mStart < base)
+				base = trace[i].mStart;
+		fprintf(f, "{\"traceEvents\":[\n");
+		for (i = 0; i < count; i++)
+		{
+			const CostTraceEvent &e = trace[i];
+			char name[32];
+			if (e.mAudioSourceID)
+				sprintf(name, "source %u", e.mAudioSourceID);
+			else
+				sprintf(name, "mix");
+			fprintf(f, "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":1}%s\n",
+				name,
+				e.mAudioSourceID ? "voice" : "mixer",
+				(e.mStart - base) / 1000.0,
+				(e.mEnd - e.mStart) / 1000.0,
+				i + 1 < count ? "," : "");
+		}
+		fprintf(f, "],\"displayTimeUnit\":\"ms\"}\n");
+		int err = ferror(f);
+		fclose(f);
+		delete[] trace;
+		return err ? UNKNOWN_ERROR : SO_NO_ERROR;
+	}
+}
@@ -22,7 +22,9 @@ freely, subject to the following restrictions:
    distribution.
 */
 
+#include <string.h>
 #include "soloud.h"
+#include "soloud_thread.h"
 
 namespace SoLoud
 {
@@ -30,28 +32,62 @@ namespace SoLoud
 	{
 		mParent = aParent;
 		mFlags |= PROTECTED;
+		mLastWasSound = false;
 	}
 	
 	unsigned int QueueInstance::getAudio(float *aBuffer, unsigned int aSamplesToRead, unsigned int aBufferSize)
 	{
-		if (mParent->mCount == 0)
-		{
-			return 0;			
-		}
-		unsigned int copycount = aSamplesToRead;
+		Queue *q = mParent;
 		unsigned int copyofs = 0;
-		while (copycount && mParent->mCount)
+		while (copyofs < aSamplesToRead && q->mReadIndex != q->mWriteIndex)
 		{
-			int readcount = mParent->mSource[mParent->mReadIndex]->getAudio(aBuffer + copyofs, copycount, aBufferSize);
-			copyofs += readcount;
-			copycount -= readcount;
-			if (mParent->mSource[mParent->mReadIndex]->hasEnded())
+			// Make sure we see the entry the producer published before moving mWriteIndex
+			Thread::memoryBarrier();
+			unsigned int slot = q->mReadIndex & (q->mQueueSize - 1);
+			AudioSourceInstance *source = q->mSource[slot];
+			bool done;
+			if (source)
+			{
+				unsigned int readcount = source->getAudio(aBuffer + copyofs, aSamplesToRead - copyofs, aBufferSize);
+				copyofs += readcount;
+				done = source->hasEnded();
+				if (done)
+				{
+					mLoopCount++;
+					mLastWasSound = true;
+				}
+				else
+				if (readcount == 0)
+					break;
+			}
+			else
 			{
-				delete mParent->mSource[mParent->mReadIndex];
-				mParent->mSource[mParent->mReadIndex] = 0;
-				mParent->mReadIndex = (mParent->mReadIndex + 1) % SOLOUD_QUEUE_MAX;
-				mParent->mCount--;
-				mLoopCount++;
+				unsigned int frames = q->mSourceFrames[slot] - q->mPcmOffset;
+				if (frames > aSamplesToRead - copyofs)
+					frames = aSamplesToRead - copyofs;
+				unsigned int mask = q->mPcmFrames - 1;
+				unsigned int pos = q->mPcmRead;
+				unsigned int i, j;
+				for (i = 0; i < frames; i++, pos++)
+				{
+					const float *src = q->mPcm + (pos & mask) * mChannels;
+					for (j = 0; j < mChannels; j++)
+						aBuffer[copyofs + i + j * aBufferSize] = src[j];
+				}
+				copyofs += frames;
+				q->mPcmOffset += frames;
+				done = q->mPcmOffset == q->mSourceFrames[slot];
+				if (done)
+					mLastWasSound = false;
+				Thread::memoryBarrier();
+				q->mPcmRead = pos;
+			}
+			if (done)
+			{
+				// Leave the instance for the producer to delete
+				q->mPcmOffset = 0;
+				Thread::memoryBarrier();
+				q->mReadIndex++;
 			}
 		}
 		return copyofs;
@@ -59,7 +95,8 @@ namespace SoLoud
 
 	bool QueueInstance::hasEnded()
 	{
-		return mLoopCount != 0 && mParent->mCount == 0;
+		// A queue of sounds ends when it runs out; a sample feed keeps going over gaps
+		return mLastWasSound && mParent->mReadIndex == mParent->mWriteIndex;
 	}
 
 	QueueInstance::~QueueInstance()
@@ -72,10 +109,35 @@ namespace SoLoud
 		mInstance = 0;
 		mReadIndex = 0;
 		mWriteIndex = 0;
-		mCount = 0;
-		int i;
-		for (i = 0; i < SOLOUD_QUEUE_MAX; i++)
+		mFreeIndex = 0;
+		mQueueSize = SOLOUD_QUEUE_MAX;
+		mSource = new AudioSourceInstance*[mQueueSize];
+		mSourceFrames = new unsigned int[mQueueSize];
+		unsigned int i;
+		for (i = 0; i < mQueueSize; i++)
+		{
 			mSource[i] = 0;
+			mSourceFrames[i] = 0;
+		}
+		mPcm = 0;
+		mPcmFrames = 0;
+		mPcmWrite = 0;
+		mPcmRead = 0;
+		mPcmOffset = 0;
+	}
+
+	Queue::~Queue()
+	{
+		// Stop the audio thread from reading the queue before tearing it down
+		stop();
+		while (mFreeIndex != mWriteIndex)
+		{
+			delete mSource[mFreeIndex & (mQueueSize - 1)];
+			mFreeIndex++;
+		}
+		delete[] mSource;
+		delete[] mSourceFrames;
+		delete[] mPcm;
 	}
 	
 	QueueInstance * Queue::createInstance()
@@ -102,6 +164,19 @@ namespace SoLoud
 		}
 	}
 
+	void Queue::freePlayed_internal()
+	{
+		unsigned int readindex = mReadIndex;
+		Thread::memoryBarrier();
+		while (mFreeIndex != readindex)
+		{
+			unsigned int slot = mFreeIndex & (mQueueSize - 1);
+			delete mSource[slot];
+			mSource[slot] = 0;
+			mFreeIndex++;
+		}
+	}
+
 	result Queue::play(AudioSource &aSound)
 	{
 		if (!mSoloud)
@@ -114,7 +189,8 @@ namespace SoLoud
 		if (mQueueHandle == 0)
 			return INVALID_PARAMETER;
 
-		if (mCount >= SOLOUD_QUEUE_MAX)
+		freePlayed_internal();
+		if (mWriteIndex - mFreeIndex >= mQueueSize)
 			return OUT_OF_MEMORY;
 
 		if (!aSound.mAudioSourceID)
@@ -132,15 +208,65 @@ namespace SoLoud
 		instance->init(aSound, 0);
 		instance->mAudioSourceID = aSound.mAudioSourceID;
 
-		mSoloud->lockAudioMutex_internal();
-		mSource[mWriteIndex] = instance;
-		mWriteIndex = (mWriteIndex + 1) % SOLOUD_QUEUE_MAX;
-		mCount++;
-		mSoloud->unlockAudioMutex_internal();
+		mSource[mWriteIndex & (mQueueSize - 1)] = instance;
+		// Publish the entry before the index
+		Thread::memoryBarrier();
+		mWriteIndex++;
 
 		return SO_NO_ERROR;
 	}
 
+	result Queue::pushSamples(const float *aSamples, unsigned int aSampleCount)
+	{
+		if (!mSoloud || aSamples == 0)
+		{
+			return INVALID_PARAMETER;
+		}
+
+		findQueueHandle();
+
+		if (mQueueHandle == 0)
+			return INVALID_PARAMETER;
+
+		if (aSampleCount == 0)
+			return SO_NO_ERROR;
+
+		freePlayed_internal();
+		if (mWriteIndex - mFreeIndex >= mQueueSize)
+			return OUT_OF_MEMORY;
+
+		if (mPcm == 0)
+		{
+			// Default to a second of audio; nothing reads the ring before the first block is published
+			unsigned int frames = (unsigned int)mBaseSamplerate;
+			if (frames < aSampleCount)
+				frames = aSampleCount;
+			mPcmFrames = 1;
+			while (mPcmFrames < frames)
+				mPcmFrames *= 2;
+			mPcm = new float[mPcmFrames * mChannels];
+		}
+
+		unsigned int pcmread = mPcmRead;
+		if (aSampleCount > mPcmFrames - (mPcmWrite - pcmread))
+			return OUT_OF_MEMORY;
+
+		unsigned int mask = mPcmFrames - 1;
+		unsigned int pos = mPcmWrite;
+		unsigned int i;
+		for (i = 0; i < aSampleCount; i++, pos++)
+			memcpy(mPcm + (pos & mask) * mChannels, aSamples + i * mChannels, sizeof(float) * mChannels);
+
+		unsigned int slot = mWriteIndex & (mQueueSize - 1);
+		mSource[slot] = 0;
+		mSourceFrames[slot] = aSampleCount;
+		// Publish the samples and the entry before the indices
+		Thread::memoryBarrier();
+		mPcmWrite = pos;
+		mWriteIndex++;
+
+		return SO_NO_ERROR;
+	}
 
 	unsigned int Queue::getQueueCount()
 	{
@@ -148,37 +274,94 @@ namespace SoLoud
 		{
 			return 0;
 		}
-		unsigned int count;
-		mSoloud->lockAudioMutex_internal();
-		count = mCount;
-		mSoloud->unlockAudioMutex_internal();
-		return count;
+		freePlayed_internal();
+		return mWriteIndex - mReadIndex;
 	}
 
 	bool Queue::isCurrentlyPlaying(AudioSource &aSound)
 	{
-		if (mSoloud == 0 || mCount == 0 || aSound.mAudioSourceID == 0)
+		if (mSoloud == 0 || aSound.mAudioSourceID == 0)
+			return false;
+		unsigned int readindex = mReadIndex;
+		if (readindex == mWriteIndex)
 			return false;
-		mSoloud->lockAudioMutex_internal();
-		bool res = mSource[mReadIndex]->mAudioSourceID == aSound.mAudioSourceID;
-		mSoloud->unlockAudioMutex_internal();
-		return res;
+		// Only the producer deletes played instances, so the entry stays valid even if it ends right now
+		Thread::memoryBarrier();
+		AudioSourceInstance *source = mSource[readindex & (mQueueSize - 1)];
+		return source && source->mAudioSourceID == aSound.mAudioSourceID;
 	}
 
 	result Queue::setParamsFromAudioSource(AudioSource &aSound)
 	{
-		mChannels = aSound.mChannels;
-		mBaseSamplerate = aSound.mBaseSamplerate;
-
-	    return SO_NO_ERROR;
+		return setParams(aSound.mBaseSamplerate, aSound.mChannels);
 	}
 	
 	result Queue::setParams(float aSamplerate, unsigned int aChannels)
 	{
 	    if (aChannels < 1 || aChannels > MAX_CHANNELS)
 	        return INVALID_PARAMETER;
+		if (aChannels != mChannels)
+		{
+			// A playing queue reads with the old channel count
+			if (mSoloud && mSoloud->countAudioSource(*this))
+				return INVALID_PARAMETER;
+			if (mPcm)
+			{
+				// The sample ring is laid out for the old channel count too; only resize it while empty
+				freePlayed_internal();
+				if (mFreeIndex != mWriteIndex)
+					return INVALID_PARAMETER;
+				delete[] mPcm;
+				mPcm = new float[mPcmFrames * aChannels];
+				mPcmWrite = 0;
+				mPcmRead = 0;
+				mPcmOffset = 0;
+			}
+		}
 		mChannels = aChannels;
 		mBaseSamplerate = aSamplerate;
 	    return SO_NO_ERROR;
 	}
+
+	result Queue::setQueueSize(unsigned int aMaxEntries, unsigned int aMaxSampleFrames)
+	{
+		if (aMaxEntries == 0 || aMaxEntries > 0x10000 || aMaxSampleFrames > 0x10000000)
+			return INVALID_PARAMETER;
+
+		// The audio thread doesn't touch the buffers while the queue is empty
+		freePlayed_internal();
+		if (mFreeIndex != mWriteIndex)
+			return INVALID_PARAMETER;
+
+		unsigned int size = 1;
+		while (size < aMaxEntries)
+			size *= 2;
+		if (size != mQueueSize)
+		{
+			delete[] mSource;
+			delete[] mSourceFrames;
+			mQueueSize = size;
+			mSource = new AudioSourceInstance*[mQueueSize];
+			mSourceFrames = new unsigned int[mQueueSize];
+			unsigned int i;
+			for (i = 0; i < mQueueSize; i++)
+			{
+				mSource[i] = 0;
+				mSourceFrames[i] = 0;
+			}
+		}
+
+		delete[] mPcm;
+		mPcm = 0;
+		mPcmFrames = 0;
+		if (aMaxSampleFrames)
+		{
+			mPcmFrames = 1;
+			while (mPcmFrames < aMaxSampleFrames)
+				mPcmFrames *= 2;
+			mPcm = new float[mPcmFrames * mChannels];
+		}
+		Thread::memoryBarrier();
+		return SO_NO_ERROR;
+	}
 };
@@ -22,14 +22,21 @@ freely, subject to the following restrictions:
    distribution.
 */
 
+#undef _CRT_SECURE_NO_WARNINGS
+#define _CRT_SECURE_NO_WARNINGS
+
 #if defined(_WIN32)||defined(_WIN64)
 #include <windows.h>
 #else
 #include <inttypes.h>
 #include <pthread.h>
+#include <sched.h>
 #include <unistd.h>
 #include <time.h>
+#include <errno.h>
+#include <limits.h>
 #endif
+#include <string.h>
 
 #include "soloud.h"
 #include "soloud_thread.h"
@@ -76,30 +83,88 @@ namespace SoLoud
 			}
 		}
 
+		void * createCondition()
+		{
+			CONDITION_VARIABLE *cv = new CONDITION_VARIABLE;
+			InitializeConditionVariable(cv);
+			return (void*)cv;
+		}
+
+		void destroyCondition(void *aHandle)
+		{
+			// Windows condition variables need no cleanup
+			delete (CONDITION_VARIABLE*)aHandle;
+		}
+
+		void waitCondition(void *aHandle, void *aMutex)
+		{
+			SleepConditionVariableCS((CONDITION_VARIABLE*)aHandle, (CRITICAL_SECTION*)aMutex, INFINITE);
+		}
+
+		void signalCondition(void *aHandle)
+		{
+			WakeConditionVariable((CONDITION_VARIABLE*)aHandle);
+		}
+
+		void broadcastCondition(void *aHandle)
+		{
+			WakeAllConditionVariable((CONDITION_VARIABLE*)aHandle);
+		}
+
 		struct soloud_thread_data
 		{
 			threadFunction mFunc;
 			void *mParam;
+			char mName[64];
 		};
 
+		typedef HRESULT (WINAPI *SetThreadDescriptionFunc)(HANDLE, PCWSTR);
+
 		static DWORD WINAPI threadfunc(LPVOID d)
 		{
 			soloud_thread_data *p = (soloud_thread_data *)d;
+			if (p->mName[0])
+			{
+				// SetThreadDescription only exists on Windows 10 1607 and later
+				SetThreadDescriptionFunc setDescription = (SetThreadDescriptionFunc)GetProcAddress(GetModuleHandleA("kernel32.dll"), "SetThreadDescription");
+				if (setDescription)
+				{
+					WCHAR name[64];
+					if (MultiByteToWideChar(CP_UTF8, 0, p->mName, -1, name, 64))
+						setDescription(GetCurrentThread(), name);
+				}
+			}
 			p->mFunc(p->mParam);
 			delete p;
 			return 0;
 		}
 
-        ThreadHandle createThread(threadFunction aThreadFunction, void *aParameter)
+        ThreadHandle createThread(threadFunction aThreadFunction, void *aParameter, const ThreadAttributes *aAttributes)
 		{
 			soloud_thread_data *d = new soloud_thread_data;
 			d->mFunc = aThreadFunction;
 			d->mParam = aParameter;
-			HANDLE h = CreateThread(NULL,0,threadfunc,d,0,NULL);
+			d->mName[0] = 0;
+			if (aAttributes && aAttributes->mName)
+			{
+				strncpy(d->mName, aAttributes->mName, sizeof(d->mName) - 1);
+				d->mName[sizeof(d->mName) - 1] = 0;
+			}
+			HANDLE h = CreateThread(NULL, aAttributes ? aAttributes->mStackSize : 0, threadfunc, d, CREATE_SUSPENDED, NULL);
             if (0 == h)
             {
+                delete d;
                 return 0;
             }
+			if (aAttributes)
+			{
+				// Windows has no user-mode realtime policies; time critical is the closest
+				if (aAttributes->mPriority == ThreadAttributes::PRIORITY_FIFO || aAttributes->mPriority == ThreadAttributes::PRIORITY_RR)
+					SetThreadPriority(h, THREAD_PRIORITY_TIME_CRITICAL);
+				if (aAttributes->mAffinityMask)
+					SetThreadAffinityMask(h, (DWORD_PTR)aAttributes->mAffinityMask);
+			}
+			ResumeThread(h);
             ThreadHandleData *threadHandle = new ThreadHandleData;
             threadHandle->thread = h;
             return threadHandle;
@@ -126,6 +191,36 @@ namespace SoLoud
 			return GetTickCount();
 		}
 
+		void memoryBarrier()
+		{
+			MemoryBarrier();
+		}
+
+		long long getTimeNanos()
+		{
+			LARGE_INTEGER freq, count;
+			QueryPerformanceFrequency(&freq);
+			QueryPerformanceCounter(&count);
+			long long sec = count.QuadPart / freq.QuadPart;
+			long long rem = count.QuadPart % freq.QuadPart;
+			return sec * 1000000000LL + rem * 1000000000LL / freq.QuadPart;
+		}
+
+		void sleepUntil(long long aNanos)
+		{
+			// Sleep() is only good to a millisecond or so; yield for the last bit
+			for (;;)
+			{
+				long long left = aNanos - getTimeNanos();
+				if (left <= 0)
+					return;
+				if (left > 2000000)
+					Sleep((DWORD)(left / 1000000 - 1));
+				else
+					Sleep(0);
+			}
+		}
+
 #else // pthreads
         struct ThreadHandleData
         {
@@ -174,28 +269,143 @@ namespace SoLoud
 			}
 		}
 
+		void * createCondition()
+		{
+			pthread_cond_t *cond = new pthread_cond_t;
+			pthread_cond_init(cond, NULL);
+			return (void*)cond;
+		}
+
+		void destroyCondition(void *aHandle)
+		{
+			pthread_cond_t *cond = (pthread_cond_t*)aHandle;
+			if (cond)
+			{
+				pthread_cond_destroy(cond);
+				delete cond;
+			}
+		}
+
+		void waitCondition(void *aHandle, void *aMutex)
+		{
+			pthread_cond_wait((pthread_cond_t*)aHandle, (pthread_mutex_t*)aMutex);
+		}
+
+		void signalCondition(void *aHandle)
+		{
+			pthread_cond_signal((pthread_cond_t*)aHandle);
+		}
+
+		void broadcastCondition(void *aHandle)
+		{
+			pthread_cond_broadcast((pthread_cond_t*)aHandle);
+		}
+
 		struct soloud_thread_data
 		{
 			threadFunction mFunc;
 			void *mParam;
+			unsigned long long mAffinityMask;
+			char mName[64];
 		};
 
 		static void * threadfunc(void * d)
 		{
 			soloud_thread_data *p = (soloud_thread_data *)d;
+#if defined(__linux__)
+			if (p->mAffinityMask)
+			{
+				cpu_set_t set;
+				CPU_ZERO(&set);
+				int i;
+				for (i = 0; i < 64 && i < CPU_SETSIZE; i++)
+					if (p->mAffinityMask & (1ULL << i))
+						CPU_SET(i, &set);
+				// pid 0 is the calling thread
+				sched_setaffinity(0, sizeof(set), &set);
+			}
+			if (p->mName[0])
+			{
+				// Linux limits names to 15 characters
+				p->mName[15] = 0;
+				pthread_setname_np(pthread_self(), p->mName);
+			}
+#elif defined(__APPLE__)
+			if (p->mName[0])
+				pthread_setname_np(p->mName);
+#endif
 			p->mFunc(p->mParam);
 			delete p;
 			return 0;
 		}
 
-		ThreadHandle createThread(threadFunction aThreadFunction, void *aParameter)
+		// Fill in pthread attributes; returns true if a realtime policy was requested
+		static bool setupAttributes(pthread_attr_t *aAttr, const ThreadAttributes *aAttributes, bool aRealtime)
+		{
+			pthread_attr_init(aAttr);
+			if (!aAttributes)
+				return false;
+			if (aAttributes->mStackSize)
+			{
+				size_t stack = aAttributes->mStackSize;
+#ifdef PTHREAD_STACK_MIN
+				if (stack < (size_t)PTHREAD_STACK_MIN)
+					stack = PTHREAD_STACK_MIN;
+#endif
+				pthread_attr_setstacksize(aAttr, stack);
+			}
+			if (!aRealtime || (aAttributes->mPriority != ThreadAttributes::PRIORITY_FIFO && aAttributes->mPriority != ThreadAttributes::PRIORITY_RR))
+				return false;
+
+			int policy = aAttributes->mPriority == ThreadAttributes::PRIORITY_FIFO ? SCHED_FIFO : SCHED_RR;
+			int minprio = sched_get_priority_min(policy);
+			int maxprio = sched_get_priority_max(policy);
+			int prio = aAttributes->mRealtimePriority;
+			if (prio == 0)
+				prio = maxprio < 70 ? maxprio : 70;
+			if (prio < minprio) prio = minprio;
+			if (prio > maxprio) prio = maxprio;
+
+			struct sched_param param;
+			memset(&param, 0, sizeof(param));
+			param.sched_priority = prio;
+			pthread_attr_setinheritsched(aAttr, PTHREAD_EXPLICIT_SCHED);
+			pthread_attr_setschedpolicy(aAttr, policy);
+			pthread_attr_setschedparam(aAttr, &param);
+			return true;
+		}
+
+		ThreadHandle createThread(threadFunction aThreadFunction, void *aParameter, const ThreadAttributes *aAttributes)
 		{
 			soloud_thread_data *d = new soloud_thread_data;
 			d->mFunc = aThreadFunction;
 			d->mParam = aParameter;
+			d->mAffinityMask = aAttributes ? aAttributes->mAffinityMask : 0;
+			d->mName[0] = 0;
+			if (aAttributes && aAttributes->mName)
+			{
+				strncpy(d->mName, aAttributes->mName, sizeof(d->mName) - 1);
+				d->mName[sizeof(d->mName) - 1] = 0;
+			}
 
 			ThreadHandleData *threadHandle = new ThreadHandleData;
-			pthread_create(&threadHandle->thread, NULL, threadfunc, (void*)d);
+			pthread_attr_t attr;
+			bool realtime = setupAttributes(&attr, aAttributes, true);
+			int rc = pthread_create(&threadHandle->thread, &attr, threadfunc, (void*)d);
+			pthread_attr_destroy(&attr);
+			if (rc != 0 && realtime)
+			{
+				// Most likely EPERM; run with normal scheduling instead
+				setupAttributes(&attr, aAttributes, false);
+				rc = pthread_create(&threadHandle->thread, &attr, threadfunc, (void*)d);
+				pthread_attr_destroy(&attr);
+			}
+			if (rc != 0)
+			{
+				delete d;
+				delete threadHandle;
+				return 0;
+			}
             return threadHandle;
 		}
 
@@ -218,29 +428,138 @@ namespace SoLoud
             delete aThreadHandle;
         }
 
+		void memoryBarrier()
+		{
+			__sync_synchronize();
+		}
+
 		int getTimeMillis()
 		{
 			struct timespec spec;
 			clock_gettime(CLOCK_REALTIME, &spec);
 			return spec.tv_sec * 1000 + (int)(spec.tv_nsec / 1.0e6);
 		}
+
+		long long getTimeNanos()
+		{
+			struct timespec spec;
+			clock_gettime(CLOCK_MONOTONIC, &spec);
+			return (long long)spec.tv_sec * 1000000000LL + spec.tv_nsec;
+		}
+
+		void sleepUntil(long long aNanos)
+		{
+#if defined(__APPLE__)
+			// No clock_nanosleep; sleep for the remaining time instead
+			long long left = aNanos - getTimeNanos();
+			if (left <= 0)
+				return;
+			struct timespec req;
+			req.tv_sec = (time_t)(left / 1000000000LL);
+			req.tv_nsec = (long)(left % 1000000000LL);
+			while (nanosleep(&req, &req) == -1 && errno == EINTR) {}
+#else
+			struct timespec req;
+			req.tv_sec = (time_t)(aNanos / 1000000000LL);
+			req.tv_nsec = (long)(aNanos % 1000000000LL);
+			while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &req, NULL) == EINTR) {}
+#endif
+		}
 #endif
 
-		static void poolWorker(void *aParam)
+		ThreadAttributes mixerThreadAttributes(const ThreadAttributes &aAttributes)
 		{
-			Pool *myPool = (Pool*)aParam;
-			while (myPool->mRunning)
+			ThreadAttributes attributes = aAttributes;
+			if (attributes.mName == 0)
+				attributes.mName = "soloud mixer";
+			return attributes;
+		}
+
+		struct PoolTaskEntry
+		{
+			PoolTask *mTask;
+			PoolGroup *mGroup;
+		};
+
+		// Double-ended task queue. The owning worker takes the newest task
+		// from the back, idle workers steal the oldest from the front.
+		struct PoolWorker
+		{
+			Pool *mPool;
+			int mIndex;
+			void *mMutex;
+			PoolTaskEntry *mEntry;
+			int mCapacity;
+			int mHead;
+			int mCount;
+
+			void push(const PoolTaskEntry &aEntry)
 			{
-				PoolTask *t = myPool->getWork();
-				if (!t)
+				if (mCount == mCapacity)
 				{
-					sleep(1);
+					int capacity = mCapacity ? mCapacity * 2 : THREADPOOL_INITIAL_TASKS;
+					PoolTaskEntry *entry = new PoolTaskEntry[capacity];
+					int i;
+					for (i = 0; i < mCount; i++)
+						entry[i] = mEntry[(mHead + i) % mCapacity];
+					delete[] mEntry;
+					mEntry = entry;
+					mCapacity = capacity;
+					mHead = 0;
 				}
-				else
+				mEntry[(mHead + mCount) % mCapacity] = aEntry;
+				mCount++;
+			}
+
+			bool popBack(PoolTaskEntry &aEntry)
+			{
+				bool found = false;
+				lockMutex(mMutex);
+				if (mCount > 0)
 				{
-					t->work();
+					mCount--;
+					aEntry = mEntry[(mHead + mCount) % mCapacity];
+					found = true;
 				}
+				unlockMutex(mMutex);
+				return found;
 			}
+
+			bool popFront(PoolTaskEntry &aEntry)
+			{
+				bool found = false;
+				lockMutex(mMutex);
+				if (mCount > 0)
+				{
+					aEntry = mEntry[mHead];
+					mHead = (mHead + 1) % mCapacity;
+					mCount--;
+					found = true;
+				}
+				unlockMutex(mMutex);
+				return found;
+			}
+		};
+
+		static void poolWorker(void *aParam)
+		{
+			PoolWorker *worker = (PoolWorker*)aParam;
+			Pool *myPool = worker->mPool;
+			while (myPool->mRunning)
+			{
+				if (!myPool->runTask_internal(worker->mIndex))
+				{
+					lockMutex(myPool->mWorkMutex);
+					while (myPool->mRunning && myPool->mQueued == 0)
+						waitCondition(myPool->mWorkCondition, myPool->mWorkMutex);
+					unlockMutex(myPool->mWorkMutex);
+				}
+			}
+		}
+
+		PoolGroup::PoolGroup()
+		{
+			mPending = 0;
 		}
 
 		Pool::Pool()
@@ -248,83 +567,219 @@ namespace SoLoud
 			mRunning = 0;
 			mThreadCount = 0;
 			mThread = 0;
+			mWorker = 0;
 			mWorkMutex = 0;
+			mWorkCondition = 0;
+			mDoneCondition = 0;
+			mQueued = 0;
+			mOutstanding = 0;
 			mRobin = 0;
-			mMaxTask = 0;
-			for (int i = 0; i < MAX_THREADPOOL_TASKS; i++)
-				mTaskArray[i] = 0;
 		}
 
 		Pool::~Pool()
 		{
-			mRunning = 0;
+			if (mWorkMutex)
+			{
+				lockMutex(mWorkMutex);
+				mRunning = 0;
+				broadcastCondition(mWorkCondition);
+				unlockMutex(mWorkMutex);
+			}
 			int i;
 			for (i = 0; i < mThreadCount; i++)
 			{
-				wait(mThread[i]);
-				release(mThread[i]);
+				if (mThread[i])
+				{
+					Thread::wait(mThread[i]);
+					Thread::release(mThread[i]);
+				}
 			}
 			delete[] mThread;
+			for (i = 0; i < mThreadCount; i++)
+			{
+				destroyMutex(mWorker[i].mMutex);
+				delete[] mWorker[i].mEntry;
+			}
+			delete[] mWorker;
+			if (mWorkCondition)
+				destroyCondition(mWorkCondition);
+			if (mDoneCondition)
+				destroyCondition(mDoneCondition);
 			if (mWorkMutex)
 				destroyMutex(mWorkMutex);
 		}
 
-		void Pool::init(int aThreadCount)
+		void Pool::init(int aThreadCount, const ThreadAttributes *aAttributes)
 		{
-			if (aThreadCount > 0)
+			if (aThreadCount > 0 && mThreadCount == 0)
 			{
-				mMaxTask = 0;
 				mWorkMutex = createMutex();
+				mWorkCondition = createCondition();
+				mDoneCondition = createCondition();
 				mRunning = 1;
 				mThreadCount = aThreadCount;
+				mWorker = new PoolWorker[aThreadCount];
 				mThread = new ThreadHandle[aThreadCount];
 				int i;
-				for (i = 0; i < mThreadCount; i++)
+				for (i = 0; i < aThreadCount; i++)
 				{
-					mThread[i] = createThread(poolWorker, this);
+					mWorker[i].mPool = this;
+					mWorker[i].mIndex = i;
+					mWorker[i].mMutex = createMutex();
+					mWorker[i].mEntry = 0;
+					mWorker[i].mCapacity = 0;
+					mWorker[i].mHead = 0;
+					mWorker[i].mCount = 0;
+				}
+				int started = 0;
+				for (i = 0; i < aThreadCount; i++)
+				{
+					// Queues of threads that failed to start are still drained by stealing
+					mThread[i] = createThread(poolWorker, &mWorker[i], aAttributes);
+					if (mThread[i])
+						started++;
+				}
+				if (started == 0)
+				{
+					// Fall back to doing the work at addWork call
+					for (i = 0; i < aThreadCount; i++)
+					{
+						destroyMutex(mWorker[i].mMutex);
+					}
+					delete[] mWorker;
+					delete[] mThread;
+					mWorker = 0;
+					mThread = 0;
+					mThreadCount = 0;
+					mRunning = 0;
 				}
 			}
 		}
 
-		void Pool::addWork(PoolTask *aTask)
+		void Pool::addWork(PoolTask *aTask, PoolGroup *aGroup)
+		{
+			addWork(&aTask, 1, aGroup);
+		}
+
+		void Pool::addWork(PoolTask **aTasks, int aCount, PoolGroup *aGroup)
 		{
+			int i;
 			if (mThreadCount == 0)
 			{
-				aTask->work();
+				for (i = 0; i < aCount; i++)
+					aTasks[i]->work();
+				return;
 			}
-			else
+			if (aCount <= 0)
+				return;
+
+			// Workers only ever hold one queue mutex at a time and never
+			// take the pool mutex while holding it, so nesting is safe here.
+			lockMutex(mWorkMutex);
+			int first = mRobin;
+			mRobin = (mRobin + aCount) % mThreadCount;
+			int w;
+			for (w = 0; w < mThreadCount && w < aCount; w++)
 			{
-				if (mWorkMutex) lockMutex(mWorkMutex);
-				if (mMaxTask == MAX_THREADPOOL_TASKS)
-				{
-					// If we're at max tasks, do the task on calling thread 
-					// (we're in trouble anyway, might as well slow down adding more work)
-					if (mWorkMutex) unlockMutex(mWorkMutex);
-					aTask->work();
-				}
-				else
+				PoolWorker &worker = mWorker[(first + w) % mThreadCount];
+				lockMutex(worker.mMutex);
+				for (i = w; i < aCount; i += mThreadCount)
 				{
-					mTaskArray[mMaxTask] = aTask;
-					mMaxTask++;
-					if (mWorkMutex) unlockMutex(mWorkMutex);
+					PoolTaskEntry entry;
+					entry.mTask = aTasks[i];
+					entry.mGroup = aGroup;
+					worker.push(entry);
 				}
+				unlockMutex(worker.mMutex);
 			}
+			mQueued += aCount;
+			mOutstanding += aCount;
+			if (aGroup)
+				aGroup->mPending += aCount;
+			if (aCount == 1)
+				signalCondition(mWorkCondition);
+			else
+				broadcastCondition(mWorkCondition);
+			unlockMutex(mWorkMutex);
+		}
+
+		// Take a pending task off the queues, preferring worker aWorker's own
+		static bool takeTask(Pool *aPool, int aWorker, PoolTaskEntry &aEntry)
+		{
+			bool found = false;
+			if (aWorker >= 0 && aWorker < aPool->mThreadCount)
+				found = aPool->mWorker[aWorker].popBack(aEntry);
+			int i;
+			for (i = 1; !found && i <= aPool->mThreadCount; i++)
+			{
+				int victim = (aWorker + i) % aPool->mThreadCount;
+				if (victim != aWorker)
+					found = aPool->mWorker[victim].popFront(aEntry);
+			}
+			if (!found)
+				return false;
+
+			lockMutex(aPool->mWorkMutex);
+			aPool->mQueued--;
+			unlockMutex(aPool->mWorkMutex);
+			return true;
+		}
+
+		// Count a taken task as done, waking up waiters if its group or the pool ran dry
+		static void finishTask(Pool *aPool, const PoolTaskEntry &aEntry)
+		{
+			lockMutex(aPool->mWorkMutex);
+			aPool->mOutstanding--;
+			if (aEntry.mGroup)
+				aEntry.mGroup->mPending--;
+			if (aPool->mOutstanding == 0 || (aEntry.mGroup && aEntry.mGroup->mPending == 0))
+				broadcastCondition(aPool->mDoneCondition);
+			unlockMutex(aPool->mWorkMutex);
+		}
+
+		bool Pool::runTask_internal(int aWorker)
+		{
+			PoolTaskEntry entry;
+			if (!takeTask(this, aWorker, entry))
+				return false;
+			entry.mTask->work();
+			finishTask(this, entry);
+			return true;
 		}
 
 		PoolTask * Pool::getWork()
 		{
-			PoolTask *t = 0;
-			if (mWorkMutex) lockMutex(mWorkMutex);
-			if (mMaxTask > 0)
+			PoolTaskEntry entry;
+			if (!takeTask(this, -1, entry))
+				return 0;
+			// The caller runs the task, so the pool stops tracking it here
+			finishTask(this, entry);
+			return entry.mTask;
+		}
+
+		void Pool::wait(PoolGroup *aGroup)
+		{
+			if (mThreadCount == 0)
+				return;
+			for (;;)
 			{
-				int r = mRobin % mMaxTask;
-				mRobin++;
-				t = mTaskArray[r];
-				mTaskArray[r] = mTaskArray[mMaxTask - 1];
-				mMaxTask--;
+				lockMutex(mWorkMutex);
+				int pending = aGroup ? aGroup->mPending : mOutstanding;
+				if (pending == 0)
+				{
+					unlockMutex(mWorkMutex);
+					return;
+				}
+				if (mQueued == 0)
+				{
+					// Everything left is already running; sleep until something finishes
+					waitCondition(mDoneCondition, mWorkMutex);
+					unlockMutex(mWorkMutex);
+					continue;
+				}
+				unlockMutex(mWorkMutex);
+				runTask_internal(-1);
 			}
-			if (mWorkMutex) unlockMutex(mWorkMutex);
-			return t;
 		}
 	}
 }
@@ -116,7 +116,7 @@ namespace SoLoud
 
 		BQRStateData &s = mState[aChannel];
 
-		// make sure we access pairs of samples (one sample may be skipped)
+		// make sure we access pairs of samples (the odd one is handled separately)
 		aSamples = aSamples & ~1; 
 
 		for (i = 0; i < aSamples; i +=2, c++)
@@ -138,12 +138,43 @@ namespace SoLoud
 			s.mX1 = s.mX2;
 			s.mX2 = x;
 		}
-		// If we skipped a sample earlier, patch it by just copying the previous.
+		// Odd sample count (the block may be split at a parameter change), filter the last one on its own.
 		if (osamples != aSamples)
-			aBuffer[c] = aBuffer[c - 1];
+		{
+			x = aBuffer[c];
+			float y = (mA0 * x) + (mA1 * s.mX1) + (mA2 * s.mX2) - (mB1 * s.mY1) - (mB2 * s.mY2);
+			aBuffer[c] += (y - aBuffer[c]) * mParam[WET];
+			s.mX2 = s.mX1;
+			s.mX1 = x;
+			s.mY2 = s.mY1;
+			s.mY1 = y;
+		}
 	}
 
 
+	bool BiquadResonantFilterInstance::hasTail()
+	{
+		int i;
+		for (i = 0; i < 8; i++)
+		{
+			if (fabs(mState[i].mY1) > 1e-6f || fabs(mState[i].mY2) > 1e-6f ||
+				mState[i].mX1 != 0 || mState[i].mX2 != 0)
+				return true;
+		}
+		return false;
+	}
+
+	void BiquadResonantFilterInstance::onSilence()
+	{
+		// Ring-out is below -120dB; drop it so we start from a clean state
+		int i;
+		for (i = 0; i < 8; i++)
+		{
+			mState[i].mY1 = 0;
+			mState[i].mY2 = 0;
+		}
+	}
+
 	BiquadResonantFilterInstance::~BiquadResonantFilterInstance()
 	{
 	}
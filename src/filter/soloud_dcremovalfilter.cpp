@@ -22,6 +22,7 @@ freely, subject to the following restrictions:
    distribution.
 */
 
+#include <string.h>
 #include "soloud.h"
 #include "soloud_dcremovalfilter.h"
 
@@ -34,28 +35,40 @@ namespace SoLoud
 		mBufferLength = 0;
 		mTotals = 0;
 		mOffset = 0;
+		mChannels = 0;
 		initParams(1);
 
 	}
 
+	void DCRemovalFilterInstance::prepare(unsigned int aChannels, float aSamplerate)
+	{
+		delete[] mBuffer;
+		delete[] mTotals;
+		mBufferLength = (int)ceil(mParent->mLength * aSamplerate);
+		if (mBufferLength < 1)
+			mBufferLength = 1;
+		mBuffer = new float[mBufferLength * aChannels];
+		mTotals = new float[aChannels];
+		mChannels = aChannels;
+		mOffset = 0;
+		unsigned int i;
+		for (i = 0; i < aChannels; i++)
+		{
+		    mTotals[i] = 0;
+		}
+		for (i = 0; i < mBufferLength * aChannels; i++)
+		{
+			mBuffer[i] = 0;
+		}
+	}
+
 	void DCRemovalFilterInstance::filter(float *aBuffer, unsigned int aSamples, unsigned int aBufferSize, unsigned int aChannels, float aSamplerate, double aTime)
 	{
 		updateParams(aTime);
 
-		if (mBuffer == 0)
+		if (mBuffer == 0 || mChannels != aChannels)
 		{
-			mBufferLength = (int)ceil(mParent->mLength * aSamplerate);
-			mBuffer = new float[mBufferLength * aChannels];
-			mTotals = new float[aChannels];
-			unsigned int i;
-			for (i = 0; i < aChannels; i++)
-			{
-			    mTotals[i] = 0;
-			}
-			for (i = 0; i < mBufferLength * aChannels; i++)
-			{
-				mBuffer[i] = 0;
-			}
+			prepare(aChannels, aSamplerate);
 		}
 
 		unsigned int i, j;
@@ -81,6 +94,18 @@ namespace SoLoud
 		}
 	}
 
+	bool DCRemovalFilterInstance::hasTail()
+	{
+		return mSilentSamples < (unsigned int)mBufferLength;
+	}
+
+	void DCRemovalFilterInstance::onSilence()
+	{
+		// The window is all zeros now; clear any rounding left in the totals
+		if (mTotals)
+			memset(mTotals, 0, sizeof(float) * mChannels);
+	}
+
 	DCRemovalFilterInstance::~DCRemovalFilterInstance()
 	{
 		delete[] mBuffer;
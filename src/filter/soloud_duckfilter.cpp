@@ -33,8 +33,7 @@ namespace SoLoud
 		mParam[DuckFilter::ONRAMP] = aParent->mOnRamp;
 		mParam[DuckFilter::OFFRAMP] = aParent->mOffRamp;
 		mParam[DuckFilter::LEVEL] = aParent->mLevel;
-		mListenTo = aParent->mListenTo;
-		mSoloud = aParent->mSoloud;
+		mSidechainHandle = aParent->mListenTo;
 		mCurrentLevel = 1;
 	}
 
@@ -48,20 +47,10 @@ namespace SoLoud
 		if (mParam[DuckFilter::OFFRAMP] > 0.01)
 			offramp_step = (1.0f - mParam[DuckFilter::LEVEL]) / (mParam[DuckFilter::OFFRAMP] * aSamplerate);
 
+		// The mixer fills in the level of the bus we're listening to
 		int soundOn = 0;
-		if (mSoloud)
-		{
-			int voiceno = mSoloud->getVoiceFromHandle_internal(mListenTo);
-			if (voiceno != -1)
-			{
-				BusInstance* bi = (BusInstance*)mSoloud->mVoice[voiceno];
-				float v = 0;
-				for (unsigned int i = 0; i < bi->mChannels; i++)
-					v += bi->mVisualizationChannelVolume[i];
-				if (v > 0.01f)
-					soundOn = 1;
-			}
-		}
+		if (mSidechainPeak > 0.01f)
+			soundOn = 1;
 		float level = mCurrentLevel;
 		for (unsigned int j = 0; j < aChannels; j++)
 		{
@@ -81,13 +70,18 @@ namespace SoLoud
 		mCurrentLevel = level;
 	}
 
+	bool DuckFilterInstance::hasTail()
+	{
+		return false;
+	}
+
 	DuckFilterInstance::~DuckFilterInstance()
 	{
 	}
 
 	DuckFilter::DuckFilter()
 	{
-		mSoloud = 0;
+		mListenTo = 0;
 		mOnRamp = 0.1f;
 		mOffRamp = 0.5f;
 		mLevel = 0.5f;
@@ -102,7 +96,6 @@ namespace SoLoud
 		mOnRamp = aOnRamp;
 		mOffRamp = aOffRamp;
 		mLevel = aLevel;
-		mSoloud = aSoloud;
 		
 		return 0;
 	}
@@ -22,6 +22,7 @@ freely, subject to the following restrictions:
    distribution.
 */
 
+#include <string.h>
 #include "soloud.h"
 #include "soloud_echofilter.h"
 
@@ -33,25 +34,36 @@ namespace SoLoud
 		mBufferLength = 0;
 		mBufferMaxLength = 0;
 		mOffset = 0;
+		mChannels = 0;
 		initParams(4);
 		mParam[EchoFilter::DELAY] = aParent->mDelay;
 		mParam[EchoFilter::DECAY] = aParent->mDecay;
 		mParam[EchoFilter::FILTER] = aParent->mFilter;
 	}
 
+	void EchoFilterInstance::prepare(unsigned int aChannels, float aSamplerate)
+	{
+		delete[] mBuffer;
+		mBufferMaxLength = (int)ceil(mParam[EchoFilter::DELAY] * aSamplerate);
+		if (mBufferMaxLength < 1)
+			mBufferMaxLength = 1;
+		mBuffer = new float[mBufferMaxLength * aChannels];
+		mChannels = aChannels;
+		mOffset = 0;
+		unsigned int i;
+		for (i = 0; i < mBufferMaxLength * aChannels; i++)
+		{
+			mBuffer[i] = 0;
+		}
+	}
+
 	void EchoFilterInstance::filter(float *aBuffer, unsigned int aSamples, unsigned int aBufferSize, unsigned int aChannels, float aSamplerate, double aTime)
 	{
 		updateParams(aTime);
-		if (mBuffer == 0)
+		if (mBuffer == 0 || mChannels != aChannels)
 		{
-			// We only know channels and sample rate at this point.. not really optimal
-			mBufferMaxLength = (int)ceil(mParam[EchoFilter::DELAY] * aSamplerate);
-			mBuffer = new float[mBufferMaxLength * aChannels];
-			unsigned int i;
-			for (i = 0; i < mBufferMaxLength * aChannels; i++)
-			{
-				mBuffer[i] = 0;
-			}
+			// Not prepared, or prepared for a different format
+			prepare(aChannels, aSamplerate);
 		}
 
 		mBufferLength = (int)ceil(mParam[EchoFilter::DELAY] * aSamplerate);
@@ -79,6 +91,29 @@ namespace SoLoud
 		}
 	}
 
+	bool EchoFilterInstance::hasTail()
+	{
+		if (mBuffer == 0)
+			return false;
+		if (mSilentSamples < (unsigned int)mBufferLength)
+			return true;
+		// While the echo is audible this returns at the first sample
+		int i;
+		for (i = 0; i < mBufferMaxLength * (int)mChannels; i++)
+		{
+			if (fabs(mBuffer[i]) > 1e-6f)
+				return true;
+		}
+		return false;
+	}
+
+	void EchoFilterInstance::onSilence()
+	{
+		// Drop the residue below the threshold
+		if (mBuffer)
+			memset(mBuffer, 0, sizeof(float) * mBufferMaxLength * mChannels);
+	}
+
 	EchoFilterInstance::~EchoFilterInstance()
 	{
 		delete[] mBuffer;
@@ -55,6 +55,7 @@ namespace SoLoud
 		mTemp = 0;
 		mLastPhase = 0;
 		mSumPhase = 0;
+		mChannels = 0;
 		mParent = 0;
 		int i;
 		for (i = 0; i < MAX_CHANNELS; i++)
@@ -78,6 +79,25 @@ namespace SoLoud
 		initParams(1);
 	}
 
+	void FFTFilterInstance::prepare(unsigned int aChannels, float /*aSamplerate*/)
+	{
+		delete[] mInputBuffer;
+		delete[] mMixBuffer;
+		delete[] mTemp;
+		delete[] mLastPhase;
+		delete[] mSumPhase;
+		mInputBuffer = new float[STFT_WINDOW_TWICE * aChannels];
+		mMixBuffer = new float[STFT_WINDOW_TWICE * aChannels];
+		mTemp = new float[STFT_WINDOW_SIZE];
+		mLastPhase = new float[STFT_WINDOW_SIZE * aChannels];
+		mSumPhase = new float[STFT_WINDOW_SIZE * aChannels];
+		memset(mInputBuffer, 0, sizeof(float) * STFT_WINDOW_TWICE * aChannels);
+		memset(mMixBuffer, 0, sizeof(float) * STFT_WINDOW_TWICE * aChannels);
+		memset(mLastPhase, 0, sizeof(float) * STFT_WINDOW_SIZE * aChannels);
+		memset(mSumPhase, 0, sizeof(float) * STFT_WINDOW_SIZE * aChannels);
+		mChannels = aChannels;
+	}
+
 	void FFTFilterInstance::filterChannel(float *aBuffer, unsigned int aSamples, float aSamplerate, double aTime, unsigned int aChannel, unsigned int aChannels)
 	{
 		if (aChannel == 0)
@@ -85,19 +105,10 @@ namespace SoLoud
 			updateParams(aTime);
 		}
 
-		// Chicken-egg problem: we don't know channel count before this. 
-		// Could allocate max_channels but that would potentially waste a lot of memory.
-		if (mInputBuffer == 0)
+		// Normally allocated in prepare(); the format may still differ from what we were told.
+		if (mInputBuffer == 0 || mChannels != aChannels)
 		{
-			mInputBuffer = new float[STFT_WINDOW_TWICE * aChannels];
-			mMixBuffer = new float[STFT_WINDOW_TWICE * aChannels];
-			mTemp = new float[STFT_WINDOW_SIZE];
-			mLastPhase = new float[STFT_WINDOW_SIZE * aChannels];
-			mSumPhase = new float[STFT_WINDOW_SIZE * aChannels];
-			memset(mInputBuffer, 0, sizeof(float) * STFT_WINDOW_TWICE * aChannels);
-			memset(mMixBuffer, 0, sizeof(float) * STFT_WINDOW_TWICE * aChannels);
-			memset(mLastPhase, 0, sizeof(float) * STFT_WINDOW_SIZE * aChannels);
-			memset(mSumPhase, 0, sizeof(float) * STFT_WINDOW_SIZE * aChannels);
+			prepare(aChannels, aSamplerate);
 		}
 
 		int i;
@@ -263,6 +274,12 @@ namespace SoLoud
 		magPhase2Comp(aFFTBuffer, aSamples);
 	}
 
+	bool FFTFilterInstance::hasTail()
+	{
+		// Input window plus the overlap-add buffer
+		return mSilentSamples < STFT_WINDOW_TWICE * 2;
+	}
+
 	FFTFilterInstance::~FFTFilterInstance()
 	{
 		delete[] mTemp;
@@ -34,27 +34,39 @@ namespace SoLoud
 		mBufferLength = 0;
 		mOffset = 0;
 		mIndex = 0;
+		mChannels = 0;
 		initParams(3);
 		mParam[FlangerFilter::WET] = 1;
 		mParam[FlangerFilter::FREQ] = mParent->mFreq;
 		mParam[FlangerFilter::DELAY] = mParent->mDelay;
 	}
 
+	void FlangerFilterInstance::prepare(unsigned int aChannels, float aSamplerate)
+	{
+		delete[] mBuffer;
+		mBufferLength = (int)ceil(mParam[FlangerFilter::DELAY] * aSamplerate);
+		if (mBufferLength < 1)
+			mBufferLength = 1;
+		mBuffer = new float[mBufferLength * aChannels];
+		mChannels = aChannels;
+		mOffset = 0;
+		if (mBuffer == NULL)
+		{
+			mBufferLength = 0;
+			return;
+		}
+		memset(mBuffer, 0, sizeof(float) * mBufferLength * aChannels);
+	}
+
 	void FlangerFilterInstance::filter(float *aBuffer, unsigned int aSamples, unsigned int aBufferSize, unsigned int aChannels, float aSamplerate, double aTime)
 	{
 		updateParams(aTime);
 
-		if (mBufferLength < mParam[FlangerFilter::DELAY] * aSamplerate)
+		if (mBufferLength < mParam[FlangerFilter::DELAY] * aSamplerate || mChannels != aChannels)
 		{
-			delete[] mBuffer;
-			mBufferLength = (int)ceil(mParam[FlangerFilter::DELAY] * aSamplerate);
-			mBuffer = new float[mBufferLength * aChannels];
-			if (mBuffer == NULL)
-			{
-				mBufferLength = 0;
+			prepare(aChannels, aSamplerate);
+			if (mBufferLength == 0)
 				return;
-			}
-			memset(mBuffer, 0, sizeof(float) * mBufferLength * aChannels);
 		}
 
 		unsigned int i, j;
@@ -79,6 +91,11 @@ namespace SoLoud
 		mOffset %= mBufferLength;
 	}
 
+	bool FlangerFilterInstance::hasTail()
+	{
+		return mSilentSamples < mBufferLength;
+	}
+
 	FlangerFilterInstance::~FlangerFilterInstance()
 	{
 		delete[] mBuffer;
@@ -0,0 +1,229 @@
+/*
+SoLoud audio engine
+Copyright (c) 2013-2021 Jari Komppa
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#include <math.h>
+#include "soloud.h"
+#include "soloud_limiterfilter.h"
+#include "soloud_misc.h"
+
+namespace SoLoud
+{
+	LimiterFilterInstance::LimiterFilterInstance(LimiterFilter *aParent)
+	{
+		mBuffer = 0;
+		mDelayLength = 0;
+		mOffset = 0;
+		mChannels = 0;
+		mEnvelope = 0;
+		mHold = 0;
+		mGain = 1;
+		mLookahead = aParent->mLookahead;
+		mScratch.init(SAMPLE_GRANULARITY);
+		initParams(4);
+		mParam[LimiterFilter::THRESHOLD] = aParent->mThreshold;
+		mParam[LimiterFilter::RELEASE] = aParent->mRelease;
+		mParam[LimiterFilter::GAINREDUCTION] = 0;
+	}
+
+	void LimiterFilterInstance::prepare(unsigned int aChannels, float aSamplerate)
+	{
+		delete[] mBuffer;
+		mDelayLength = (int)ceil(mLookahead * aSamplerate);
+		if (mDelayLength < 1)
+			mDelayLength = 1;
+		mChannels = aChannels;
+		mOffset = 0;
+		mBuffer = new float[mDelayLength * mChannels];
+		unsigned int i;
+		for (i = 0; i < mDelayLength * mChannels; i++)
+		{
+			mBuffer[i] = 0;
+		}
+	}
+
+	void LimiterFilterInstance::filter(float *aBuffer, unsigned int aSamples, unsigned int aBufferSize, unsigned int aChannels, float aSamplerate, double aTime)
+	{
+		updateParams(aTime);
+		if (mBuffer == 0 || mChannels != aChannels)
+		{
+			prepare(aChannels, aSamplerate);
+		}
+
+		float threshold = (float)pow(10.0f, mParam[LimiterFilter::THRESHOLD] / 20.0f);
+		float release = 0;
+		if (mParam[LimiterFilter::RELEASE] > 0)
+			release = (float)exp(-1.0f / (mParam[LimiterFilter::RELEASE] * aSamplerate));
+		// Gain reaches ~99% of the target within the lookahead window
+		float attack = (float)exp(-5.0f / mDelayLength);
+		float mingain = 1;
+		unsigned int channels = aChannels < mChannels ? aChannels : mChannels;
+
+		unsigned int ofs = 0;
+		while (ofs < aSamples)
+		{
+			unsigned int samples = aSamples - ofs;
+			if (samples > SAMPLE_GRANULARITY)
+				samples = SAMPLE_GRANULARITY;
+
+			float *gain = mScratch.mData;
+			Misc::linkedPeak(gain, aBuffer + ofs, samples, aBufferSize, channels);
+
+			unsigned int i, j;
+			for (i = 0; i < samples; i++)
+			{
+				float p = gain[i];
+				if (p >= mEnvelope)
+				{
+					mEnvelope = p;
+					mHold = mDelayLength;
+				}
+				else
+				if (mHold > 0)
+				{
+					mHold--;
+				}
+				else
+				{
+					mEnvelope = p + (mEnvelope - p) * release;
+				}
+
+				float target = mEnvelope > threshold ? threshold / mEnvelope : 1.0f;
+				if (target < mGain)
+					mGain = target + (mGain - target) * attack;
+				else
+					mGain = target + (mGain - target) * release;
+				if (mGain < mingain)
+					mingain = mGain;
+				gain[i] = mGain;
+			}
+
+			int startofs = mOffset;
+			for (j = 0; j < channels; j++)
+			{
+				float *buf = aBuffer + ofs + j * aBufferSize;
+				float *delay = mBuffer + j * mDelayLength;
+				int dofs = startofs;
+				for (i = 0; i < samples; i++)
+				{
+					float d = delay[dofs];
+					delay[dofs] = buf[i];
+					buf[i] = d + (d * gain[i] - d) * mParam[LimiterFilter::WET];
+					dofs++;
+					if (dofs == mDelayLength)
+						dofs = 0;
+				}
+				mOffset = dofs;
+			}
+			ofs += samples;
+		}
+
+		mParam[LimiterFilter::GAINREDUCTION] = -20.0f * (float)log10(mingain);
+	}
+
+	bool LimiterFilterInstance::hasTail()
+	{
+		return mSilentSamples < (unsigned int)mDelayLength;
+	}
+
+	void LimiterFilterInstance::onSilence()
+	{
+		// Delay line has flushed; release fully so the next sound starts unlimited
+		mEnvelope = 0;
+		mHold = 0;
+		mGain = 1;
+		mParam[LimiterFilter::GAINREDUCTION] = 0;
+	}
+
+	LimiterFilterInstance::~LimiterFilterInstance()
+	{
+		delete[] mBuffer;
+	}
+
+	LimiterFilter::LimiterFilter()
+	{
+		mThreshold = -1.0f;
+		mLookahead = 0.005f;
+		mRelease = 0.1f;
+	}
+
+	result LimiterFilter::setParams(float aThreshold, float aLookahead, float aRelease)
+	{
+		if (aThreshold > 0 || aThreshold < -60 || aLookahead < 0 || aLookahead > 0.1f || aRelease < 0)
+			return INVALID_PARAMETER;
+
+		mThreshold = aThreshold;
+		mLookahead = aLookahead;
+		mRelease = aRelease;
+
+		return 0;
+	}
+
+	int LimiterFilter::getParamCount()
+	{
+		return 4;
+	}
+
+	const char* LimiterFilter::getParamName(unsigned int aParamIndex)
+	{
+		if (aParamIndex > 3)
+			return 0;
+		const char *names[4] = {
+			"Wet",
+			"Threshold",
+			"Release",
+			"Gain Reduction"
+		};
+		return names[aParamIndex];
+	}
+
+	unsigned int LimiterFilter::getParamType(unsigned int /*aParamIndex*/)
+	{
+		return FLOAT_PARAM;
+	}
+
+	float LimiterFilter::getParamMax(unsigned int aParamIndex)
+	{
+		switch (aParamIndex)
+		{
+		case THRESHOLD: return 0;
+		case RELEASE: return 2;
+		case GAINREDUCTION: return 60;
+		}
+		return 1;
+	}
+
+	float LimiterFilter::getParamMin(unsigned int aParamIndex)
+	{
+		switch (aParamIndex)
+		{
+		case THRESHOLD: return -60;
+		}
+		return 0;
+	}
+
+	FilterInstance *LimiterFilter::createInstance()
+	{
+		return new LimiterFilterInstance(this);
+	}
+}
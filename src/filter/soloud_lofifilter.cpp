@@ -64,6 +64,12 @@ namespace SoLoud
 
 	}
 
+	bool LofiFilterInstance::hasTail()
+	{
+		// The held sample becomes zero on the next capture
+		return mChannelData[0].mSample != 0 || mChannelData[1].mSample != 0;
+	}
+
 	LofiFilterInstance::~LofiFilterInstance()
 	{
 	}
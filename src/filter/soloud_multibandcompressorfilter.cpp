@@ -0,0 +1,412 @@
+/*
+SoLoud audio engine
+Copyright (c) 2013-2021 Jari Komppa
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#include <math.h>
+#include "soloud.h"
+#include "soloud_multibandcompressorfilter.h"
+#include "soloud_misc.h"
+
+// Samples between gain computer updates
+#define MBC_GAIN_INTERVAL 16
+
+namespace SoLoud
+{
+	enum MBCSECTIONTYPE
+	{
+		MBC_LOWPASS,
+		MBC_HIGHPASS,
+		MBC_ALLPASS
+	};
+
+	// Butterworth (Q = 1/sqrt(2)) biquad; two cascaded sections make a 4th order Linkwitz-Riley
+	static void calcSection(MBCBiquadCoeffs &aCoeffs, int aType, float aFrequency, float aSamplerate)
+	{
+		float omega = (float)((2.0f * M_PI * aFrequency) / aSamplerate);
+		float sin_omega = (float)sin(omega);
+		float cos_omega = (float)cos(omega);
+		float alpha = sin_omega * 0.70710678f;
+		float scalar = 1.0f / (1.0f + alpha);
+
+		switch (aType)
+		{
+		default:
+		case MBC_LOWPASS:
+			aCoeffs.mB0 = 0.5f * (1.0f - cos_omega) * scalar;
+			aCoeffs.mB1 = (1.0f - cos_omega) * scalar;
+			aCoeffs.mB2 = aCoeffs.mB0;
+			break;
+		case MBC_HIGHPASS:
+			aCoeffs.mB0 = 0.5f * (1.0f + cos_omega) * scalar;
+			aCoeffs.mB1 = -(1.0f + cos_omega) * scalar;
+			aCoeffs.mB2 = aCoeffs.mB0;
+			break;
+		case MBC_ALLPASS:
+			aCoeffs.mB0 = (1.0f - alpha) * scalar;
+			aCoeffs.mB1 = -2.0f * cos_omega * scalar;
+			aCoeffs.mB2 = 1.0f;
+			break;
+		}
+		aCoeffs.mA1 = -2.0f * cos_omega * scalar;
+		aCoeffs.mA2 = (1.0f - alpha) * scalar;
+	}
+
+	static inline float runSection(const MBCBiquadCoeffs &aCoeffs, MBCBiquadState &aState, float aX)
+	{
+		float y = aCoeffs.mB0 * aX + aCoeffs.mB1 * aState.mX1 + aCoeffs.mB2 * aState.mX2 - aCoeffs.mA1 * aState.mY1 - aCoeffs.mA2 * aState.mY2;
+		aState.mX2 = aState.mX1;
+		aState.mX1 = aX;
+		aState.mY2 = aState.mY1;
+		aState.mY1 = y;
+		return y;
+	}
+
+	void MultibandCompressorFilterInstance::calcCrossovers()
+	{
+		float low = mParam[MultibandCompressorFilter::LOWCROSSOVER];
+		float high = mParam[MultibandCompressorFilter::HIGHCROSSOVER];
+		float nyquist = mSamplerate * 0.45f;
+		if (high > nyquist) high = nyquist;
+		if (low > high) low = high;
+		calcSection(mLowLP, MBC_LOWPASS, low, mSamplerate);
+		calcSection(mLowHP, MBC_HIGHPASS, low, mSamplerate);
+		calcSection(mHighLP, MBC_LOWPASS, high, mSamplerate);
+		calcSection(mHighHP, MBC_HIGHPASS, high, mSamplerate);
+		calcSection(mHighAP, MBC_ALLPASS, high, mSamplerate);
+	}
+
+	MultibandCompressorFilterInstance::MultibandCompressorFilterInstance(MultibandCompressorFilter *aParent)
+	{
+		unsigned int i, j;
+		for (i = 0; i < MAX_CHANNELS; i++)
+		{
+			for (j = 0; j < SECTION_COUNT; j++)
+			{
+				mState[i][j].mX1 = 0;
+				mState[i][j].mX2 = 0;
+				mState[i][j].mY1 = 0;
+				mState[i][j].mY2 = 0;
+			}
+		}
+		for (i = 0; i < 3; i++)
+		{
+			mEnvelope[i] = 0;
+			mCurrentGain[i] = 1;
+		}
+
+		mBand.init(3 * MAX_CHANNELS * SAMPLE_GRANULARITY);
+		mGain.init(3 * SAMPLE_GRANULARITY);
+
+		initParams(13);
+		mParam[MultibandCompressorFilter::LOWCROSSOVER] = aParent->mLowCrossover;
+		mParam[MultibandCompressorFilter::HIGHCROSSOVER] = aParent->mHighCrossover;
+		mParam[MultibandCompressorFilter::LOWTHRESHOLD] = aParent->mThreshold[0];
+		mParam[MultibandCompressorFilter::MIDTHRESHOLD] = aParent->mThreshold[1];
+		mParam[MultibandCompressorFilter::HIGHTHRESHOLD] = aParent->mThreshold[2];
+		mParam[MultibandCompressorFilter::RATIO] = aParent->mRatio;
+		mParam[MultibandCompressorFilter::ATTACK] = aParent->mAttack;
+		mParam[MultibandCompressorFilter::RELEASE] = aParent->mRelease;
+		mParam[MultibandCompressorFilter::MAKEUPGAIN] = aParent->mMakeupGain;
+
+		mSamplerate = 44100;
+		calcCrossovers();
+	}
+
+	void MultibandCompressorFilterInstance::filter(float *aBuffer, unsigned int aSamples, unsigned int aBufferSize, unsigned int aChannels, float aSamplerate, double aTime)
+	{
+		updateParams(aTime);
+		if (mParamChanged & ((1 << MultibandCompressorFilter::LOWCROSSOVER) | (1 << MultibandCompressorFilter::HIGHCROSSOVER)) || aSamplerate != mSamplerate)
+		{
+			mSamplerate = aSamplerate;
+			calcCrossovers();
+		}
+		mParamChanged = 0;
+
+		unsigned int channels = aChannels > MAX_CHANNELS ? MAX_CHANNELS : aChannels;
+		float attack = 0;
+		if (mParam[MultibandCompressorFilter::ATTACK] > 0)
+			attack = (float)exp(-1.0f / (mParam[MultibandCompressorFilter::ATTACK] * aSamplerate));
+		float release = 0;
+		if (mParam[MultibandCompressorFilter::RELEASE] > 0)
+			release = (float)exp(-1.0f / (mParam[MultibandCompressorFilter::RELEASE] * aSamplerate));
+		float slope = 0;
+		if (mParam[MultibandCompressorFilter::RATIO] > 1)
+			slope = 1.0f - 1.0f / mParam[MultibandCompressorFilter::RATIO];
+		float makeup = (float)pow(10.0f, mParam[MultibandCompressorFilter::MAKEUPGAIN] / 20.0f);
+		float wet = mParam[MultibandCompressorFilter::WET];
+		float maxreduction[3] = { 0, 0, 0 };
+
+		unsigned int ofs = 0;
+		while (ofs < aSamples)
+		{
+			unsigned int samples = aSamples - ofs;
+			if (samples > SAMPLE_GRANULARITY)
+				samples = SAMPLE_GRANULARITY;
+
+			unsigned int i, j, b;
+			// Split into bands. The low band goes through the high crossover's allpass
+			// so that the three bands sum back to a flat (allpass) response.
+			for (j = 0; j < channels; j++)
+			{
+				float *src = aBuffer + ofs + j * aBufferSize;
+				float *lo = mBand.mData + (0 * MAX_CHANNELS + j) * SAMPLE_GRANULARITY;
+				float *mid = mBand.mData + (1 * MAX_CHANNELS + j) * SAMPLE_GRANULARITY;
+				float *hi = mBand.mData + (2 * MAX_CHANNELS + j) * SAMPLE_GRANULARITY;
+				MBCBiquadState *s = mState[j];
+				for (i = 0; i < samples; i++)
+				{
+					float x = src[i];
+					float l = runSection(mLowLP, s[LOW_LP1], runSection(mLowLP, s[LOW_LP0], x));
+					float r = runSection(mLowHP, s[LOW_HP1], runSection(mLowHP, s[LOW_HP0], x));
+					lo[i] = runSection(mHighAP, s[HIGH_AP], l);
+					mid[i] = runSection(mHighLP, s[HIGH_LP1], runSection(mHighLP, s[HIGH_LP0], r));
+					hi[i] = runSection(mHighHP, s[HIGH_HP1], runSection(mHighHP, s[HIGH_HP0], r));
+				}
+			}
+
+			// Linked detector and gain computer per band
+			for (b = 0; b < 3; b++)
+			{
+				float *gain = mGain.mData + b * SAMPLE_GRANULARITY;
+				float threshold = mParam[MultibandCompressorFilter::LOWTHRESHOLD + b];
+				Misc::linkedPeak(gain, mBand.mData + b * MAX_CHANNELS * SAMPLE_GRANULARITY, samples, SAMPLE_GRANULARITY, channels);
+				float env = mEnvelope[b];
+				float current = mCurrentGain[b];
+				for (i = 0; i < samples; i += MBC_GAIN_INTERVAL)
+				{
+					unsigned int n = samples - i < MBC_GAIN_INTERVAL ? samples - i : MBC_GAIN_INTERVAL;
+					unsigned int k;
+					for (k = 0; k < n; k++)
+					{
+						float p = gain[i + k];
+						env = p + (env - p) * (p > env ? attack : release);
+					}
+					// The gain computer works in decibels, so only run it every few samples
+					// and ramp the linear gain in between.
+					float reduction = 0;
+					if (env > 0.000001f)
+					{
+						float over = 20.0f * (float)log10(env) - threshold;
+						if (over > 0)
+							reduction = over * slope;
+					}
+					if (reduction > maxreduction[b])
+						maxreduction[b] = reduction;
+					float g = (float)pow(10.0f, -reduction / 20.0f) * makeup;
+					g = 1.0f + (g - 1.0f) * wet;
+					float step = (g - current) / n;
+					for (k = 0; k < n; k++)
+					{
+						current += step;
+						gain[i + k] = current;
+					}
+					current = g;
+				}
+				mEnvelope[b] = env;
+				mCurrentGain[b] = current;
+			}
+
+			for (j = 0; j < channels; j++)
+			{
+				float *dst = aBuffer + ofs + j * aBufferSize;
+				float *lo = mBand.mData + (0 * MAX_CHANNELS + j) * SAMPLE_GRANULARITY;
+				float *mid = mBand.mData + (1 * MAX_CHANNELS + j) * SAMPLE_GRANULARITY;
+				float *hi = mBand.mData + (2 * MAX_CHANNELS + j) * SAMPLE_GRANULARITY;
+				float *glo = mGain.mData;
+				float *gmid = mGain.mData + SAMPLE_GRANULARITY;
+				float *ghi = mGain.mData + 2 * SAMPLE_GRANULARITY;
+				for (i = 0; i < samples; i++)
+				{
+					dst[i] = lo[i] * glo[i] + mid[i] * gmid[i] + hi[i] * ghi[i];
+				}
+			}
+			ofs += samples;
+		}
+
+		mParam[MultibandCompressorFilter::LOWGAINREDUCTION] = maxreduction[0];
+		mParam[MultibandCompressorFilter::MIDGAINREDUCTION] = maxreduction[1];
+		mParam[MultibandCompressorFilter::HIGHGAINREDUCTION] = maxreduction[2];
+	}
+
+	bool MultibandCompressorFilterInstance::hasTail()
+	{
+		unsigned int i, j;
+		for (i = 0; i < MAX_CHANNELS; i++)
+		{
+			for (j = 0; j < SECTION_COUNT; j++)
+			{
+				if (fabs(mState[i][j].mY1) > 1e-6f || fabs(mState[i][j].mY2) > 1e-6f ||
+					mState[i][j].mX1 != 0 || mState[i][j].mX2 != 0)
+					return true;
+			}
+		}
+		return false;
+	}
+
+	void MultibandCompressorFilterInstance::onSilence()
+	{
+		unsigned int i, j;
+		for (i = 0; i < MAX_CHANNELS; i++)
+		{
+			for (j = 0; j < SECTION_COUNT; j++)
+			{
+				mState[i][j].mY1 = 0;
+				mState[i][j].mY2 = 0;
+			}
+		}
+		for (i = 0; i < 3; i++)
+		{
+			mEnvelope[i] = 0;
+			mCurrentGain[i] = 1;
+		}
+		mParam[MultibandCompressorFilter::LOWGAINREDUCTION] = 0;
+		mParam[MultibandCompressorFilter::MIDGAINREDUCTION] = 0;
+		mParam[MultibandCompressorFilter::HIGHGAINREDUCTION] = 0;
+	}
+
+	MultibandCompressorFilterInstance::~MultibandCompressorFilterInstance()
+	{
+	}
+
+	MultibandCompressorFilter::MultibandCompressorFilter()
+	{
+		mLowCrossover = 200.0f;
+		mHighCrossover = 3000.0f;
+		mThreshold[0] = -12.0f;
+		mThreshold[1] = -12.0f;
+		mThreshold[2] = -12.0f;
+		mRatio = 4.0f;
+		mAttack = 0.01f;
+		mRelease = 0.1f;
+		mMakeupGain = 0.0f;
+	}
+
+	result MultibandCompressorFilter::setParams(float aLowCrossover, float aHighCrossover, float aThreshold, float aRatio, float aAttack, float aRelease, float aMakeupGain)
+	{
+		// Accept exactly the ranges advertised to live parameter editors
+		if (aLowCrossover < getParamMin(LOWCROSSOVER) || aLowCrossover > getParamMax(LOWCROSSOVER) ||
+			aHighCrossover < getParamMin(HIGHCROSSOVER) || aHighCrossover > getParamMax(HIGHCROSSOVER) ||
+			aHighCrossover <= aLowCrossover ||
+			aThreshold < getParamMin(LOWTHRESHOLD) || aThreshold > getParamMax(LOWTHRESHOLD) ||
+			aRatio < getParamMin(RATIO) || aRatio > getParamMax(RATIO) ||
+			aAttack < getParamMin(ATTACK) || aAttack > getParamMax(ATTACK) ||
+			aRelease < getParamMin(RELEASE) || aRelease > getParamMax(RELEASE) ||
+			aMakeupGain < getParamMin(MAKEUPGAIN) || aMakeupGain > getParamMax(MAKEUPGAIN))
+			return INVALID_PARAMETER;
+
+		mLowCrossover = aLowCrossover;
+		mHighCrossover = aHighCrossover;
+		mThreshold[0] = aThreshold;
+		mThreshold[1] = aThreshold;
+		mThreshold[2] = aThreshold;
+		mRatio = aRatio;
+		mAttack = aAttack;
+		mRelease = aRelease;
+		mMakeupGain = aMakeupGain;
+
+		return 0;
+	}
+
+	result MultibandCompressorFilter::setBandThresholds(float aLow, float aMid, float aHigh)
+	{
+		if (aLow > 0 || aLow < -60 || aMid > 0 || aMid < -60 || aHigh > 0 || aHigh < -60)
+			return INVALID_PARAMETER;
+
+		mThreshold[0] = aLow;
+		mThreshold[1] = aMid;
+		mThreshold[2] = aHigh;
+
+		return 0;
+	}
+
+	int MultibandCompressorFilter::getParamCount()
+	{
+		return 13;
+	}
+
+	const char* MultibandCompressorFilter::getParamName(unsigned int aParamIndex)
+	{
+		if (aParamIndex > 12)
+			return 0;
+		const char *names[13] = {
+			"Wet",
+			"Low Crossover",
+			"High Crossover",
+			"Low Threshold",
+			"Mid Threshold",
+			"High Threshold",
+			"Ratio",
+			"Attack",
+			"Release",
+			"Makeup Gain",
+			"Low Gain Reduction",
+			"Mid Gain Reduction",
+			"High Gain Reduction"
+		};
+		return names[aParamIndex];
+	}
+
+	unsigned int MultibandCompressorFilter::getParamType(unsigned int /*aParamIndex*/)
+	{
+		return FLOAT_PARAM;
+	}
+
+	float MultibandCompressorFilter::getParamMax(unsigned int aParamIndex)
+	{
+		switch (aParamIndex)
+		{
+		case LOWCROSSOVER: return 1000;
+		case HIGHCROSSOVER: return 16000;
+		case LOWTHRESHOLD:
+		case MIDTHRESHOLD:
+		case HIGHTHRESHOLD: return 0;
+		case RATIO: return 20;
+		case ATTACK: return 0.5f;
+		case RELEASE: return 2;
+		case MAKEUPGAIN: return 24;
+		case LOWGAINREDUCTION:
+		case MIDGAINREDUCTION:
+		case HIGHGAINREDUCTION: return 60;
+		}
+		return 1;
+	}
+
+	float MultibandCompressorFilter::getParamMin(unsigned int aParamIndex)
+	{
+		switch (aParamIndex)
+		{
+		case LOWCROSSOVER: return 20;
+		case HIGHCROSSOVER: return 1000;
+		case LOWTHRESHOLD:
+		case MIDTHRESHOLD:
+		case HIGHTHRESHOLD: return -60;
+		case RATIO: return 1;
+		}
+		return 0;
+	}
+
+	FilterInstance *MultibandCompressorFilter::createInstance()
+	{
+		return new MultibandCompressorFilterInstance(this);
+	}
+}
@@ -51,6 +51,16 @@ namespace SoLoud
 		}
 	}
 
+	bool RobotizeFilterInstance::hasTail()
+	{
+		return false;
+	}
+
+	bool RobotizeFilterInstance::canBypassWhenDry()
+	{
+		return true;
+	}
+
 	RobotizeFilter::RobotizeFilter()
 	{
 		mFreq = 30;
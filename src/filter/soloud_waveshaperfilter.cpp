@@ -56,6 +56,16 @@ namespace SoLoud
 		}
 	}
 
+	bool WaveShaperFilterInstance::hasTail()
+	{
+		return false;
+	}
+
+	bool WaveShaperFilterInstance::canBypassWhenDry()
+	{
+		return true;
+	}
+
 	WaveShaperFilterInstance::~WaveShaperFilterInstance()
 	{
 	}
@@ -0,0 +1,260 @@
+/*
+SoLoud audio engine
+Copyright (c) 2013-2021 Jari Komppa
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not
+claim that you wrote the original software. If you use this software
+in a product, an acknowledgment in the product documentation would be
+appreciated but is not required.
+
+2. Altered source versions must be plainly marked as such, and must not be
+misrepresented as being the original software.
+
+3. This notice may not be removed or altered from any source
+distribution.
+*/
+
+/*********************************************************************************
+*
+* Mixer benchmarks. Each scenario plays a number of looping voices through the
+* null driver and times mix calls with a high resolution timer. Scenarios vary
+* one thing at a time from a common baseline, so results can be compared
+* between runs to catch regressions.
+*
+* soloud_bench [--quick] [--filter text] [--json file] [--stream file]...
+*
+*   --quick        fewer and shorter runs
+*   --filter text  only run scenarios whose name contains text
+*   --json file    also write the results as JSON
+*   --stream file  add a WavStream scenario for a file (ogg, mp3, flac, wav)
+*
+**********************************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "soloud.h"
+#include "soloud_thread.h"
+#include "bench_scenarios.h"
+
+#define MAX_STREAMS 16
+#define MAX_RESULTS 64
+
+struct Result
+{
+	Scenario mScenario;
+	double mNsPerSample;
+	double mNsPerSampleMin;
+	double mRealtimeFactor;
+	double mVoicesPerCore;
+};
+
+static const char *gSourceName[] = { "wav", "wavstream", "file" };
+
+static Result gResult[MAX_RESULTS];
+static int gResultCount = 0;
+static int gRuns = 5;
+static int gBlocks = 1000;
+
+static int compareDouble(const void *a, const void *b)
+{
+	double x = *(const double*)a;
+	double y = *(const double*)b;
+	return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static bool runScenario(const Scenario &aScenario, Result &aResult)
+{
+	ScenarioPlayer *player = new ScenarioPlayer;
+	if (!player->init(aScenario))
+	{
+		delete player;
+		return false;
+	}
+
+	float *buf = new float[BENCH_BLOCK * MAX_CHANNELS];
+	unsigned int i;
+	// Warm up caches and let streams open their decoders
+	for (i = 0; i < 20; i++)
+		player->mix(buf);
+
+	double runs[16];
+	int run;
+	for (run = 0; run < gRuns; run++)
+	{
+		long long start = SoLoud::Thread::getTimeNanos();
+		int b;
+		for (b = 0; b < gBlocks; b++)
+			player->mix(buf);
+		long long elapsed = SoLoud::Thread::getTimeNanos() - start;
+		runs[run] = (double)elapsed / ((double)gBlocks * BENCH_BLOCK);
+	}
+	delete[] buf;
+	delete player;
+
+	qsort(runs, gRuns, sizeof(double), compareDouble);
+	aResult.mScenario = aScenario;
+	aResult.mNsPerSample = runs[gRuns / 2];
+	aResult.mNsPerSampleMin = runs[0];
+	// Seconds of audio mixed per second of cpu time
+	aResult.mRealtimeFactor = 1000000000.0 / (aResult.mNsPerSample * BENCH_SAMPLERATE);
+	aResult.mVoicesPerCore = aResult.mRealtimeFactor * aScenario.mVoices;
+	return true;
+}
+
+static void addAndRun(const Scenario &aScenario, const char *aFilter)
+{
+	if (aFilter && strstr(aScenario.mName, aFilter) == 0)
+		return;
+	if (gResultCount == MAX_RESULTS)
+		return;
+	Result &r = gResult[gResultCount];
+	if (!runScenario(aScenario, r))
+	{
+		printf("%-24s failed to set up\n", aScenario.mName);
+		return;
+	}
+	gResultCount++;
+	printf("%-24s %9.2f ns/sample (min %9.2f) %9.1fx realtime %10.0f voices/core\n",
+		aScenario.mName, r.mNsPerSample, r.mNsPerSampleMin, r.mRealtimeFactor, r.mVoicesPerCore);
+}
+
+class NopTask : public SoLoud::Thread::PoolTask
+{
+public:
+	virtual void work() {}
+};
+
+static double gPoolRoundTrip = 0;
+static double gPoolBatch = 0;
+
+// Thread pool dispatch latency: submit and wait for one task, and for a batch of 64
+static void runPool()
+{
+	SoLoud::Thread::Pool pool;
+	pool.init(4);
+	SoLoud::Thread::PoolGroup group;
+	NopTask tasks[64];
+	SoLoud::Thread::PoolTask *taskptr[64];
+	int i;
+	for (i = 0; i < 64; i++)
+		taskptr[i] = &tasks[i];
+	int count = gBlocks * 10;
+	long long start = SoLoud::Thread::getTimeNanos();
+	for (i = 0; i < count; i++)
+	{
+		pool.addWork(taskptr[0], &group);
+		pool.wait(&group);
+	}
+	gPoolRoundTrip = (double)(SoLoud::Thread::getTimeNanos() - start) / count;
+	start = SoLoud::Thread::getTimeNanos();
+	for (i = 0; i < count; i++)
+	{
+		pool.addWork(taskptr, 64, &group);
+		pool.wait(&group);
+	}
+	gPoolBatch = (double)(SoLoud::Thread::getTimeNanos() - start) / count;
+	printf("%-24s %9.0f ns round trip, %9.0f ns per batch of 64\n", "pool", gPoolRoundTrip, gPoolBatch);
+}
+
+static bool writeJson(const char *aFilename, unsigned int aSimdPath)
+{
+	FILE *f = fopen(aFilename, "w");
+	if (!f)
+		return false;
+	static const char *simdName[] = { "scalar", "sse", "avx2", "neon" };
+	fprintf(f, "{\n\t\"version\": %d,\n\t\"simd\": \"%s\",\n\t\"samplerate\": %d,\n\t\"block\": %d,\n\t\"runs\": %d,\n\t\"blocks\": %d,\n",
+		SOLOUD_VERSION, aSimdPath < 4 ? simdName[aSimdPath] : "unknown", BENCH_SAMPLERATE, BENCH_BLOCK, gRuns, gBlocks);
+	if (gPoolRoundTrip > 0)
+		fprintf(f, "\t\"pool\": { \"round_trip_ns\": %.1f, \"batch64_ns\": %.1f },\n", gPoolRoundTrip, gPoolBatch);
+	fprintf(f, "\t\"results\": [\n");
+	int i;
+	for (i = 0; i < gResultCount; i++)
+	{
+		const Result &r = gResult[i];
+		const Scenario &s = r.mScenario;
+		fprintf(f, "\t\t{ \"name\": \"%s\", \"voices\": %u, \"channels\": %u, \"resampler\": \"%s\", \"3d\": %s, \"filters\": %u, \"bus_depth\": %u, \"source\": \"%s\", "
+			"\"ns_per_sample\": %.3f, \"ns_per_sample_min\": %.3f, \"ns_per_voice_sample\": %.3f, \"realtime_factor\": %.2f, \"voices_per_core\": %.1f }%s\n",
+			s.mName, s.mVoices, s.mChannels, gResamplerName[s.mResampler], s.m3d ? "true" : "false", s.mFilters, s.mBusDepth, gSourceName[s.mSource],
+			r.mNsPerSample, r.mNsPerSampleMin, r.mNsPerSample / s.mVoices, r.mRealtimeFactor, r.mVoicesPerCore,
+			i + 1 < gResultCount ? "," : "");
+	}
+	fprintf(f, "\t]\n}\n");
+	fclose(f);
+	return true;
+}
+
+int main(int parc, char **pars)
+{
+	const char *filter = 0;
+	const char *json = 0;
+	const char *streams[MAX_STREAMS];
+	int streamcount = 0;
+	int i;
+	for (i = 1; i < parc; i++)
+	{
+		if (strcmp(pars[i], "--quick") == 0)
+		{
+			gRuns = 3;
+			gBlocks = 100;
+		}
+		else
+		if (strcmp(pars[i], "--filter") == 0 && i + 1 < parc)
+		{
+			filter = pars[++i];
+		}
+		else
+		if (strcmp(pars[i], "--json") == 0 && i + 1 < parc)
+		{
+			json = pars[++i];
+		}
+		else
+		if (strcmp(pars[i], "--stream") == 0 && i + 1 < parc)
+		{
+			if (streamcount < MAX_STREAMS)
+				streams[streamcount++] = pars[++i];
+			else
+				i++;
+		}
+		else
+		{
+			printf("Usage: %s [--quick] [--filter text] [--json file] [--stream file]...\n", pars[0]);
+			return 1;
+		}
+	}
+
+	initScenarioData();
+
+	unsigned int simdpath = 0;
+	{
+		SoLoud::Soloud soloud;
+		soloud.init(SoLoud::Soloud::CLIP_ROUNDOFF, SoLoud::Soloud::NULLDRIVER);
+		simdpath = soloud.mSimdPath;
+	}
+
+	Scenario scenario[MAX_RESULTS];
+	int count = buildScenarios(scenario, MAX_RESULTS, streams, streamcount);
+	for (i = 0; i < count; i++)
+		addAndRun(scenario[i], filter);
+
+	if (!filter || strstr("pool", filter))
+		runPool();
+
+	freeScenarioData();
+
+	if (json && !writeJson(json, simdpath))
+	{
+		printf("Could not write %s\n", json);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,312 @@
+/*
+SoLoud audio engine
+Copyright (c) 2013-2021 Jari Komppa
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not
+claim that you wrote the original software. If you use this software
+in a product, an acknowledgment in the product documentation would be
+appreciated but is not required.
+
+2. Altered source versions must be plainly marked as such, and must not be
+misrepresented as being the original software.
+
+3. This notice may not be removed or altered from any source
+distribution.
+*/
+
+/*********************************************************************************
+*
+* Mixer scenarios shared by soloud_bench and the sanity golden renders. Each
+* scenario plays a number of looping voices through the null driver; they vary
+* one thing at a time from a common baseline.
+*
+**********************************************************************************/
+
+#ifndef BENCH_SCENARIOS_H
+#define BENCH_SCENARIOS_H
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "soloud.h"
+#include "soloud_biquadresonantfilter.h"
+#include "soloud_echofilter.h"
+#include "soloud_wav.h"
+#include "soloud_wavstream.h"
+
+#define BENCH_SAMPLERATE 48000
+#define BENCH_BLOCK 512
+#define MAX_BUS_DEPTH 8
+
+enum SOURCE_TYPE
+{
+	SOURCE_WAV,
+	SOURCE_WAVSTREAM,
+	SOURCE_FILE
+};
+
+struct Scenario
+{
+	char mName[64];
+	unsigned int mVoices;
+	unsigned int mChannels;
+	unsigned int mResampler;
+	bool m3d;
+	unsigned int mFilters;
+	unsigned int mBusDepth;
+	unsigned int mSource;
+	const char *mFile;
+};
+
+static const char *gResamplerName[] = { "point", "linear", "catmullrom" };
+
+static unsigned char *gPcmWav = 0;
+static unsigned int gPcmWavSize = 0;
+static float gTone[22050];
+
+// 2 seconds of 16-bit stereo noise and tone as a RIFF file in memory, for WavStream
+static void makePcmWav()
+{
+	unsigned int frames = 44100 * 2;
+	unsigned int datasize = frames * 4;
+	gPcmWavSize = 44 + datasize;
+	gPcmWav = new unsigned char[gPcmWavSize];
+	unsigned char *p = gPcmWav;
+	memcpy(p, "RIFF", 4); p += 4;
+	unsigned int v = gPcmWavSize - 8;
+	p[0] = v & 0xff; p[1] = (v >> 8) & 0xff; p[2] = (v >> 16) & 0xff; p[3] = v >> 24; p += 4;
+	memcpy(p, "WAVEfmt ", 8); p += 8;
+	const unsigned char fmt[] = { 16, 0, 0, 0, 1, 0, 2, 0, 0x44, 0xac, 0, 0, 0x10, 0xb1, 0x02, 0, 4, 0, 16, 0 };
+	memcpy(p, fmt, sizeof(fmt)); p += sizeof(fmt);
+	memcpy(p, "data", 4); p += 4;
+	p[0] = datasize & 0xff; p[1] = (datasize >> 8) & 0xff; p[2] = (datasize >> 16) & 0xff; p[3] = datasize >> 24; p += 4;
+	unsigned int i;
+	unsigned int seed = 1;
+	for (i = 0; i < frames * 2; i++)
+	{
+		seed = seed * 1103515245 + 12345;
+		short s = (short)(sin(i * 0.01) * 8000 + (int)((seed >> 16) & 0x1fff) - 0x1000);
+		p[i * 2] = s & 0xff;
+		p[i * 2 + 1] = (s >> 8) & 0xff;
+	}
+}
+
+static void makeTone()
+{
+	int i;
+	for (i = 0; i < 22050; i++)
+		gTone[i] = (float)(sin(i * 0.05) * 0.5 + sin(i * 0.0131) * 0.25);
+}
+
+static void initScenarioData()
+{
+	makeTone();
+	makePcmWav();
+}
+
+static void freeScenarioData()
+{
+	delete[] gPcmWav;
+	gPcmWav = 0;
+	gPcmWavSize = 0;
+}
+
+static Scenario baseline()
+{
+	Scenario s;
+	strcpy(s.mName, "baseline");
+	s.mVoices = 32;
+	s.mChannels = 2;
+	s.mResampler = SoLoud::Soloud::RESAMPLER_LINEAR;
+	s.m3d = false;
+	s.mFilters = 0;
+	s.mBusDepth = 0;
+	s.mSource = SOURCE_WAV;
+	s.mFile = 0;
+	return s;
+}
+
+// Fills aList with the standard scenario set plus one scenario per stream file.
+// Returns the number of scenarios written.
+static int buildScenarios(Scenario *aList, int aMax, const char **aStreams, int aStreamCount)
+{
+	int count = 0;
+	int i;
+	Scenario s = baseline();
+	if (count < aMax) aList[count++] = s;
+
+	static const unsigned int voices[] = { 1, 8, 128, 255 };
+	for (i = 0; i < (int)(sizeof(voices) / sizeof(voices[0])); i++)
+	{
+		s = baseline();
+		s.mVoices = voices[i];
+		sprintf(s.mName, "voices_%u", voices[i]);
+		if (count < aMax) aList[count++] = s;
+	}
+
+	static const unsigned int channels[] = { 1, 4, 6, 8 };
+	for (i = 0; i < (int)(sizeof(channels) / sizeof(channels[0])); i++)
+	{
+		s = baseline();
+		s.mChannels = channels[i];
+		sprintf(s.mName, "channels_%u", channels[i]);
+		if (count < aMax) aList[count++] = s;
+	}
+
+	for (i = 0; i < 3; i++)
+	{
+		if (i == SoLoud::Soloud::RESAMPLER_LINEAR)
+			continue;
+		s = baseline();
+		s.mResampler = i;
+		sprintf(s.mName, "resampler_%s", gResamplerName[i]);
+		if (count < aMax) aList[count++] = s;
+	}
+
+	s = baseline();
+	s.m3d = true;
+	strcpy(s.mName, "3d");
+	if (count < aMax) aList[count++] = s;
+
+	for (i = 1; i <= 2; i++)
+	{
+		s = baseline();
+		s.mFilters = i;
+		sprintf(s.mName, "filters_%d", i);
+		if (count < aMax) aList[count++] = s;
+	}
+
+	static const unsigned int depths[] = { 1, 4 };
+	for (i = 0; i < (int)(sizeof(depths) / sizeof(depths[0])); i++)
+	{
+		s = baseline();
+		s.mBusDepth = depths[i];
+		sprintf(s.mName, "busdepth_%u", depths[i]);
+		if (count < aMax) aList[count++] = s;
+	}
+
+	s = baseline();
+	s.mSource = SOURCE_WAVSTREAM;
+	strcpy(s.mName, "wavstream_pcm");
+	if (count < aMax) aList[count++] = s;
+
+	for (i = 0; i < aStreamCount; i++)
+	{
+		s = baseline();
+		s.mSource = SOURCE_FILE;
+		s.mFile = aStreams[i];
+		const char *base = strrchr(aStreams[i], '/');
+		base = base ? base + 1 : aStreams[i];
+		sprintf(s.mName, "stream_%.48s", base);
+		if (count < aMax) aList[count++] = s;
+	}
+	return count;
+}
+
+// Owns the engine and the sources for one scenario
+class ScenarioPlayer
+{
+public:
+	// Sources are declared after the engine so they die first
+	SoLoud::Soloud mSoloud;
+	SoLoud::Wav mWav;
+	SoLoud::WavStream mStream;
+	SoLoud::BiquadResonantFilter mBiquad;
+	SoLoud::EchoFilter mEcho;
+	SoLoud::Bus mBus[MAX_BUS_DEPTH];
+	Scenario mScenario;
+
+	~ScenarioPlayer()
+	{
+		mSoloud.stopAll();
+	}
+
+	// Returns false if the engine or the source could not be set up
+	bool init(const Scenario &aScenario)
+	{
+		mScenario = aScenario;
+		if (mSoloud.init(SoLoud::Soloud::CLIP_ROUNDOFF, SoLoud::Soloud::NULLDRIVER, BENCH_SAMPLERATE, BENCH_BLOCK, aScenario.mChannels) != SoLoud::SO_NO_ERROR)
+			return false;
+		unsigned int depth = aScenario.mBusDepth < MAX_BUS_DEPTH ? aScenario.mBusDepth : MAX_BUS_DEPTH;
+		// Busses take active voices too
+		unsigned int active = aScenario.mVoices + depth;
+		if (active > 255)
+			active = 255;
+		if (active > 16)
+			mSoloud.setMaxActiveVoiceCount(active);
+		mSoloud.setMainResampler(aScenario.mResampler);
+
+		SoLoud::AudioSource *source = &mWav;
+		if (aScenario.mSource == SOURCE_WAV)
+		{
+			mWav.loadRawWave(gTone, 22050, 22050, 1, true, true);
+		}
+		else
+		{
+			SoLoud::result res;
+			if (aScenario.mSource == SOURCE_WAVSTREAM)
+				res = mStream.loadMem(gPcmWav, gPcmWavSize, false, false);
+			else
+				res = mStream.load(aScenario.mFile);
+			if (res != SoLoud::SO_NO_ERROR)
+				return false;
+			source = &mStream;
+		}
+		source->setLooping(true);
+		mBiquad.setParams(SoLoud::BiquadResonantFilter::LOWPASS, 2000, 2);
+		mEcho.setParams(0.1f, 0.5f);
+		if (aScenario.mFilters > 0)
+			source->setFilter(0, &mBiquad);
+		if (aScenario.mFilters > 1)
+			source->setFilter(1, &mEcho);
+
+		unsigned int i;
+		for (i = 0; i < depth; i++)
+		{
+			mBus[i].setResampler(aScenario.mResampler);
+			if (i == 0)
+				mSoloud.play(mBus[i]);
+			else
+				mBus[i - 1].play(mBus[i]);
+		}
+		for (i = 0; i < aScenario.mVoices; i++)
+		{
+			float a = i * 6.283185f / aScenario.mVoices;
+			float vol = 1.0f / aScenario.mVoices;
+			if (aScenario.m3d)
+			{
+				if (depth)
+					mBus[depth - 1].play3d(*source, cos(a) * 10, 0, sin(a) * 10, 0, 0, 0, vol);
+				else
+					mSoloud.play3d(*source, cos(a) * 10, 0, sin(a) * 10, 0, 0, 0, vol);
+			}
+			else
+			{
+				if (depth)
+					mBus[depth - 1].play(*source, vol, (float)sin(a));
+				else
+					mSoloud.play(*source, vol, (float)sin(a));
+			}
+		}
+		return true;
+	}
+
+	// Mixes one block of BENCH_BLOCK frames, interleaved
+	void mix(float *aBuffer)
+	{
+		if (mScenario.m3d)
+			mSoloud.update3dAudio();
+		mSoloud.mix(aBuffer, BENCH_BLOCK);
+	}
+};
+
+#endif
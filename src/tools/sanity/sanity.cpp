@@ -37,24 +37,35 @@ distribution.
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <string.h>
 
 #include "soloud.h"
 #include "soloud_bassboostfilter.h"
 #include "soloud_biquadresonantfilter.h"
 #include "soloud_dcremovalfilter.h"
+#include "soloud_duckfilter.h"
 #include "soloud_echofilter.h"
 #include "soloud_flangerfilter.h"
+#include "soloud_internal.h"
+#include "soloud_limiterfilter.h"
 #include "soloud_lofifilter.h"
 #include "soloud_monotone.h"
+#include "soloud_multibandcompressorfilter.h"
+#include "soloud_offline.h"
 #include "soloud_openmpt.h"
+#include "soloud_queue.h"
+#include "soloud_pcmstream.h"
+#include "soloud_audioinput.h"
 #include "soloud_robotizefilter.h"
 #include "soloud_sfxr.h"
 #include "soloud_speech.h"
 #include "soloud_tedsid.h"
+#include "soloud_thread.h"
 #include "soloud_vic.h"
 #include "soloud_wav.h"
 #include "soloud_waveshaperfilter.h"
 #include "soloud_wavstream.h"
+#include "../bench/bench_scenarios.h"
 
 // This option is useful while developing tests:
 //#define NO_LASTKNOWN_CHECK
@@ -75,36 +86,9 @@ int lastknownwrite = 0;
 #define CHECK_BUF_SAME(x, y, n) tests++; { int i, diff = 0; for (i = 0; i < (n); i++) if (fabs((x)[i] - (y)[i]) > 0.00001) diff++; if (diff) { errorcount++; printf("Error on line %d, %s(): buffers differ (%d / %d)\n",__LINE__,__FUNCTION__, diff, (n));}}
 #define CHECK_BUF_SAME_LASTKNOWN(x, n) tests++; { int i, diff = 0, ofs = 0; float maxdiff = 0.0f; for (i = 0; i < (n); i++) { if (fabs((x)[i] - lastknownscratch[i]) > 0.00001) diff++; if (fabs((x)[i] - lastknownscratch[i]) > maxdiff) { ofs = i; maxdiff = (float)fabs((x)[i] - lastknownscratch[i]); }} if (diff) { errorcount++; printf("Error on line %d, %s(): output differs from last known (%d / %d) maxdiff %1.5f at ofs %d\n",__LINE__,__FUNCTION__, diff, (n), maxdiff, ofs);}}
 #define CHECK_BUF_GTE(x, y, n) tests++; { int i, lt = 0; for (i = 0; i < (n); i++) if (fabs((x)[i]) - fabs((y)[i]) < 0) lt = 1; if (lt) { errorcount++; printf("Error on line %d, %s(): buffer %s magnitude not bigger than buffer %s \n",__LINE__,__FUNCTION__,#x, #y);}}
+#define CHECKGOLDEN(name, x, n, tolerance) checkGolden((name), (x), (n), (tolerance), __LINE__, __FUNCTION__)
 #define CHECKLASTKNOWN(x, n) if (lastknownwrite && lastknownfile) { fwrite((x),1,(n)*sizeof(float),lastknownfile); } else if (lastknownfile) { fread(lastknownscratch,1,(n)*sizeof(float),lastknownfile); CHECK_BUF_SAME_LASTKNOWN((x), n); }
 
-#if defined(_MSC_VER)
-#include <windows.h>
-
-long getmsec()
-{
-	LARGE_INTEGER ts, freq;
-
-	QueryPerformanceCounter(&ts);
-	QueryPerformanceFrequency(&freq);
-	ts.QuadPart *= 1000;
-	ts.QuadPart /= freq.QuadPart;
-
-	return (long)ts.QuadPart;
-}
-#else
-#include <time.h>
-
-long getmsec()
-{
-	struct timespec ts;
-
-	clock_gettime(CLOCK_MONOTONIC, &ts);
-
-	return (ts->tv_sec * 1000) + (ts->tv_nsec / 1000000)
-}
-#endif
-
-
 void writeHeader()
 {
 	unsigned char buf[46] = {
@@ -172,6 +156,162 @@ void printinfo(const char * format, ...)
 	va_end(args);
 }
 
+// Golden renders are named reference buffers kept in golden.bin. Unlike
+// lastknown.wav the records are looked up by name, so scenes can be added
+// without invalidating the others. Missing records are added and the file
+// is rewritten at exit.
+#define MAX_GOLDEN 128
+
+struct GoldenRecord
+{
+	char mName[64];
+	int mCount;
+	float *mData;
+};
+
+GoldenRecord golden[MAX_GOLDEN];
+int goldencount = 0;
+int goldenactive = 0;
+int goldenwrite = 0;
+
+void loadGolden(const char *aFilename)
+{
+	goldenactive = 1;
+	FILE *f = fopen(aFilename, "rb");
+	if (!f)
+	{
+		printf("%s not found, writing one.\n", aFilename);
+		return;
+	}
+	char magic[4];
+	int count = 0;
+	if (fread(magic, 1, 4, f) != 4 || memcmp(magic, "SLGR", 4) != 0 || fread(&count, sizeof(int), 1, f) != 1)
+	{
+		printf("%s is not a golden file, rewriting it.\n", aFilename);
+		fclose(f);
+		goldenwrite = 1;
+		return;
+	}
+	while (count-- > 0 && goldencount < MAX_GOLDEN)
+	{
+		GoldenRecord &r = golden[goldencount];
+		if (fread(r.mName, 1, 64, f) != 64 || fread(&r.mCount, sizeof(int), 1, f) != 1 || r.mCount <= 0)
+			break;
+		r.mName[63] = 0;
+		r.mData = new float[r.mCount];
+		if (fread(r.mData, sizeof(float), r.mCount, f) != (size_t)r.mCount)
+		{
+			delete[] r.mData;
+			break;
+		}
+		goldencount++;
+	}
+	fclose(f);
+}
+
+void saveGolden(const char *aFilename)
+{
+	int i;
+	if (goldenactive && goldenwrite)
+	{
+		FILE *f = fopen(aFilename, "wb");
+		if (f)
+		{
+			fwrite("SLGR", 1, 4, f);
+			fwrite(&goldencount, sizeof(int), 1, f);
+			for (i = 0; i < goldencount; i++)
+			{
+				fwrite(golden[i].mName, 1, 64, f);
+				fwrite(&golden[i].mCount, sizeof(int), 1, f);
+				fwrite(golden[i].mData, sizeof(float), golden[i].mCount, f);
+			}
+			fclose(f);
+			printf("%s written.\n", aFilename);
+		}
+	}
+	for (i = 0; i < goldencount; i++)
+		delete[] golden[i].mData;
+	goldencount = 0;
+}
+
+void checkGolden(const char *aName, const float *aData, int aCount, float aTolerance, int aLine, const char *aFunction)
+{
+	if (!goldenactive)
+		return;
+	int i;
+	for (i = 0; i < goldencount; i++)
+		if (strcmp(golden[i].mName, aName) == 0)
+			break;
+	if (i == goldencount)
+	{
+		if (goldencount == MAX_GOLDEN)
+			return;
+		GoldenRecord &r = golden[goldencount++];
+		memset(r.mName, 0, 64);
+		strncpy(r.mName, aName, 63);
+		r.mCount = aCount;
+		r.mData = new float[aCount];
+		memcpy(r.mData, aData, sizeof(float) * aCount);
+		goldenwrite = 1;
+		return;
+	}
+	tests++;
+	const GoldenRecord &r = golden[i];
+	if (r.mCount != aCount)
+	{
+		errorcount++;
+		printf("Error on line %d, %s(): golden \"%s\" length differs (%d / %d)\n", aLine, aFunction, aName, aCount, r.mCount);
+		return;
+	}
+	int diff = 0, ofs = 0;
+	float maxdiff = 0.0f;
+	for (i = 0; i < aCount; i++)
+	{
+		float d = (float)fabs(aData[i] - r.mData[i]);
+		if (d > aTolerance)
+			diff++;
+		if (d > maxdiff)
+		{
+			maxdiff = d;
+			ofs = i;
+		}
+	}
+	if (diff)
+	{
+		errorcount++;
+		printf("Error on line %d, %s(): golden \"%s\" differs (%d / %d) maxdiff %1.7f at ofs %d, tolerance %1.7f\n", aLine, aFunction, aName, diff, aCount, maxdiff, ofs, aTolerance);
+	}
+}
+
+static SoLoud::MemorySink gRenderJobSink[4];
+
+SoLoud::result renderJob(SoLoud::Soloud &aSoloud, unsigned int aJob, void * /*aUserData*/)
+{
+	// Sources can't be shared between Soloud instances, so each job makes its own
+	SoLoud::Wav wav;
+	generateTestWave(wav);
+	aSoloud.play(wav);
+	return aSoloud.renderOffline(0.1f, gRenderJobSink[aJob]);
+}
+
+static volatile int gThreadRan = 0;
+
+void threadAttributeTest(void * /*aParam*/)
+{
+	gThreadRan = 1;
+}
+
+class CountTask : public SoLoud::Thread::PoolTask
+{
+public:
+	int mRuns;
+	CountTask() : mRuns(0) {}
+	virtual void work()
+	{
+		mRuns++;
+	}
+};
+
 // Some info tests
 //
 // Soloud.init
@@ -183,8 +323,17 @@ void printinfo(const char * format, ...)
 // Soloud.getBackendChannels
 // Soloud.getBackendSamplerate
 // Soloud.getBackendBufferSize
+// Soloud.getBackendXrunCount
 // Soloud.mix
+// Soloud.mixPlanar
 // Soloud.mixSigned16
+// Soloud.mixSigned24
+// Soloud.mixSigned32
+// Soloud.renderOffline
+// Soloud.stepVirtualClock
+// Soloud.getBackendJitterAverage
+// Soloud.getBackendJitterMax
+// renderOfflineParallel
 // Prg.rand
 // Prg.srand
 // wav.getLength
@@ -194,6 +343,7 @@ void testMisc()
 	short scratch_i16[2048];
 	SoLoud::result res;
 	SoLoud::Soloud soloud;
+	int a;
 	res = soloud.init(SoLoud::Soloud::CLIP_ROUNDOFF, SoLoud::Soloud::NULLDRIVER);
 	CHECK_RES(res);
 	SoLoud::Wav wav;
@@ -214,6 +364,7 @@ void testMisc()
 	CHECK(soloud.getBackendChannels() != 0);
 	CHECK(soloud.getBackendSamplerate() != 0);
 	CHECK(soloud.getBackendBufferSize() != 0);
+	CHECK(soloud.getBackendXrunCount() == 0);
 
 	soloud.mix(scratch, 1000);
 	soloud.mixSigned16(scratch_i16, 1000);
@@ -224,10 +375,276 @@ void testMisc()
 	soloud.mixSigned16(scratch_i16, 1000);
 	CHECK_BUF_NONZERO(scratch, 2000);
 	CHECK_BUF_NONZERO(scratch_i16, 2000);
+	soloud.stopAll();
+
+	{
+		// Integer outputs should match the float mix within quantization,
+		// including the odd sample count tail.
+		static int scratch_i32[2048];
+		static unsigned char scratch_i24[2048 * 3];
+		float maxdiff16 = 0, maxdiff24 = 0, maxdiff32 = 0, maxdither = 0;
+		soloud.play(wav);
+		soloud.mix(scratch, 1001);
+		soloud.stopAll();
+		soloud.play(wav);
+		soloud.mixSigned16(scratch_i16, 1001);
+		soloud.stopAll();
+		soloud.play(wav);
+		soloud.mixSigned24(scratch_i24, 1001);
+		soloud.stopAll();
+		soloud.play(wav);
+		soloud.mixSigned32(scratch_i32, 1001);
+		soloud.stopAll();
+		for (a = 0; a < 2002; a++)
+		{
+			int s24 = scratch_i24[a * 3] | (scratch_i24[a * 3 + 1] << 8) | ((signed char)scratch_i24[a * 3 + 2] << 16);
+			float d16 = (float)fabs(scratch[a] - scratch_i16[a] / (float)0x7fff);
+			float d24 = (float)fabs(scratch[a] - s24 / (float)0x7fffff);
+			float d32 = (float)fabs(scratch[a] - scratch_i32[a] / 2147483648.0f);
+			if (d16 > maxdiff16) maxdiff16 = d16;
+			if (d24 > maxdiff24) maxdiff24 = d24;
+			if (d32 > maxdiff32) maxdiff32 = d32;
+		}
+		CHECK(maxdiff16 < 1.0f / 0x7fff);
+		CHECK(maxdiff24 < 1.0f / 0x7fffff);
+		CHECK(maxdiff32 < 1.0f / 0x7fffff);
+
+		soloud.setGlobalVolume(0);
+		soloud.play(wav);
+		soloud.mixSigned16(scratch_i16, 1001);
+		CHECK_BUF_ZERO(scratch_i16, 2002);
+		soloud.setGlobalVolume(1);
+		soloud.stopAll();
+
+		soloud.deinit();
+		soloud.init(SoLoud::Soloud::CLIP_ROUNDOFF | SoLoud::Soloud::TPDF_DITHER, SoLoud::Soloud::NULLDRIVER);
+		soloud.play(wav);
+		soloud.mixSigned16(scratch_i16, 1001);
+		soloud.stopAll();
+		for (a = 0; a < 2002; a++)
+		{
+			float d = (float)fabs(scratch[a] - scratch_i16[a] / (float)0x7fff);
+			if (d > maxdither) maxdither = d;
+		}
+		CHECK(maxdither < 2.0f / 0x7fff);
+		soloud.setGlobalVolume(0);
+		soloud.play(wav);
+		soloud.mixSigned16(scratch_i16, 1001);
+		CHECK_BUF_NONZERO(scratch_i16, 2002);
+		soloud.setGlobalVolume(1);
+		soloud.stopAll();
+		soloud.deinit();
+		soloud.init(SoLoud::Soloud::CLIP_ROUNDOFF, SoLoud::Soloud::NULLDRIVER);
+	}
+
+	{
+		// Every clipper path the cpu supports should match the scalar reference bit for bit,
+		// for both clip curves, planar and interleaved output and a sample count with a tail.
+		static float src[6 * 1040], ref[6 * 1040], out[6 * 1040];
+		static const unsigned int chans[3] = { 1, 2, 6 };
+		SoLoud::Misc::Prg prg;
+		prg.srand(0x5eed);
+		for (a = 0; a < 6 * 1040; a++)
+			src[a] = (prg.rand() & 0xffff) / 10922.5f - 3.0f;
+		int path;
+		for (path = SoLoud::SIMD_SSE; path <= SoLoud::SIMD_NEON; path++)
+		{
+			if (!SoLoud::simd_path_supported(path))
+				continue;
+			printinfo("Clipper path %d\n", path);
+			int mismatch = 0;
+			int c, roundoff, interleave;
+			for (c = 0; c < 3; c++)
+			for (roundoff = 0; roundoff < 2; roundoff++)
+			for (interleave = 0; interleave < 2; interleave++)
+			{
+				memset(ref, 0, sizeof(ref));
+				memset(out, 0, sizeof(out));
+				SoLoud::clip_samples(SoLoud::SIMD_SCALAR, src, ref, 1037, chans[c], 1040, interleave != 0, roundoff != 0, 0.5f, 0.001f, 0.95f);
+				SoLoud::clip_samples(path, src, out, 1037, chans[c], 1040, interleave != 0, roundoff != 0, 0.5f, 0.001f, 0.95f);
+				if (memcmp(ref, out, sizeof(ref)) != 0)
+					mismatch++;
+			}
+			CHECK(mismatch == 0);
+		}
+
+		// Fused clip and interleave in mix() against the scalar path
+		float ref2[2000];
+		unsigned int defaultpath = soloud.mSimdPath;
+		soloud.mSimdPath = SoLoud::SIMD_SCALAR;
+		soloud.setGlobalVolume(2);
+		soloud.play(wav);
+		soloud.mix(ref2, 1000);
+		soloud.stopAll();
+		soloud.mSimdPath = defaultpath;
+		soloud.play(wav);
+		soloud.mix(scratch, 1000);
+		soloud.stopAll();
+		soloud.setGlobalVolume(1);
+		CHECK(memcmp(ref2, scratch, sizeof(ref2)) == 0);
+
+		// Planar output should be the interleaved output split by channel
+		float left[1000], right[1000];
+		float *planar[2] = { left, right };
+		soloud.setGlobalVolume(2);
+		soloud.play(wav);
+		soloud.mixPlanar(planar, 1000);
+		soloud.stopAll();
+		soloud.setGlobalVolume(1);
+		int planarmismatch = 0;
+		for (a = 0; a < 1000; a++)
+		{
+			if (left[a] != scratch[a * 2] || right[a] != scratch[a * 2 + 1])
+				planarmismatch++;
+		}
+		CHECK(planarmismatch == 0);
+	}
+
+	soloud.play(wav);
+	soloud.mix(scratch, 1000);
+	soloud.stopAll();
+	{
+		SoLoud::MemorySink sink;
+		soloud.play(wav);
+		res = soloud.renderOffline(1000.0f / 44100, sink);
+		CHECK_RES(res);
+		CHECK(sink.mSamples == 1000);
+		CHECK(sink.mChannels == 2);
+		CHECK_BUF_SAME(scratch, sink.mData, 2000);
+		soloud.stopAll();
+	}
+
+	CHECK(soloud.stepVirtualClock(0.1f) == SoLoud::NOT_IMPLEMENTED);
+	CHECK(soloud.getBackendJitterAverage() == 0);
+	CHECK(soloud.getBackendJitterMax() == 0);
+	{
+		// Virtual clock mixes whole buffers and carries the remainder over
+		SoLoud::Soloud vc;
+		res = vc.init(SoLoud::Soloud::CLIP_ROUNDOFF | SoLoud::Soloud::VIRTUAL_CLOCK, SoLoud::Soloud::NULLDRIVER, 44100, 512);
+		CHECK_RES(res);
+		SoLoud::Wav vcwav; // must die before vc
+		generateTestWave(vcwav);
+		SoLoud::handle h = vc.play(vcwav);
+		res = vc.stepVirtualClock(0.1f);
+		CHECK_RES(res);
+		CHECK(fabs(vc.getStreamTime(h) - 4096 / 44100.0) < 0.00001);
+		res = vc.stepVirtualClock(0.0075f);
+		CHECK_RES(res);
+		CHECK(fabs(vc.getStreamTime(h) - 4608 / 44100.0) < 0.00001);
+		CHECK(vc.stepVirtualClock(-1) == SoLoud::INVALID_PARAMETER);
+	}
+	{
+		// Config struct init matches the plain call and keeps the thread attributes
+		SoLoud::InitConfig config;
+		config.mBackend = SoLoud::Soloud::NULLDRIVER;
+		config.mSamplerate = 22050;
+		config.mBufferSize = 1024;
+		config.mMixerThread.mPriority = SoLoud::ThreadAttributes::PRIORITY_NORMAL;
+		config.mMixerThread.mStackSize = 256 * 1024;
+		SoLoud::Soloud ci;
+		res = ci.init(config);
+		CHECK_RES(res);
+		CHECK(ci.getBackendSamplerate() == 22050);
+		CHECK(ci.getBackendBufferSize() == 1024);
+		CHECK(ci.mMixerThreadAttributes.mStackSize == 256 * 1024);
+		res = ci.init(SoLoud::Soloud::CLIP_ROUNDOFF, SoLoud::Soloud::NULLDRIVER);
+		CHECK_RES(res);
+		CHECK(ci.mMixerThreadAttributes.mStackSize == 0);
+	}
+	{
+		// Requests the process may not be allowed (realtime, affinity) must not stop the thread
+		SoLoud::ThreadAttributes attributes;
+		attributes.mPriority = SoLoud::ThreadAttributes::PRIORITY_FIFO;
+		attributes.mAffinityMask = 1;
+		attributes.mStackSize = 128 * 1024;
+		attributes.mName = "soloud sanity test thread";
+		gThreadRan = 0;
+		SoLoud::Thread::ThreadHandle t = SoLoud::Thread::createThread(threadAttributeTest, 0, &attributes);
+		CHECK(t != 0);
+		if (t)
+		{
+			SoLoud::Thread::wait(t);
+			SoLoud::Thread::release(t);
+		}
+		CHECK(gThreadRan == 1);
+		// Realtime scheduling for the mixer is opt-in
+		SoLoud::ThreadAttributes mixer = SoLoud::Thread::mixerThreadAttributes(SoLoud::ThreadAttributes());
+		CHECK(mixer.mPriority == SoLoud::ThreadAttributes::PRIORITY_DEFAULT);
+		CHECK(mixer.mName != 0);
+		attributes.mPriority = SoLoud::ThreadAttributes::PRIORITY_FIFO;
+		mixer = SoLoud::Thread::mixerThreadAttributes(attributes);
+		CHECK(mixer.mPriority == SoLoud::ThreadAttributes::PRIORITY_FIFO);
+	}
+	{
+		// More tasks than the old fixed-size pool could hold, batched and one by one
+		const int taskCount = 3000;
+		CountTask *tasks = new CountTask[taskCount];
+		SoLoud::Thread::PoolTask **taskptr = new SoLoud::Thread::PoolTask*[taskCount];
+		for (a = 0; a < taskCount; a++)
+			taskptr[a] = &tasks[a];
+		SoLoud::Thread::Pool pool;
+		pool.init(4);
+		SoLoud::Thread::PoolGroup batch, single;
+		pool.addWork(taskptr, taskCount / 2, &batch);
+		for (a = taskCount / 2; a < taskCount; a++)
+			pool.addWork(taskptr[a], &single);
+		pool.wait(&batch);
+		CHECK(batch.mPending == 0);
+		int allran = 1;
+		for (a = 0; a < taskCount / 2; a++)
+			if (tasks[a].mRuns != 1)
+				allran = 0;
+		CHECK(allran);
+		pool.wait();
+		CHECK(single.mPending == 0);
+		CHECK(pool.mOutstanding == 0);
+		allran = 1;
+		for (a = 0; a < taskCount; a++)
+			if (tasks[a].mRuns != 1)
+				allran = 0;
+		CHECK(allran);
+
+		// Without threads the work is done right away
+		SoLoud::Thread::Pool inlinepool;
+		inlinepool.init(0);
+		inlinepool.addWork(taskptr, 10, &batch);
+		CHECK(tasks[9].mRuns == 2);
+		inlinepool.wait(&batch);
+		CHECK(inlinepool.getWork() == 0);
+
+		// getWork hands queued tasks to the caller to run
+		for (a = 0; a < taskCount; a++)
+			tasks[a].mRuns = 0;
+		pool.addWork(taskptr, taskCount, &batch);
+		SoLoud::Thread::PoolTask *task;
+		while ((task = pool.getWork()) != 0)
+			task->work();
+		pool.wait(&batch);
+		CHECK(batch.mPending == 0);
+		allran = 1;
+		for (a = 0; a < taskCount; a++)
+			if (tasks[a].mRuns != 1)
+				allran = 0;
+		CHECK(allran);
+		delete[] taskptr;
+		delete[] tasks;
+	}
+
+	res = SoLoud::renderOfflineParallel(4, renderJob, 0, 2);
+	CHECK_RES(res);
+	for (a = 0; a < 4; a++)
+	{
+		CHECK(gRenderJobSink[a].mSamples == 4410);
+	}
+	CHECK_BUF_NONZERO(gRenderJobSink[0].mData, 8820);
+	for (a = 1; a < 4; a++)
+	{
+		CHECK_BUF_SAME(gRenderJobSink[0].mData, gRenderJobSink[a].mData, 8820);
+	}
 
 	SoLoud::Misc::Prg prg;
 	prg.srand(0x1337);
-	int a = prg.rand();
+	a = prg.rand();
 	prg.srand(0x1337);
 	int b = prg.rand();
 	CHECK(a == b);
@@ -929,6 +1346,14 @@ void test3d()
 // Soloud.oscillateFilterParameter
 // Soloud.setGlobalFilter
 // WaveShaperFilter.setParams
+// LimiterFilter.setParams
+// MultibandCompressorFilter.setParams
+// MultibandCompressorFilter.setBandThresholds
+// Soloud.getFilterParameter
+// DuckFilter.setParams
+// Soloud.setFilterParameterSmoothing
+// Soloud.setFilterParameterClocked
+// Wav.setSharedFilters
 void testFilters()
 {
 	float scratch[2048];
@@ -947,6 +1372,12 @@ void testFilters()
 	SoLoud::FFTFilter fft;
 	SoLoud::RobotizeFilter rob;
 	SoLoud::WaveShaperFilter wshap;
+	SoLoud::LimiterFilter lim;
+	SoLoud::MultibandCompressorFilter mbc;
+	SoLoud::DuckFilter duck;
+	SoLoud::Bus bus;
+	SoLoud::Wav wav2;
+	generateTestWave(wav2);
 
 	res = soloud.init(SoLoud::Soloud::CLIP_ROUNDOFF, SoLoud::Soloud::NULLDRIVER);
 	CHECK_RES(res);
@@ -1100,6 +1531,191 @@ void testFilters()
 	soloud.stopAll();
 	wav.setFilter(0, 0);
 
+	int i;
+	float refpeak = 0, peak = 0;
+	CHECK(lim.setParams(1.0f) == SoLoud::INVALID_PARAMETER);
+	CHECK_RES(lim.setParams(-12.0f, 0.002f, 0.05f));
+	wav.setFilter(0, &lim);
+	h = soloud.play(wav);
+	soloud.mix(ref2, 1000);
+	CHECK_BUF_DIFF(ref, ref2, 2000);
+	CHECK(soloud.getFilterParameter(h, 0, SoLoud::LimiterFilter::GAINREDUCTION) > 0);
+	for (i = 0; i < 2000; i++)
+	{
+		if (fabs(ref[i]) > refpeak) refpeak = (float)fabs(ref[i]);
+		if (fabs(ref2[i]) > peak) peak = (float)fabs(ref2[i]);
+	}
+	CHECK(peak < refpeak);
+	soloud.stopAll();
+	wav.setFilter(0, 0);
+	soloud.setGlobalFilter(0, &lim);
+	soloud.play(wav);
+	soloud.mix(scratch, 1000);
+	CHECK_BUF_DIFF(ref, scratch, 2000);
+	CHECK(soloud.getFilterParameter(0, 0, SoLoud::LimiterFilter::GAINREDUCTION) > 0);
+	soloud.stopAll();
+	soloud.setGlobalFilter(0, 0);
+
+	CHECK(mbc.setParams(3000, 200, -20) == SoLoud::INVALID_PARAMETER);
+	CHECK(mbc.setParams(10, 3000, -20) == SoLoud::INVALID_PARAMETER);
+	CHECK(mbc.setParams(200, 20000, -20) == SoLoud::INVALID_PARAMETER);
+	CHECK(mbc.setParams(200, 3000, -20, 30) == SoLoud::INVALID_PARAMETER);
+	CHECK_RES(mbc.setParams(20, 16000, -20, 20));
+	CHECK_RES(mbc.setParams(200, 3000, -30, 8, 0.001f, 0.05f));
+	CHECK_RES(mbc.setBandThresholds(-30, -40, -50));
+	wav.setFilter(0, &mbc);
+	h = soloud.play(wav);
+	soloud.mix(ref2, 1000);
+	CHECK_BUF_DIFF(ref, ref2, 2000);
+	CHECK(soloud.getFilterParameter(h, 0, SoLoud::MultibandCompressorFilter::LOWGAINREDUCTION) > 0 ||
+		soloud.getFilterParameter(h, 0, SoLoud::MultibandCompressorFilter::MIDGAINREDUCTION) > 0 ||
+		soloud.getFilterParameter(h, 0, SoLoud::MultibandCompressorFilter::HIGHGAINREDUCTION) > 0);
+	soloud.stopAll();
+	wav.setFilter(0, 0);
+
+	// Duck wav2 by the level of a bus; the bus has no visualization enabled.
+	// The filter runs once per 512 source samples, so mix a couple of those.
+	h = soloud.play(bus);
+	bus.play(wav);
+	soloud.play(wav2);
+	for (i = 0; i < 4; i++)
+		soloud.mix(ref2, 1000);
+	soloud.stopAll();
+	h = soloud.play(bus);
+	CHECK(duck.setParams(&soloud, h + 1) == SoLoud::INVALID_PARAMETER);
+	CHECK_RES(duck.setParams(&soloud, h, 0, 0.5f, 0.1f));
+	wav2.setFilter(0, &duck);
+	bus.play(wav);
+	soloud.play(wav2);
+	for (i = 0; i < 4; i++)
+		soloud.mix(scratch, 1000);
+	CHECK_BUF_DIFF(ref2, scratch, 2000);
+	CHECK(bus.getApproximateVolume(0) == 0);
+	soloud.stopAll();
+	wav2.setFilter(0, 0);
+
+	lofi.setParams(4000, 5);
+	soloud.setGlobalFilter(0, &lofi);
+	soloud.setFilterParameterSmoothing(0, 0, SoLoud::LofiFilter::WET, SoLoud::Filter::LINEAR_SMOOTHING, 0.01f);
+	soloud.play(wav);
+	soloud.setFilterParameter(0, 0, SoLoud::LofiFilter::WET, 0);
+	soloud.mix(scratch, 100);
+	CHECK(soloud.getFilterParameter(0, 0, SoLoud::LofiFilter::WET) > 0);
+	CHECK(soloud.getFilterParameter(0, 0, SoLoud::LofiFilter::WET) < 1);
+	soloud.mix(scratch, 1000);
+	CHECK(soloud.getFilterParameter(0, 0, SoLoud::LofiFilter::WET) == 0);
+	soloud.stopAll();
+
+	soloud.setGlobalFilter(0, &lofi);
+	soloud.play(wav);
+	soloud.mix(ref2, 1000);
+	soloud.stopAll();
+	soloud.setGlobalFilter(0, &lofi);
+	soloud.play(wav);
+	soloud.setFilterParameterClocked(1.0f, 0, 0, SoLoud::LofiFilter::WET, 1);
+	soloud.setFilterParameterClocked(1.0f + 500.5f / 44100, 0, 0, SoLoud::LofiFilter::WET, 0);
+	soloud.mix(scratch, 1000);
+	CHECK_BUF_SAME(ref2, scratch, 1000);
+	CHECK_BUF_DIFF(ref2 + 1000, scratch + 1000, 1000);
+	CHECK(soloud.getFilterParameter(0, 0, SoLoud::LofiFilter::WET) == 0);
+	// Changes scheduled for the same sample apply in the order they were made
+	soloud.mix(scratch, 1000);
+	soloud.setFilterParameterClocked(3.0f, 0, 0, SoLoud::LofiFilter::WET, 0);
+	soloud.setFilterParameterClocked(3.0f + 100.5f / 44100, 0, 0, SoLoud::LofiFilter::WET, 0.25f);
+	soloud.setFilterParameterClocked(3.0f + 100.5f / 44100, 0, 0, SoLoud::LofiFilter::WET, 0.5f);
+	soloud.setFilterParameterClocked(3.0f + 100.5f / 44100, 0, 0, SoLoud::LofiFilter::WET, 0.75f);
+	soloud.mix(scratch, 1000);
+	CHECK(soloud.getFilterParameter(0, 0, SoLoud::LofiFilter::WET) == 0.75f);
+	soloud.stopAll();
+	soloud.setGlobalFilter(0, 0);
+
+	// On a voice, the change lands on the output sample even though the filter runs a block ahead
+	float dry[800];
+	float data[4000];
+	for (i = 0; i < 4000; i++)
+		data[i] = (float)sin(i * 0.05);
+	SoLoud::Wav wav44;
+	wav44.loadRawWave(data, 4000, 44100, 1, true, true);
+	soloud.play(wav44);
+	soloud.mix(scratch, 300);
+	soloud.mix(dry, 400);
+	soloud.stopAll();
+	wav44.setFilter(0, &lofi);
+	soloud.play(wav44);
+	soloud.mix(scratch, 300);
+	soloud.mix(ref2, 400);
+	soloud.stopAll();
+	h = soloud.play(wav44);
+	soloud.mix(scratch, 300);
+	soloud.setFilterParameterClocked(2.0f, h, 0, SoLoud::LofiFilter::WET, 1);
+	soloud.setFilterParameterClocked(2.0f + 250.5f / 44100, h, 0, SoLoud::LofiFilter::WET, 0);
+	soloud.mix(scratch, 400);
+	CHECK_BUF_SAME(ref2, scratch, 500);
+	CHECK_BUF_SAME(dry + 500, scratch + 500, 300);
+	CHECK_BUF_DIFF(ref2 + 500, scratch + 500, 300);
+	soloud.stopAll();
+
+	// Zero wet leaves the sound as is. Filters that opt in are bypassed; echo
+	// isn't, so its delay line holds the recent sound when the wet comes back up.
+	soloud.play(wav);
+	soloud.mix(ref2, 1000);
+	soloud.stopAll();
+	soloud.setGlobalFilter(0, &wshap);
+	soloud.setFilterParameter(0, 0, SoLoud::WaveShaperFilter::WET, 0);
+	soloud.play(wav);
+	soloud.mix(scratch, 1000);
+	CHECK_BUF_SAME(ref2, scratch, 2000);
+	soloud.stopAll();
+	soloud.setGlobalFilter(0, &echo);
+	soloud.setFilterParameter(0, 0, SoLoud::EchoFilter::WET, 0);
+	soloud.play(wav);
+	soloud.mix(scratch, 1000);
+	CHECK_BUF_SAME(ref2, scratch, 2000);
+	soloud.stopAll();
+	soloud.setFilterParameter(0, 0, SoLoud::EchoFilter::WET, 1);
+	soloud.mix(scratch, 1000);
+	CHECK_BUF_NONZERO(scratch, 2000);
+
+	// Echo keeps running on silent input while it has a tail, waveshaper is skipped
+	soloud.setGlobalFilter(0, &echo);
+	h = soloud.play(wav);
+	soloud.mix(scratch, 1000);
+	soloud.stop(h);
+	soloud.mix(scratch, 1000);
+	CHECK_BUF_NONZERO(scratch, 2000);
+	soloud.setGlobalFilter(0, &wshap);
+	soloud.mix(scratch, 1000);
+	CHECK_BUF_ZERO(scratch, 2000);
+	CHECK(soloud.mFilterInstance[0]->mFlushed);
+	soloud.setGlobalFilter(0, 0);
+
+	// Shared filters sound the same as the same filter on a bus
+	{
+		SoLoud::Bus fxbus;
+		fxbus.setFilter(0, &echo);
+		h = soloud.play(fxbus);
+		fxbus.play(wav);
+		fxbus.play(wav, 0.5f, 0.5f);
+		soloud.mix(ref2, 1000);
+		soloud.stopAll();
+	}
+	wav.setFilter(0, &echo);
+	wav.setSharedFilters(true);
+	soloud.play(wav);
+	soloud.play(wav, 0.5f, 0.5f);
+	CHECK(soloud.getVoiceCount() == 3);
+	CHECK(soloud.isValidVoiceHandle(wav.mSharedFilterHandle));
+	soloud.mix(scratch, 1000);
+	CHECK_BUF_SAME(ref2, scratch, 2000);
+	// The submix stops once the voices are gone and the echo has died out
+	wav.stop();
+	for (i = 0; i < 30; i++)
+		soloud.mix(scratch, 1000);
+	CHECK(soloud.getVoiceCount() == 0);
+	CHECK(!soloud.isValidVoiceHandle(wav.mSharedFilterHandle));
+	wav.setSharedFilters(false);
+	wav.setFilter(0, 0);
+
 	soloud.deinit();
 }
 
@@ -1345,6 +1961,708 @@ void testCore()
 	soloud.stopAll();
 	CHECK(soloud.countAudioSource(wav) == 0);
 
+	// Profiler: off by default, stage times add up to the frame total
+	SoLoud::ProfileStats stats;
+	soloud.getProfileStats(stats);
+	CHECK(stats.mFrames == 0);
+	soloud.setProfilingEnable(true);
+	SoLoud::Bus profbus;
+	SoLoud::handle bush = soloud.play(profbus);
+	h = profbus.play(wav);
+	soloud.setLooping(h, true);
+	CHECK(soloud.startCostTrace(1000) == SoLoud::SO_NO_ERROR);
+	for (i = 0; i < 20; i++)
+		soloud.mix(scratch, 1000);
+	soloud.setProfilingEnable(false);
+	soloud.mix(scratch, 1000);
+	soloud.getProfileStats(stats);
+	CHECK(stats.mFrames == 20);
+	CHECK(stats.mTotalFrames == 20);
+	CHECK(stats.mMaxVoicesMixed == 2);
+	CHECK(stats.mAverageTotalNanos > 0);
+	CHECK(stats.mAverageDutyCycle > 0);
+	SoLoud::ProfileFrame frames[5];
+	CHECK(soloud.getProfileFrames(frames, 5) == 5);
+	int stagesum = 1;
+	for (i = 0; i < 5; i++)
+	{
+		long long sum = 0;
+		int j;
+		for (j = 0; j < SoLoud::ProfileFrame::STAGE_COUNT; j++)
+			sum += frames[i].mStageNanos[j];
+		if (sum != frames[i].mTotalNanos || frames[i].mSamples != 1000)
+			stagesum = 0;
+	}
+	CHECK(stagesum);
+
+	// Per-source costs: the wav and the bus it plays on
+	SoLoud::SourceCost costs[4];
+	CHECK(soloud.getSourceCosts(costs, 4) == 2);
+	CHECK(costs[0].mNanos >= costs[1].mNanos);
+	CHECK(costs[0].mAudioSourceID == wav.mAudioSourceID || costs[1].mAudioSourceID == wav.mAudioSourceID);
+	CHECK(soloud.getSourceCost(wav) > 0);
+	CHECK(soloud.getSourceCosts(costs, 1) == 1);
+	CHECK(soloud.saveCostTrace("sanity_trace.json") == SoLoud::SO_NO_ERROR);
+	CHECK(soloud.saveCostTrace("sanity_trace.json") == SoLoud::INVALID_PARAMETER);
+	FILE *tracefile = fopen("sanity_trace.json", "rb");
+	CHECK(tracefile != 0);
+	if (tracefile)
+	{
+		char tracehead[16] = { 0 };
+		fread(tracehead, 1, 15, tracefile);
+		fclose(tracefile);
+		CHECK(strcmp(tracehead, "{\"traceEvents\":") == 0);
+		remove("sanity_trace.json");
+	}
+	soloud.resetSourceCosts();
+	CHECK(soloud.getSourceCosts(costs, 4) == 0);
+	soloud.stop(bush);
+	soloud.stopAll();
+
+	soloud.deinit();
+}
+
+// Test voice virtualization
+//
+// Soloud.getVirtualVoiceCount
+// Soloud.setMaxActiveVoiceCount
+// Wav.seek
+void testVirtual()
+{
+	float scratch[2048];
+	float ref[2048];
+	float data[4410];
+	SoLoud::result res;
+	SoLoud::Soloud soloud;
+	SoLoud::Wav wav, shortwav;
+	int i;
+	for (i = 0; i < 4410; i++)
+		data[i] = (float)(sin(i * 0.07) * 0.5 + sin(i * 0.013) * 0.3);
+	// Same rate as the output, so source and output samples line up exactly
+	wav.loadRawWave(data, 4410, 44100, 1, true, true);
+	wav.setLooping(true);
+	shortwav.loadRawWave(data, 441, 44100, 1, true, true);
+	res = soloud.init(SoLoud::Soloud::CLIP_ROUNDOFF, SoLoud::Soloud::NULLDRIVER, 44100, 2048, 2);
+	CHECK_RES(res);
+
+	// Reference: the quiet voice played alone
+	soloud.play(wav, 0.1f);
+	soloud.mix(ref, 1000);
+	soloud.mix(ref, 1000);
+	soloud.mix(ref, 1000);
+	soloud.stopAll();
+
+	// Two loud voices push the quiet one out of the active voices
+	CHECK_RES(soloud.setMaxActiveVoiceCount(2));
+	SoLoud::handle loud0 = soloud.play(wav, 1.0f);
+	SoLoud::handle loud1 = soloud.play(wav, 0.9f);
+	SoLoud::handle quiet = soloud.play(wav, 0.1f);
+	CHECK(soloud.getActiveVoiceCount() == 2);
+	CHECK(soloud.getVirtualVoiceCount() == 1);
+	soloud.mix(scratch, 1000);
+	CHECK(fabs(soloud.getStreamPosition(quiet) - 1000 / 44100.0) < 0.0001);
+
+	// Promoted voices pick up where they would have been
+	soloud.stop(loud0);
+	soloud.stop(loud1);
+	CHECK(soloud.getVirtualVoiceCount() == 0);
+	soloud.mix(scratch, 1000);
+	soloud.mix(scratch, 1000);
+	CHECK_BUF_SAME(ref, scratch, 2000);
+	soloud.stopAll();
+
+	// Virtual voices wrap their loops and end like mixed ones
+	soloud.play(wav, 1.0f);
+	soloud.play(wav, 1.0f);
+	quiet = soloud.play(wav, 0.1f);
+	SoLoud::handle quietshort = soloud.play(shortwav, 0.1f);
+	CHECK(soloud.getVirtualVoiceCount() == 2);
+	for (i = 0; i < 6; i++)
+		soloud.mix(scratch, 1000);
+	CHECK(soloud.isValidVoiceHandle(quietshort) == 0);
+	CHECK(soloud.isValidVoiceHandle(quiet) == 1);
+	CHECK(soloud.getLoopCount(quiet) == 1);
+	soloud.stopAll();
+
+	// Paused voices are not virtual
+	quiet = soloud.play(wav, 0.1f, 0, 1);
+	CHECK(soloud.getVirtualVoiceCount() == 0);
+	soloud.stopAll();
+
+	// Inaudible voices that tick keep time without being mixed
+	CHECK_RES(soloud.setMaxActiveVoiceCount(16));
+	wav.setInaudibleBehavior(true, false);
+	quiet = soloud.play3d(wav, 10, 20, 30, 0, 0, 0, 0.0f);
+	soloud.update3dAudio();
+	CHECK(soloud.getVirtualVoiceCount() == 1);
+	CHECK(soloud.getActiveVoiceCount() == 0);
+	soloud.mix(scratch, 1000);
+	CHECK(fabs(soloud.getStreamPosition(quiet) - 1000 / 44100.0) < 0.0001);
+	soloud.setVolume(quiet, 1.0f);
+	soloud.update3dAudio();
+	CHECK(soloud.getVirtualVoiceCount() == 0);
+	soloud.mix(scratch, 1000);
+	CHECK_BUF_NONZERO(scratch, 2000);
+	soloud.stopAll();
+
+	soloud.deinit();
+}
+
+// Test per-voice level metering
+//
+// AudioSource.setMetering
+// Soloud.setMetering
+// Soloud.getVoiceMeter
+
+void testMetering()
+{
+	float scratch[2048];
+	float data[4410];
+	SoLoud::result res;
+	SoLoud::Soloud soloud;
+	SoLoud::Wav wav;
+	SoLoud::Bus bus;
+	SoLoud::VoiceMeter meter, meter2;
+	int i;
+	for (i = 0; i < 4410; i++)
+		data[i] = (float)(sin(i * 0.07) * 0.5);
+	wav.loadRawWave(data, 4410, 44100, 1, true, true);
+	wav.setLooping(true);
+	res = soloud.init(SoLoud::Soloud::CLIP_ROUNDOFF, SoLoud::Soloud::NULLDRIVER, 44100, 2048, 2);
+	CHECK_RES(res);
+
+	// Unmetered voices have no meter
+	SoLoud::handle h = soloud.play(wav);
+	soloud.mix(scratch, 1000);
+	CHECK(soloud.getVoiceMeter(h, meter) == SoLoud::INVALID_PARAMETER);
+	CHECK(soloud.getVoiceMeter(0, meter) == SoLoud::INVALID_PARAMETER);
+
+	// A full-scale sine peaks at its amplitude, RMS is lower
+	soloud.setMetering(h, true);
+	for (i = 0; i < 10; i++)
+		soloud.mix(scratch, 1000);
+	CHECK_RES(soloud.getVoiceMeter(h, meter));
+	CHECK(meter.mChannels == 1);
+	CHECK(meter.mPeak[0] > 0.45f && meter.mPeak[0] <= 0.5f);
+	CHECK(meter.mRMS[0] > 0.2f && meter.mRMS[0] < meter.mPeak[0]);
+
+	// Levels follow the voice volume
+	soloud.setVolume(h, 0.25f);
+	for (i = 0; i < 100; i++)
+		soloud.mix(scratch, 1000);
+	CHECK_RES(soloud.getVoiceMeter(h, meter2));
+	CHECK(meter2.mPeak[0] < meter.mPeak[0] * 0.5f);
+	CHECK(meter2.mRMS[0] < meter.mRMS[0] * 0.5f);
+
+	// Disabling or stopping drops the meter
+	soloud.setMetering(h, false);
+	CHECK(soloud.getVoiceMeter(h, meter) == SoLoud::INVALID_PARAMETER);
+	soloud.setMetering(h, true);
+	soloud.mix(scratch, 1000);
+	CHECK_RES(soloud.getVoiceMeter(h, meter));
+	soloud.stop(h);
+	CHECK(soloud.getVoiceMeter(h, meter) == SoLoud::INVALID_PARAMETER);
+
+	// Metering set on the source applies to new voices, and buses meter their mix
+	wav.setMetering(true);
+	bus.setMetering(true);
+	SoLoud::handle bh = soloud.play(bus);
+	h = bus.play(wav);
+	for (i = 0; i < 10; i++)
+		soloud.mix(scratch, 1000);
+	CHECK_RES(soloud.getVoiceMeter(h, meter));
+	CHECK_RES(soloud.getVoiceMeter(bh, meter2));
+	CHECK(meter2.mChannels == 2);
+	CHECK(meter2.mPeak[0] > 0.2f);
+	CHECK(meter2.mRMS[1] > 0.1f);
+	soloud.stopAll();
+
+	soloud.deinit();
+}
+
+// Test aux sends
+//
+// AudioSource.setSend
+// Bus.setSend
+
+void testSends()
+{
+	float direct[8192];
+	float sent[8192];
+	float data[4410];
+	SoLoud::Soloud soloud;
+	SoLoud::Wav wav;
+	SoLoud::Bus dry, reverb;
+	int i;
+	for (i = 0; i < 4410; i++)
+		data[i] = (float)(sin(i * 0.07) * 0.5);
+	wav.loadRawWave(data, 4410, 44100, 1, true, true);
+	wav.setLooping(true);
+	CHECK_RES(soloud.init(0, SoLoud::Soloud::NULLDRIVER, 44100, 2048, 2));
+
+	// Reference: the sound played straight on the return bus
+	soloud.play(reverb);
+	reverb.play(wav);
+	for (i = 0; i < 8; i++)
+		soloud.mix(direct + i * 1024, 512);
+	soloud.stopAll();
+
+	// Sending from a muted dry bus gives the same signal, delayed and without panning
+	soloud.play(reverb);
+	soloud.play(dry, 0);
+	SoLoud::handle h = dry.play(wav);
+	CHECK_RES(reverb.setSend(h, 1));
+	for (i = 0; i < 8; i++)
+		soloud.mix(sent + i * 1024, 512);
+	int delay = 0, start = 0;
+	while (delay < 4096 && sent[delay * 2] == 0)
+		delay++;
+	while (start < 4096 && direct[start * 2] == 0)
+		start++;
+	delay -= start;
+	CHECK(delay > 0 && delay < 4096);
+	// Skip the first block, where the volume ramps differ
+	float err = 0;
+	for (i = 512; i < 4096 - delay; i++)
+	{
+		float d = (float)fabs(sent[(i + delay) * 2] - direct[i * 2] / (float)sqrt(0.5f));
+		if (d > err)
+			err = d;
+	}
+	CHECK(err < 0.001f);
+
+	// Removing the send fades it out
+	CHECK_RES(reverb.setSend(h, 0));
+	for (i = 0; i < 16; i++)
+		soloud.mix(sent, 512);
+	CHECK_BUF_ZERO(sent, 1024);
+	soloud.stopAll();
+
+	// Sends set on the source apply to new instances
+	CHECK_RES(wav.setSend(reverb, 0.5f));
+	soloud.play(reverb);
+	soloud.play(dry, 0);
+	dry.play(wav);
+	for (i = 0; i < 8; i++)
+		soloud.mix(sent + i * 1024, 512);
+	CHECK_BUF_NONZERO(sent + 6 * 1024, 1024);
+	soloud.stopAll();
+	CHECK_RES(wav.setSend(reverb, 0));
+	soloud.deinit();
+
+	// A 48kHz voice sending to a 44.1kHz bus stays smooth across block edges
+	SoLoud::Wav wav48;
+	float data48[4800];
+	for (i = 0; i < 4800; i++)
+		data48[i] = (float)(sin(i * 0.0576) * 0.25);
+	wav48.loadRawWave(data48, 4800, 48000, 1, true, true);
+	wav48.setLooping(true);
+	CHECK_RES(soloud.init(0, SoLoud::Soloud::NULLDRIVER, 48000, 2048, 2));
+	soloud.play(reverb);
+	h = soloud.play(wav48);
+	CHECK_RES(reverb.setSend(h, 1));
+	for (i = 0; i < 8; i++)
+		soloud.mix(sent + i * 1024, 512);
+	// The sum of the direct and sent sines; a dropped or repeated frame shows up as a kink
+	err = 0;
+	for (i = 2048; i < 4095; i++)
+	{
+		float d = (float)fabs(sent[(i + 1) * 2] - 2 * sent[i * 2] + sent[(i - 1) * 2]);
+		if (d > err)
+			err = d;
+	}
+	CHECK(err < 0.005f);
+	soloud.deinit();
+}
+
+// Test queue
+//
+// Queue.play
+// Queue.pushSamples
+// Queue.getQueueCount
+// Queue.isCurrentlyPlaying
+// Queue.setParams
+// Queue.setQueueSize
+
+void testQueue()
+{
+	float ref[4096];
+	float scratch[4096];
+	float data[4000];
+	SoLoud::Soloud soloud;
+	SoLoud::Wav wav;
+	SoLoud::Queue queue;
+	int i;
+	for (i = 0; i < 4000; i++)
+		data[i] = (float)(sin(i * 0.07) * 0.5);
+	wav.loadRawWave(data, 4000, 44100, 1, true, true);
+	CHECK_RES(soloud.init(SoLoud::Soloud::CLIP_ROUNDOFF, SoLoud::Soloud::NULLDRIVER, 44100, 2048, 2));
+	CHECK_RES(queue.setParams(44100, 1));
+
+	// Pushed samples play exactly like the same samples in a wav
+	soloud.play(wav);
+	for (i = 0; i < 4; i++)
+		soloud.mix(ref + i * 1024, 512);
+	soloud.stopAll();
+
+	CHECK(queue.pushSamples(data, 100) == SoLoud::INVALID_PARAMETER);
+	SoLoud::handle h = soloud.play(queue);
+	CHECK_RES(queue.pushSamples(data, 300));
+	CHECK_RES(queue.pushSamples(data + 300, 700));
+	CHECK_RES(queue.pushSamples(data + 1000, 1048));
+	CHECK(queue.getQueueCount() == 3);
+	for (i = 0; i < 4; i++)
+		soloud.mix(scratch + i * 1024, 512);
+	CHECK_BUF_SAME(ref, scratch, 4096);
+	CHECK(queue.getQueueCount() == 0);
+
+	// A sample feed keeps going over gaps
+	soloud.mix(scratch, 512);
+	soloud.mix(scratch, 512);
+	CHECK_BUF_ZERO(scratch, 1024);
+	CHECK(soloud.isValidVoiceHandle(h) == 1);
+	CHECK_RES(queue.pushSamples(data, 512));
+	soloud.mix(scratch, 512);
+	CHECK_BUF_NONZERO(scratch, 1024);
+
+	// Sounds and samples play in order
+	CHECK_RES(queue.play(wav));
+	CHECK_RES(queue.pushSamples(data, 512));
+	soloud.mix(scratch, 2048);
+	CHECK(queue.isCurrentlyPlaying(wav) == true);
+	CHECK(queue.getQueueCount() == 2);
+	soloud.mix(scratch, 2048);
+	soloud.mix(scratch, 2048);
+	CHECK(queue.isCurrentlyPlaying(wav) == false);
+	CHECK(queue.getQueueCount() == 0);
+
+	// Limits
+	CHECK(queue.setQueueSize(0) == SoLoud::INVALID_PARAMETER);
+	CHECK_RES(queue.setQueueSize(2, 1024));
+	CHECK_RES(queue.pushSamples(data, 1000));
+	CHECK(queue.pushSamples(data, 100) == SoLoud::OUT_OF_MEMORY);
+	CHECK_RES(queue.pushSamples(data, 24));
+	CHECK(queue.play(wav) == SoLoud::OUT_OF_MEMORY);
+	CHECK(queue.setQueueSize(4) == SoLoud::INVALID_PARAMETER);
+	soloud.mix(scratch, 2048);
+	CHECK(queue.getQueueCount() == 0);
+	CHECK_RES(queue.pushSamples(data, 1000));
+	soloud.stopAll();
+
+	// Channels only change while nothing is playing or queued, and the sample buffer follows
+	SoLoud::Queue queue2;
+	CHECK_RES(queue2.setParams(44100, 1));
+	soloud.play(queue2);
+	CHECK_RES(queue2.pushSamples(data, 1000));
+	CHECK(queue2.setParams(44100, 2) == SoLoud::INVALID_PARAMETER);
+	soloud.mix(scratch, 2048);
+	soloud.stopAll();
+	CHECK(queue2.getQueueCount() == 0);
+	CHECK_RES(queue2.setParams(44100, 2));
+	soloud.play(queue2);
+	for (i = 0; i < 1024; i++)
+	{
+		ref[i * 2] = data[i];
+		ref[i * 2 + 1] = 0;
+	}
+	CHECK_RES(queue2.pushSamples(ref, 1024));
+	soloud.mix(scratch, 1024);
+	float right = 0, left = 0;
+	for (i = 0; i < 1024; i++)
+	{
+		left += (float)fabs(scratch[i * 2]);
+		right += (float)fabs(scratch[i * 2 + 1]);
+	}
+	CHECK(left > 1);
+	CHECK(right == 0);
+	soloud.stopAll();
+
+	soloud.deinit();
+}
+
+// Test pcm stream
+//
+// PcmStream.write
+// PcmStream.setParams
+// PcmStream.setLatency
+// PcmStream.getBufferedSamples
+// PcmStream.getUnderrunCount
+// PcmStream.getCurrentLatency
+void testPcmStream()
+{
+	float scratch[1024];
+	float data[4096];
+	SoLoud::Soloud soloud;
+	SoLoud::PcmStream stream;
+	int i, j;
+	for (i = 0; i < 4096; i++)
+		data[i] = (float)(sin(i * 0.07) * 0.5);
+	CHECK_RES(soloud.init(0, SoLoud::Soloud::NULLDRIVER, 44100, 2048, 2));
+	CHECK(stream.setParams(44100, 0) == SoLoud::INVALID_PARAMETER);
+	CHECK(stream.setLatency(0.05, 0.02) == SoLoud::INVALID_PARAMETER);
+	CHECK_RES(stream.setParams(44100, 1));
+
+	// A steady feed plays without gaps
+	SoLoud::handle h = soloud.play(stream);
+	CHECK(stream.setParams(22050, 1) == SoLoud::INVALID_PARAMETER);
+	for (i = 0; i < 200; i++)
+	{
+		CHECK_RES(stream.write(data + (i * 512) % 3072, 512));
+		soloud.mix(scratch, 512);
+	}
+	CHECK_BUF_NONZERO(scratch, 1024);
+	CHECK(stream.getUnderrunCount() == 0);
+	CHECK(fabs(stream.getCurrentLatency() - 0.02) < 0.001);
+
+	// Running dry fades out to silence and raises the latency
+	for (i = 0; i < 20; i++)
+		soloud.mix(scratch, 512);
+	CHECK_BUF_ZERO(scratch, 1024);
+	CHECK(stream.getUnderrunCount() == 1);
+	CHECK(stream.getCurrentLatency() > 0.025);
+	CHECK(soloud.isValidVoiceHandle(h) == 1);
+
+	// and picks up again once the buffer has filled
+	CHECK_RES(stream.write(data, 4096));
+	soloud.mix(scratch, 512);
+	CHECK_BUF_NONZERO(scratch, 1024);
+	soloud.stopAll();
+
+	// The buffer only takes what fits
+	CHECK(stream.setBufferSize(0.04) == SoLoud::INVALID_PARAMETER);
+	CHECK_RES(stream.setLatency(0.01));
+	CHECK_RES(stream.setBufferSize(0.04));
+	CHECK(stream.write(data, 4096) == SoLoud::OUT_OF_MEMORY);
+	CHECK_RES(stream.write(data, 2048));
+	CHECK(stream.getBufferedSamples() == 2048);
+
+	// A producer running slightly fast is absorbed by playing faster
+	CHECK_RES(stream.setBufferSize(1));
+	CHECK_RES(stream.setLatency(0.02));
+	soloud.play(stream);
+	for (i = 0, j = 0; i < 2000; i++)
+	{
+		if (stream.write(data, 513) != SoLoud::SO_NO_ERROR)
+			j++;
+		soloud.mix(scratch, 512);
+	}
+	CHECK(j == 0);
+	CHECK(stream.getUnderrunCount() == 1);
+	CHECK(stream.getBufferedSamples() < 0.04 * 44100);
+	soloud.stopAll();
+
+	soloud.deinit();
+}
+
+// Test capture
+//
+// AudioInput
+// Soloud.capture
+// Soloud.setCaptureStandIn
+// Soloud.getCaptureChannels
+void testCapture()
+{
+	float scratch[4096];
+	float data[4096];
+	SoLoud::Soloud soloud;
+	SoLoud::AudioInput input;
+	SoLoud::Wav wav;
+	int i, j, diff;
+	// The linear resampler adds a frame of its own
+	const int lag = SAMPLE_GRANULARITY + 1;
+	for (i = 0; i < 4096; i++)
+		data[i] = (float)(sin(i * 0.07) * 0.5);
+	CHECK(soloud.setCaptureStandIn(&wav) == SoLoud::INVALID_PARAMETER);
+	CHECK_RES(soloud.init(0, SoLoud::Soloud::NULLDRIVER, 44100, 2048, 2));
+	CHECK(soloud.getCaptureChannels() == 0);
+	soloud.deinit();
+
+	CHECK_RES(soloud.init(SoLoud::Soloud::ENABLE_CAPTURE, SoLoud::Soloud::NULLDRIVER, 44100, 2048, 2));
+	CHECK(soloud.getCaptureChannels() == 1);
+
+	// Input captured in a cycle plays a fixed SAMPLE_GRANULARITY frames later, whatever the buffer size
+	float gain = 0;
+	soloud.play(input);
+	for (j = 0; j < 2; j++)
+	{
+		unsigned int block = j ? 256 : 512;
+		diff = 0;
+		for (i = 0; i < 4096; i += block)
+		{
+			soloud.capture(data + i, block);
+			soloud.mix(scratch, block);
+			if (i == 1024)
+				gain = scratch[0] / data[i - lag];
+			unsigned int k;
+			for (k = 0; i >= 1024 && k < block; k++)
+				if (fabs(scratch[k * 2] - data[i + k - lag] * gain) > 0.00001)
+					diff++;
+		}
+		CHECK(diff == 0);
+		CHECK(gain > 0.5f);
+		soloud.stopAll();
+		soloud.play(input);
+	}
+
+	// A stand-in source feeds the input instead, and device input is ignored meanwhile
+	wav.loadRawWave(data, 4096, 44100, 1, true, true);
+	CHECK_RES(soloud.setCaptureStandIn(&wav));
+	soloud.stopAll();
+	soloud.play(input);
+	diff = 0;
+	for (i = 0; i < 4096; i += 512)
+	{
+		soloud.capture(scratch, 512);
+		soloud.mix(scratch, 512);
+		unsigned int k;
+		for (k = 0; i >= 1024 && k < 512; k++)
+			if (fabs(scratch[k * 2] - data[i + k - lag] * gain) > 0.00001)
+				diff++;
+	}
+	CHECK(diff == 0);
+
+	// Once the stand-in has ended, the input goes quiet
+	for (i = 0; i < 4; i++)
+		soloud.mix(scratch, 512);
+	CHECK_BUF_ZERO(scratch, 1024);
+	CHECK_RES(soloud.setCaptureStandIn(0));
+	soloud.capture(data, 512);
+	soloud.mix(scratch, 512);
+	soloud.capture(data, 512);
+	soloud.mix(scratch, 512);
+	CHECK_BUF_NONZERO(scratch, 1024);
+	soloud.stopAll();
+
+	soloud.deinit();
+}
+
+// Test voice limits and stealing
+//
+// AudioSource.setPriority
+// AudioSource.setCategory
+// AudioSource.setInstanceLimit
+// Soloud.setCategoryLimit
+// Soloud.countCategory
+void testVoiceLimits()
+{
+	float scratch[2048];
+	float ref[2048];
+	float data[4410];
+	float silence[441];
+	SoLoud::result res;
+	SoLoud::Soloud soloud;
+	SoLoud::Wav wav, wav2, quietwav;
+	int i;
+	for (i = 0; i < 4410; i++)
+		data[i] = (float)(sin(i * 0.07) * 0.5);
+	for (i = 0; i < 441; i++)
+		silence[i] = 0;
+	wav.loadRawWave(data, 4410, 44100, 1, true, true);
+	wav.setLooping(true);
+	wav2.loadRawWave(data, 4410, 44100, 1, true, true);
+	wav2.setLooping(true);
+	quietwav.loadRawWave(silence, 441, 44100, 1, true, true);
+	quietwav.setLooping(true);
+	res = soloud.init(SoLoud::Soloud::CLIP_ROUNDOFF, SoLoud::Soloud::NULLDRIVER, 44100, 2048, 2);
+	CHECK_RES(res);
+
+	// Instance limit, rejecting
+	wav.setInstanceLimit(2, false);
+	CHECK(soloud.play(wav) != 0);
+	CHECK(soloud.play(wav) != 0);
+	CHECK(soloud.play(wav) == 0);
+	CHECK(soloud.countAudioSource(wav) == 2);
+	soloud.stopAll();
+
+	// Instance limit, stealing the quietest
+	wav.setInstanceLimit(2, true);
+	SoLoud::handle h0 = soloud.play(wav, 0.5f);
+	SoLoud::handle h1 = soloud.play(wav, 0.2f);
+	SoLoud::handle h2 = soloud.play(wav, 0.9f);
+	CHECK(h2 != 0);
+	CHECK(soloud.isValidVoiceHandle(h0) == 1);
+	CHECK(soloud.isValidVoiceHandle(h1) == 0);
+	CHECK(soloud.countAudioSource(wav) == 2);
+	soloud.stopAll();
+	wav.setInstanceLimit(0);
+
+	// Category limits count all sources in the category
+	CHECK(wav.setCategory(VOICE_CATEGORY_COUNT) == SoLoud::INVALID_PARAMETER);
+	CHECK(soloud.setCategoryLimit(0, 2) == SoLoud::INVALID_PARAMETER);
+	CHECK_RES(wav.setCategory(3));
+	CHECK_RES(wav2.setCategory(3));
+	CHECK_RES(soloud.setCategoryLimit(3, 2, false));
+	soloud.play(wav);
+	soloud.play(wav2);
+	CHECK(soloud.play(wav2) == 0);
+	CHECK(soloud.countCategory(3) == 2);
+	CHECK(soloud.play(quietwav) != 0);
+	CHECK_RES(soloud.setCategoryLimit(3, 2, true));
+	CHECK(soloud.play(wav2) != 0);
+	CHECK(soloud.countCategory(3) == 2);
+	soloud.stopAll();
+
+	// A full category only makes room by stealing from sounds that aren't more important
+	CHECK_RES(soloud.setCategoryLimit(3, 1, true));
+	wav.setPriority(5);
+	h0 = soloud.play(wav);
+	CHECK(soloud.play(wav2) == 0);
+	CHECK(soloud.isValidVoiceHandle(h0) == 1);
+	wav2.setPriority(5);
+	CHECK(soloud.play(wav2) != 0);
+	CHECK(soloud.isValidVoiceHandle(h0) == 0);
+	soloud.stopAll();
+
+	// A sound rejected by its category doesn't stop its own instances on the way
+	wav2.setPriority(0);
+	wav2.setInstanceLimit(1, true);
+	CHECK_RES(soloud.setCategoryLimit(3, 0));
+	h0 = soloud.play(wav);
+	soloud.play(wav);
+	h1 = soloud.play(wav2);
+	CHECK_RES(soloud.setCategoryLimit(3, 2, true));
+	CHECK(soloud.play(wav2) == 0);
+	CHECK(soloud.isValidVoiceHandle(h1) == 1);
+	CHECK(soloud.countAudioSource(wav) == 2);
+	soloud.stopAll();
+	wav2.setInstanceLimit(0);
+	wav.setPriority(0);
+	wav2.setPriority(0);
+	CHECK_RES(soloud.setCategoryLimit(3, 0));
+	wav.setCategory(0);
+	wav2.setCategory(0);
+
+	// Priority wins over loudness when picking the active voices: the silent
+	// high priority voice takes one of the two slots
+	soloud.play(wav);
+	soloud.mix(ref, 1000);
+	soloud.mix(ref, 1000);
+	soloud.stopAll();
+	CHECK_RES(soloud.setMaxActiveVoiceCount(2));
+	quietwav.setPriority(5);
+	soloud.play(wav);
+	soloud.play(wav2);
+	soloud.play(quietwav, 0.1f);
+	soloud.mix(scratch, 1000);
+	soloud.mix(scratch, 1000);
+	CHECK_BUF_SAME(ref, scratch, 2000);
+	CHECK(soloud.getVirtualVoiceCount() == 1);
+	soloud.stopAll();
+	CHECK_RES(soloud.setMaxActiveVoiceCount(16));
+
+	// When all voices are in use, new sounds steal the weakest voice, and are
+	// rejected if only more important voices are left
+	wav.setPriority(1);
+	for (i = 0; i < VOICE_COUNT; i++)
+		soloud.play(wav, i == 100 ? 0.01f : 1.0f);
+	CHECK(soloud.getVoiceCount() == VOICE_COUNT);
+	wav2.setPriority(0);
+	CHECK(soloud.play(wav2) == SoLoud::UNKNOWN_ERROR);
+	wav2.setPriority(1);
+	h0 = soloud.play(wav2);
+	CHECK(soloud.isValidVoiceHandle(h0) == 1);
+	CHECK(soloud.countAudioSource(wav) == VOICE_COUNT - 1);
+	soloud.stopAll();
 
 	soloud.deinit();
 }
@@ -1438,6 +2756,168 @@ void testSpeech()
 	soloud.deinit();
 }
 
+// Golden renders of the benchmark scenarios, each resampler, each filter and
+// each speaker layout, checked against golden.bin with per-scene tolerances.
+// Benchmark scenarios are timed alongside; the times are only informative.
+#define GOLDEN_BLOCKS 8
+#define GOLDEN_FRAMES 4096
+
+static void renderFilterGolden(const char *aName, SoLoud::Filter *aFilter, bool aGlobal, float aTolerance)
+{
+	float scratch[GOLDEN_FRAMES * 2];
+	SoLoud::Soloud soloud;
+	SoLoud::Wav wav;
+	soloud.init(SoLoud::Soloud::CLIP_ROUNDOFF, SoLoud::Soloud::NULLDRIVER, 44100, 2048, 2);
+	generateTestWave(wav);
+	wav.setLooping(true);
+	if (aGlobal)
+		soloud.setGlobalFilter(0, aFilter);
+	else
+		wav.setFilter(0, aFilter);
+	soloud.play(wav, 0.8f, -0.25f);
+	soloud.mix(scratch, GOLDEN_FRAMES);
+	CHECKGOLDEN(aName, scratch, GOLDEN_FRAMES * 2, aTolerance);
+	soloud.stopAll();
+	soloud.setGlobalFilter(0, 0);
+}
+
+void testGolden()
+{
+	float *buf = new float[GOLDEN_BLOCKS * BENCH_BLOCK * MAX_CHANNELS];
+	char name[80];
+	int i;
+
+	initScenarioData();
+	Scenario scenario[32];
+	int count = buildScenarios(scenario, 32, 0, 0);
+	for (i = 0; i < count; i++)
+	{
+		ScenarioPlayer *player = new ScenarioPlayer;
+		tests++;
+		if (!player->init(scenario[i]))
+		{
+			errorcount++;
+			printf("Error on line %d, %s(): scenario %s failed to set up\n", __LINE__, __FUNCTION__, scenario[i].mName);
+			delete player;
+			continue;
+		}
+		unsigned int frame = BENCH_BLOCK * scenario[i].mChannels;
+		long long start = SoLoud::Thread::getTimeNanos();
+		int b;
+		for (b = 0; b < GOLDEN_BLOCKS; b++)
+			player->mix(buf + b * frame);
+		long long elapsed = SoLoud::Thread::getTimeNanos() - start;
+		delete player;
+		printinfo("%-24s %9.2f ns/sample\n", scenario[i].mName, (double)elapsed / (GOLDEN_BLOCKS * BENCH_BLOCK));
+		// Recursive filters amplify rounding differences between compilers
+		float tolerance = scenario[i].mFilters ? 0.0001f : 0.00001f;
+		snprintf(name, sizeof(name), "bench_%.64s", scenario[i].mName);
+		CHECKGOLDEN(name, buf, GOLDEN_BLOCKS * frame, tolerance);
+	}
+	freeScenarioData();
+
+	// The clipper must not depend on the simd path; render loud enough to clip
+	{
+		float ref[GOLDEN_FRAMES * 2];
+		float scratch[GOLDEN_FRAMES * 2];
+		SoLoud::Soloud soloud;
+		SoLoud::Wav wav;
+		CHECK_RES(soloud.init(SoLoud::Soloud::CLIP_ROUNDOFF, SoLoud::Soloud::NULLDRIVER, 44100, 2048, 2));
+		generateTestWave(wav);
+		wav.setLooping(true);
+		unsigned int path = soloud.mSimdPath;
+		soloud.setGlobalVolume(4);
+		soloud.play(wav);
+		soloud.mix(ref, GOLDEN_FRAMES);
+		soloud.stopAll();
+		soloud.mSimdPath = SoLoud::SIMD_SCALAR;
+		soloud.play(wav);
+		soloud.mix(scratch, GOLDEN_FRAMES);
+		soloud.stopAll();
+		soloud.mSimdPath = path;
+		CHECK_BUF_SAME(ref, scratch, GOLDEN_FRAMES * 2);
+		CHECKGOLDEN("clip_roundoff", ref, GOLDEN_FRAMES * 2, 0.00001f);
+	}
+
+	// Each resampler, upsampling the 8khz test wave with a pitch change
+	for (i = 0; i < 3; i++)
+	{
+		float scratch[GOLDEN_FRAMES * 2];
+		SoLoud::Soloud soloud;
+		SoLoud::Wav wav;
+		CHECK_RES(soloud.init(SoLoud::Soloud::CLIP_ROUNDOFF, SoLoud::Soloud::NULLDRIVER, 44100, 2048, 2));
+		generateTestWave(wav);
+		wav.setLooping(true);
+		soloud.setMainResampler(i);
+		int h = soloud.play(wav);
+		soloud.setRelativePlaySpeed(h, 1.37f);
+		soloud.mix(scratch, GOLDEN_FRAMES);
+		sprintf(name, "resampler_%s", gResamplerName[i]);
+		CHECKGOLDEN(name, scratch, GOLDEN_FRAMES * 2, 0.00001f);
+		soloud.stopAll();
+	}
+
+	// Each filter as a voice filter, plus the level-dependent ones as global filters
+	{
+		SoLoud::BassboostFilter bassboost;
+		SoLoud::BiquadResonantFilter lowpass, highpass, bandpass;
+		SoLoud::DCRemovalFilter dcremoval;
+		SoLoud::EchoFilter echo;
+		SoLoud::FlangerFilter flanger;
+		SoLoud::LofiFilter lofi;
+		SoLoud::RobotizeFilter robotize;
+		SoLoud::WaveShaperFilter waveshaper;
+		SoLoud::LimiterFilter limiter;
+		SoLoud::MultibandCompressorFilter compressor;
+		bassboost.setParams(8);
+		lowpass.setParams(SoLoud::BiquadResonantFilter::LOWPASS, 1000, 4);
+		highpass.setParams(SoLoud::BiquadResonantFilter::HIGHPASS, 1000, 4);
+		bandpass.setParams(SoLoud::BiquadResonantFilter::BANDPASS, 1000, 4);
+		dcremoval.setParams(0.05f);
+		echo.setParams(0.02f, 0.6f, 0.5f);
+		flanger.setParams(0.005f, 10);
+		lofi.setParams(4000, 6);
+		robotize.setParams(30, 0);
+		waveshaper.setParams(0.5f);
+		limiter.setParams(-12, 0.002f, 0.05f);
+		compressor.setParams(200, 3000, -30, 8, 0.001f, 0.05f);
+		renderFilterGolden("filter_bassboost", &bassboost, false, 0.0001f);
+		renderFilterGolden("filter_lowpass", &lowpass, false, 0.0001f);
+		renderFilterGolden("filter_highpass", &highpass, false, 0.0001f);
+		renderFilterGolden("filter_bandpass", &bandpass, false, 0.0001f);
+		renderFilterGolden("filter_dcremoval", &dcremoval, false, 0.0001f);
+		renderFilterGolden("filter_echo", &echo, false, 0.0001f);
+		renderFilterGolden("filter_flanger", &flanger, false, 0.0001f);
+		// Quantizers can flip a step on tiny input differences
+		renderFilterGolden("filter_lofi", &lofi, false, 0.02f);
+		renderFilterGolden("filter_robotize", &robotize, false, 0.0001f);
+		renderFilterGolden("filter_waveshaper", &waveshaper, false, 0.0001f);
+		renderFilterGolden("filter_limiter", &limiter, true, 0.0001f);
+		renderFilterGolden("filter_compressor", &compressor, true, 0.0001f);
+	}
+
+	// 3d panning through each speaker layout
+	static const unsigned int channels[] = { 1, 2, 4, 6, 8 };
+	for (i = 0; i < (int)(sizeof(channels) / sizeof(channels[0])); i++)
+	{
+		SoLoud::Soloud soloud;
+		SoLoud::Wav wav;
+		CHECK_RES(soloud.init(SoLoud::Soloud::CLIP_ROUNDOFF, SoLoud::Soloud::NULLDRIVER, 44100, 2048, channels[i]));
+		generateTestWave(wav);
+		wav.setLooping(true);
+		soloud.play3d(wav, 5, 0, 5);
+		soloud.play3d(wav, -8, 2, -3, 0, 0, 0, 0.5f);
+		soloud.play(wav, 0.25f);
+		soloud.update3dAudio();
+		soloud.mix(buf, GOLDEN_FRAMES);
+		sprintf(name, "layout_%u", channels[i]);
+		CHECKGOLDEN(name, buf, GOLDEN_FRAMES * channels[i], 0.00001f);
+		soloud.stopAll();
+	}
+
+	delete[] buf;
+}
+
 void testMixer()
 {
 	SoLoud::Soloud soloud;
@@ -1489,46 +2969,6 @@ void testMixer()
 // avg 0.474, med 0.479 +- 0.029 (0.465 - 0.494)
 // avg 0.470, med 0.474 +- 0.033 (0.457 - 0.490)
 
-void testSpeedThings()
-{
-	float scratch[2048];
-	SoLoud::result res;
-	SoLoud::Soloud soloud;
-	SoLoud::Wav wav;
-	res = soloud.init(SoLoud::Soloud::CLIP_ROUNDOFF, SoLoud::Soloud::NULLDRIVER);
-	CHECK_RES(res);
-	int j;
-	generateTestWave(wav);
-	int k;
-	long t = 0, c = 0, mn = 1000000, mx = 0;
-	long fst = getmsec();
-	for (k = 0; k < 100; k++)
-	{
-		long st = getmsec();
-		for (j = 0; j < 500; j++)
-		{
-			int i;
-			for (i = 0; i < 10; i++)
-			{
-				soloud.play(wav);
-			}
-			for (i = 0; i < 20; i++)
-				soloud.mix(scratch, 1000);
-		}
-		long et = getmsec();
-		c++;
-		long d = et - st;
-		t += d;
-		if (mn > d) mn = d;
-		if (mx < d) mx = d;
-
-		printf("Mix loop took %3.3f sec, avg %3.3f, med %3.3f +- %3.3f (%3.3f - %3.3f)\n", (et - st) / 1000.0f, t / (c * 1000.0f), (mn+mx) / 2000.0f, (mx-mn) / 1000.0f, mn / 1000.0f, mx / 1000.0f);
-	}
-	long fet = getmsec();
-	printf("Total %3.3f sec\n", (fet - fst) / 1000.0f);
-	soloud.deinit();
-}
-
 int main(int parc, char ** pars)
 {
 #ifndef NO_LASTKNOWN_CHECK
@@ -1547,6 +2987,7 @@ int main(int parc, char ** pars)
 			fgetc(lastknownfile);
 	}
 	writeHeader();
+	loadGolden("golden.bin");
 #endif
 
 	testMisc();
@@ -1556,12 +2997,19 @@ int main(int parc, char ** pars)
 	test3d();
 	testFilters();
 	testCore();
+	testVirtual();
+	testVoiceLimits();
+	testMetering();
+	testSends();
+	testQueue();
+	testPcmStream();
+	testCapture();
 	testSpeech();
-	testSpeedThings();
+	testGolden();
 //	testMixer();
 	printf("\n%d tests, %d error(s) ", tests, errorcount);
 	if (!lastknownwrite && errorcount)
-		printf("(To rebuild lastknown.wav, simply delete it)\n");
+		printf("(To rebuild lastknown.wav and golden.bin, simply delete them)\n");
 	printf("\n");
 #ifndef NO_LASTKNOWN_CHECK
 	writeHeader();
@@ -1569,6 +3017,7 @@ int main(int parc, char ** pars)
 		fclose(lastknownfile);
 	if (lastknownfile && lastknownwrite)
 		printf("lastknown.wav written.\n");
+	saveGolden("golden.bin");
 #endif
 	return 0;
 }
@@ -1578,7 +3027,6 @@ TODO:
 ----
 SoLoud::Monotone
 SoLoud::Openmpt
-SoLoud::Queue
 SoLoud::WavStream
 SoLoud::Vizsn
 SoLoud::Vic